@@ -44,14 +44,33 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <mutex>
 #include "AAFilter.h"
 #include "FIRFilter.h"
+#include "IIRFilter.h"
 
 using namespace soundtouch;
 
 #define PI        3.141592655357989
 #define TWOPI    (2 * PI)
 
+// Cut-off frequency is quantized to steps of 1/AA_CUTOFF_STEPS of the sampling 
+// frequency for the kernel cache. That's 21.5Hz steps at 44.1kHz, which is small
+// compared to the transition band width of the filter.
+#define AA_CUTOFF_STEPS     2048
+
+// Order of the IIR filter. 8th order Butterworth attenuates 48dB per octave 
+// above the cut-off frequency, taking 4 biquad sections.
+#define AA_IIR_ORDER        8
+
+// Upper limit for the IIR filter cut-off frequency. The bilinear transform 
+// squeezes the response towards the nyquist frequency, so the filter can't
+// reach all the way up to it.
+#define AA_IIR_MAX_CUTOFF   0.45
+
+// Number of filter kernels kept in the cache
+#define AA_CACHE_SIZE       64
+
 // define this to save AA filter coefficients to a file
 // #define _DEBUG_SAVE_AAFILTER_COEFFICIENTS   1
 
@@ -76,6 +95,146 @@ using namespace soundtouch;
 #endif
 
 
+/*****************************************************************************
+ *
+ * Cache of the designed filter kernels. The cache is shared by all AAFilter
+ * instances of the process, so that changing the cut-off frequency back and 
+ * forth, e.g. with pitch automation, or running several SoundTouch instances 
+ * with same settings, needn't redesign the same filters. The least recently
+ * used kernel gets replaced when the cache is full.
+ *
+ *****************************************************************************/
+
+namespace soundtouch
+{
+
+class AAFilterCache
+{
+protected:
+    struct Entry
+    {
+        uint length;            ///< Number of filter taps, 0 = unused entry
+        int cutoff;             ///< Quantized cut-off frequency
+        uint lastUse;           ///< Value of 'useCount' at the latest use
+        SAMPLETYPE *coeffs;     ///< Filter coefficients
+    };
+
+    Entry entries[AA_CACHE_SIZE];
+    uint useCount;
+    std::mutex mutex;
+
+public:
+    AAFilterCache();
+    ~AAFilterCache();
+
+    /// Copies the kernel of the given cut-off & length to 'coeffs' if found
+    /// in the cache. Returns false if not found.
+    bool get(int cutoff, uint length, SAMPLETYPE *coeffs);
+
+    /// Stores the kernel of the given cut-off & length to the cache
+    void put(int cutoff, uint length, const SAMPLETYPE *coeffs);
+
+    /// Returns the process-wide cache instance
+    static AAFilterCache &getInstance();
+
+private:
+    static std::once_flag instanceFlag;
+    static AAFilterCache *pInstance;
+
+    static void createInstance();
+};
+
+}
+
+
+// The VS2013 compiler doesn't make the initialization of local statics 
+// thread-safe, so the instance gets created with 'std::call_once'. The flag 
+// and the pointer are zero-initialized before any code runs, so they're valid 
+// also for AAFilter objects created by static initializers. The instance is 
+// never deleted, so that it also remains usable in static destructors.
+std::once_flag AAFilterCache::instanceFlag;
+AAFilterCache *AAFilterCache::pInstance = NULL;
+
+
+AAFilterCache::AAFilterCache()
+{
+    memset(entries, 0, sizeof(entries));
+    useCount = 0;
+}
+
+
+AAFilterCache::~AAFilterCache()
+{
+    for (int i = 0; i < AA_CACHE_SIZE; i ++)
+    {
+        delete[] entries[i].coeffs;
+    }
+}
+
+
+void AAFilterCache::createInstance()
+{
+    pInstance = new AAFilterCache;
+}
+
+
+AAFilterCache &AAFilterCache::getInstance()
+{
+    std::call_once(instanceFlag, createInstance);
+
+    return *pInstance;
+}
+
+
+bool AAFilterCache::get(int cutoff, uint length, SAMPLETYPE *coeffs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (int i = 0; i < AA_CACHE_SIZE; i ++)
+    {
+        Entry &entry = entries[i];
+        if ((entry.length == length) && (entry.cutoff == cutoff))
+        {
+            entry.lastUse = ++ useCount;
+            memcpy(coeffs, entry.coeffs, length * sizeof(SAMPLETYPE));
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void AAFilterCache::put(int cutoff, uint length, const SAMPLETYPE *coeffs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    int i, oldest;
+
+    // find the least recently used entry. Another thread may have stored the 
+    // same kernel meanwhile, then replace that one.
+    oldest = 0;
+    for (i = 0; i < AA_CACHE_SIZE; i ++)
+    {
+        if ((entries[i].length == length) && (entries[i].cutoff == cutoff))
+        {
+            oldest = i;
+            break;
+        }
+        if (entries[i].lastUse < entries[oldest].lastUse) oldest = i;
+    }
+
+    Entry &entry = entries[oldest];
+    if (entry.length != length)
+    {
+        delete[] entry.coeffs;
+        entry.coeffs = new SAMPLETYPE[length];
+        entry.length = length;
+    }
+    entry.cutoff = cutoff;
+    entry.lastUse = ++ useCount;
+    memcpy(entry.coeffs, coeffs, length * sizeof(SAMPLETYPE));
+}
+
+
 /*****************************************************************************
  *
  * Implementation of the class 'AAFilter'
@@ -84,7 +243,10 @@ using namespace soundtouch;
 
 AAFilter::AAFilter(uint len)
 {
-    pFIR = FIRFilter::newInstance();
+    pFIR = NULL;
+    pIIR = NULL;
+    type = FIR;
+    pCoeffs = NULL;
     cutoffFreq = 0.5;
     setLength(len);
 }
@@ -94,6 +256,8 @@ AAFilter::AAFilter(uint len)
 AAFilter::~AAFilter()
 {
     delete pFIR;
+    delete pIIR;
+    delete[] pCoeffs;
 }
 
 
@@ -103,8 +267,14 @@ AAFilter::~AAFilter()
 // The filter will cut frequencies higher than the given frequency.
 void AAFilter::setCutoffFreq(double newCutoffFreq)
 {
-    cutoffFreq = newCutoffFreq;
+    double quantized;
+
+    quantized = floor(newCutoffFreq * AA_CUTOFF_STEPS + 0.5) / AA_CUTOFF_STEPS;
+    if (quantized == cutoffFreq) return;    // no change
+
+    cutoffFreq = quantized;
     calculateCoeffs();
+    if (pIIR) designIIR();
 }
 
 
@@ -112,21 +282,87 @@ void AAFilter::setCutoffFreq(double newCutoffFreq)
 // Sets number of FIR filter taps
 void AAFilter::setLength(uint newLength)
 {
+    if ((pFIR != NULL) && (newLength == length)) return;    // no change
+
     length = newLength;
+    // filter implementation depends on the length
+    delete pFIR;
+    pFIR = FIRFilter::newInstance(length);
+    delete[] pCoeffs;
+    pCoeffs = new SAMPLETYPE[length];
     calculateCoeffs();
 }
 
 
 
-// Calculates coefficients for a low-pass FIR filter using Hamming window
+// Selects the filter type. The IIR filter gets created & designed at first use.
+void AAFilter::setType(TYPE newType)
+{
+    assert((newType == FIR) || (newType == IIR));
+
+    type = newType;
+    if ((type == IIR) && (pIIR == NULL))
+    {
+        pIIR = IIRFilter::newInstance();
+        designIIR();
+    }
+}
+
+
+AAFilter::TYPE AAFilter::getType() const
+{
+    return type;
+}
+
+
+void AAFilter::clear()
+{
+    if (pIIR) pIIR->clear();
+}
+
+
+// Designs the IIR filter for the current cut-off frequency. The design takes 
+// only few trigonometric function calls, so it isn't cached.
+void AAFilter::designIIR()
+{
+    double cutoff;
+
+    cutoff = cutoffFreq;
+    if (cutoff > AA_IIR_MAX_CUTOFF) cutoff = AA_IIR_MAX_CUTOFF;
+    if (cutoff < 1.0 / AA_CUTOFF_STEPS) cutoff = 1.0 / AA_CUTOFF_STEPS;
+    pIIR->setLowpass(cutoff, AA_IIR_ORDER);
+}
+
+
+
+// Gets the filter coefficients from the cache, or designs them if not found. 
+// Doesn't allocate memory when found in the cache.
 void AAFilter::calculateCoeffs()
+{
+    AAFilterCache &cache = AAFilterCache::getInstance();
+    int cutoff;
+
+    cutoff = (int)(cutoffFreq * AA_CUTOFF_STEPS + 0.5);
+    if (cache.get(cutoff, length, pCoeffs) == false)
+    {
+        designCoeffs(pCoeffs);
+        cache.put(cutoff, length, pCoeffs);
+    }
+
+    // Set coefficients. Use divide factor 14 => divide result by 2^14 = 16384
+    pFIR->setCoefficients(pCoeffs, length, 14);
+}
+
+
+
+// Calculates coefficients for a low-pass FIR filter using Hamming window
+void AAFilter::designCoeffs(SAMPLETYPE *coeffs) const
 {
     uint i;
     double cntTemp, temp, tempCoeff,h, w;
     double wc;
     double scaleCoeff, sum;
     double *work;
-    SAMPLETYPE *coeffs;
 
     assert(length >= 2);
     assert(length % 4 == 0);
@@ -134,7 +370,6 @@ void AAFilter::calculateCoeffs()
     assert(cutoffFreq <= 0.5);
 
     work = new double[length];
-    coeffs = new SAMPLETYPE[length];
 
     wc = 2.0 * PI * cutoffFreq;
     tempCoeff = TWOPI / (double)length;
@@ -186,13 +421,9 @@ void AAFilter::calculateCoeffs()
         coeffs[i] = (SAMPLETYPE)temp;
     }
 
-    // Set coefficients. Use divide factor 14 => divide result by 2^14 = 16384
-    pFIR->setCoefficients(coeffs, length, 14);
-
     _DEBUG_SAVE_AAFIR_COEFFS(coeffs, length);
 
     delete[] work;
-    delete[] coeffs;
 }
 
 
@@ -201,6 +432,10 @@ void AAFilter::calculateCoeffs()
 // smaller than the amount of input samples.
 uint AAFilter::evaluate(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels) const
 {
+    if (type == IIR)
+    {
+        return pIIR->evaluate(dest, src, numSamples, numChannels);
+    }
     return pFIR->evaluate(dest, src, numSamples, numChannels);
 }
 
@@ -222,7 +457,7 @@ uint AAFilter::evaluate(FIFOSampleBuffer &dest, FIFOSampleBuffer &src) const
     numSrcSamples = src.numSamples();
     psrc = src.ptrBegin();
     pdest = dest.ptrEnd(numSrcSamples);
-    result = pFIR->evaluate(pdest, psrc, numSrcSamples, numChannels);
+    result = evaluate(pdest, psrc, numSrcSamples, numChannels);
     src.receiveSamples(result);
     dest.putSamples(result);
 
@@ -52,17 +52,42 @@ namespace soundtouch
 
 class AAFilter
 {
+public:
+    /// Filter types: linear-phase FIR filter, or low-latency IIR filter with 
+    /// cascaded biquad sections
+    enum TYPE
+    {
+        FIR = 0,
+        IIR = 1
+    };
+
 protected:
     class FIRFilter *pFIR;
 
+    /// IIR filter, created when the IIR type gets first selected
+    class IIRFilter *pIIR;
+
+    /// Selected filter type
+    TYPE type;
+
     /// Low-pass filter cut-off frequency, negative = invalid
     double cutoffFreq;
 
     /// num of filter taps
     uint length;
 
-    /// Calculate the FIR coefficients realizing the given cutoff-frequency
+    /// Work buffer for the filter coefficients, 'length' items
+    SAMPLETYPE *pCoeffs;
+
+    /// Get the FIR coefficients realizing the given cutoff-frequency from the
+    /// kernel cache, or design them if not found in the cache
     void calculateCoeffs();
+
+    /// Design the FIR coefficients realizing the given cutoff-frequency
+    void designCoeffs(SAMPLETYPE *coeffs) const;
+
+    /// Design the IIR filter realizing the given cutoff-frequency
+    void designIIR();
 public:
     AAFilter(uint length);
 
@@ -70,17 +95,29 @@ public:
 
     /// Sets new anti-alias filter cut-off edge frequency, scaled to sampling 
     /// frequency (nyquist frequency = 0.5). The filter will cut off the 
-    /// frequencies than that.
+    /// frequencies than that. The frequency gets quantized to small steps so 
+    /// that the designed filters can be reused from a cache.
     void setCutoffFreq(double newCutoffFreq);
 
-    /// Sets number of FIR filter taps, i.e. ~filter complexity
+    /// Sets number of FIR filter taps, i.e. ~filter complexity. Has no effect 
+    /// on the IIR filter, which has a fixed order.
     void setLength(uint newLength);
 
     uint getLength() const;
 
+    /// Selects the filter type, see 'TYPE'. The IIR filter has lower latency and
+    /// needs fewer multiplications than the FIR filter, but it isn't linear-phase.
+    void setType(TYPE newType);
+
+    TYPE getType() const;
+
+    /// Clears the IIR filter state. The FIR filter has no state of its own.
+    void clear();
+
     /// Applies the filter to the given sequence of samples. 
-    /// Note : The amount of outputted samples is by value of 'filter length' 
-    /// smaller than the amount of input samples.
+    /// Note : With the FIR filter the amount of outputted samples is by value
+    /// of 'filter length' smaller than the amount of input samples. The IIR
+    /// filter outputs as many samples as are input.
     uint evaluate(SAMPLETYPE *dest, 
                   const SAMPLETYPE *src, 
                   uint numSamples, 
@@ -88,8 +125,8 @@ public:
 
     /// Applies the filter to the given src & dest pipes, so that processed amount of
     /// samples get removed from src, and produced amount added to dest 
-    /// Note : The amount of outputted samples is by value of 'filter length' 
-    /// smaller than the amount of input samples.
+    /// Note : With the FIR filter the amount of outputted samples is by value
+    /// of 'filter length' smaller than the amount of input samples.
     uint evaluate(FIFOSampleBuffer &dest, 
                   FIFOSampleBuffer &src) const;
 
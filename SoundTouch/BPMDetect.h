@@ -59,6 +59,7 @@
 
 #include "STTypes.h"
 #include "FIFOSampleBuffer.h"
+#include "OnsetDetector.h"
 
 namespace soundtouch
 {
@@ -77,11 +78,8 @@ protected:
     /// Auto-correlation accumulator bins.
     float *xcorr;
     
-    /// Amplitude envelope sliding average approximation level accumulator
-    double envelopeAccu;
-
-    /// RMS volume sliding average approximation level accumulator
-    double RMSVolumeAccu;
+    /// Amplitude envelope follower for the decimated samples
+    soundtouch::AmplitudeEnvelope envelope;
 
     /// Sample average counter.
     int decimateCount;
@@ -122,12 +120,6 @@ protected:
                  int numsamples                     ///< Number of source samples.
                  );
 
-    /// Calculates amplitude envelope for the buffer of samples.
-    /// Result is output to 'samples'.
-    void calcEnvelope(soundtouch::SAMPLETYPE *samples,  ///< Pointer to input/output data buffer
-                      int numsamples                    ///< Number of samples in buffer
-                      );
-
     /// remove constant bias from xcorr data
     void removeBias();
 
@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Radix-2 complex Fast Fourier Transform with precomputed twiddle factor and
+/// bit-reversal tables.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include "FFT.h"
+
+using namespace soundtouch;
+
+#define PI        3.141592653589793
+
+
+FFT::FFT()
+{
+    size = 0;
+    twiddle = NULL;
+    bitrev = NULL;
+}
+
+
+FFT::~FFT()
+{
+    delete[] twiddle;
+    delete[] bitrev;
+}
+
+
+// Returns smallest power of two that is equal or larger than 'value'
+uint FFT::nextPow2(uint value)
+{
+    uint res = 1;
+
+    while (res < value) res <<= 1;
+    return res;
+}
+
+
+// Sets transform length & precalculates the twiddle and bit-reversal tables
+void FFT::setSize(uint newSize)
+{
+    uint i, j, bits;
+
+    assert(newSize >= 2);
+    assert((newSize & (newSize - 1)) == 0);
+    if (newSize == size) return;
+
+    size = newSize;
+
+    delete[] twiddle;
+    delete[] bitrev;
+    twiddle = new double[size];
+    bitrev = new uint[size];
+
+    for (i = 0; i < size / 2; i ++)
+    {
+        double w = 2.0 * PI * (double)i / (double)size;
+        twiddle[2 * i] = cos(w);
+        twiddle[2 * i + 1] = sin(w);
+    }
+
+    bits = 0;
+    while ((1U << bits) < size) bits ++;
+
+    for (i = 0; i < size; i ++)
+    {
+        uint rev = 0;
+        for (j = 0; j < bits; j ++)
+        {
+            rev |= ((i >> j) & 1) << (bits - 1 - j);
+        }
+        bitrev[i] = rev;
+    }
+}
+
+
+uint FFT::getSize() const
+{
+    return size;
+}
+
+
+// Iterative decimation-in-time radix-2 transform
+void FFT::transform(double *data, int sign) const
+{
+    uint i, len;
+
+    assert(size > 0);
+    assert(data != NULL);
+
+    // reorder data into bit-reversed order
+    for (i = 0; i < size; i ++)
+    {
+        uint j = bitrev[i];
+        if (j > i)
+        {
+            double tr = data[2 * i];
+            double ti = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = tr;
+            data[2 * j + 1] = ti;
+        }
+    }
+
+    // butterflies
+    for (len = 2; len <= size; len <<= 1)
+    {
+        uint half = len >> 1;
+        uint tstep = size / len;
+
+        for (i = 0; i < size; i += len)
+        {
+            double *p1 = data + 2 * i;
+            double *p2 = p1 + 2 * half;
+            uint k;
+
+            for (k = 0; k < half; k ++)
+            {
+                double wr = twiddle[2 * k * tstep];
+                double wi = sign * twiddle[2 * k * tstep + 1];
+                double tr = p2[2 * k] * wr - p2[2 * k + 1] * wi;
+                double ti = p2[2 * k] * wi + p2[2 * k + 1] * wr;
+
+                p2[2 * k]     = p1[2 * k] - tr;
+                p2[2 * k + 1] = p1[2 * k + 1] - ti;
+                p1[2 * k]     += tr;
+                p1[2 * k + 1] += ti;
+            }
+        }
+    }
+}
+
+
+void FFT::forward(double *data) const
+{
+    transform(data, -1);
+}
+
+
+void FFT::inverse(double *data) const
+{
+    transform(data, 1);
+}
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Radix-2 complex Fast Fourier Transform with precomputed twiddle factor and
+/// bit-reversal tables. Used for fast correlation / convolution routines that
+/// would otherwise need O(n^2) direct-form computation.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _FFT_H_
+#define _FFT_H_
+
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+/// Complex FFT of power-of-two length. Data is given as interleaved
+/// (real, imag) double pairs and transformed in-place.
+class FFT
+{
+protected:
+    /// Transform length in complex items
+    uint size;
+
+    /// Twiddle factors cos(2*pi*k/size), sin(2*pi*k/size) interleaved, k < size/2
+    double *twiddle;
+
+    /// Bit-reversal permutation table
+    uint *bitrev;
+
+    /// In-place transform, 'sign' = -1 for forward and +1 for inverse direction
+    void transform(double *data, int sign) const;
+
+public:
+    FFT();
+    ~FFT();
+
+    /// Sets transform length. 'newSize' must be power of two. Tables are
+    /// recalculated only if the length changes.
+    void setSize(uint newSize);
+
+    /// Returns transform length in complex items
+    uint getSize() const;
+
+    /// Forward transform of 'size' complex items in 'data'
+    void forward(double *data) const;
+
+    /// Inverse transform of 'size' complex items in 'data'. Notice that the
+    /// result isn't scaled by 1/size.
+    void inverse(double *data) const;
+
+    /// Returns smallest power of two that is equal or larger than 'value'
+    static uint nextPow2(uint value);
+};
+
+}
+
+#endif // _FFT_H_
@@ -9,6 +9,13 @@
 /// outputted samples from the buffer, as well as grows the buffer size 
 /// whenever necessary.
 ///
+/// Where the operating system allows, the buffer memory is mapped twice to 
+/// consecutive virtual addresses, so that the buffer works as a ring whose 
+/// contents are always accessible as one contiguous block, and the samples
+/// never need to be moved within the buffer. Otherwise the buffer is allocated
+/// from heap, and the samples get moved to the beginning of the buffer when 
+/// new samples are added.
+///
 /// Author        : Copyright (c) Olli Parviainen
 /// Author e-mail : oparviai 'at' iki.fi
 /// SoundTouch WWW: http://www.surina.net/soundtouch
@@ -50,8 +57,88 @@
 
 #include "FIFOSampleBuffer.h"
 
+#if defined(__linux__)
+    #include <unistd.h>
+    #include <sys/mman.h>
+
+    #ifdef MFD_CLOEXEC
+        // 'memfd_create' is available for creating the mirrored buffers
+        #define SOUNDTOUCH_MIRRORED_BUFFER  1
+    #endif
+#endif
+
 using namespace soundtouch;
 
+
+#ifdef SOUNDTOUCH_MIRRORED_BUFFER
+
+// Returns the virtual memory page size
+static uint getPageSize()
+{
+    // initialization of a local static is thread-safe
+    static const uint pageSize = (uint)sysconf(_SC_PAGESIZE);
+
+    return pageSize;
+}
+
+
+// Allocates 'size' bytes of memory that is mapped twice to consecutive virtual
+// addresses, i.e. byte 'n' of the returned block is also seen at 'n + size'. 
+// The 'size' must be a multiple of the page size. Returns NULL if the operating
+// system can't provide such mapping.
+static void *allocMirrored(uint size)
+{
+    char *addr;
+    int fd;
+
+    fd = memfd_create("FIFOSampleBuffer", MFD_CLOEXEC);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, size) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // reserve address space for both images, then map the memory over it twice
+    addr = (char *)mmap(NULL, 2 * (size_t)size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr != MAP_FAILED)
+    {
+        if ((mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) ||
+            (mmap(addr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED))
+        {
+            munmap(addr, 2 * (size_t)size);
+            addr = (char *)MAP_FAILED;
+        }
+#ifdef MADV_DONTFORK
+        else
+        {
+            // the shared mappings wouldn't be copy-on-write in a child process
+            // created with 'fork', so that the child and the parent would see 
+            // each other's writes. Leave the buffer out of the child instead.
+            madvise(addr, 2 * (size_t)size, MADV_DONTFORK);
+        }
+#endif // MADV_DONTFORK
+    }
+
+    // the mappings keep the memory alive without the file descriptor
+    close(fd);
+    return (addr != MAP_FAILED) ? addr : NULL;
+}
+
+
+// Releases memory allocated with 'allocMirrored'
+static void freeMirrored(void *ptr, uint size)
+{
+    munmap(ptr, 2 * (size_t)size);
+}
+
+#endif // SOUNDTOUCH_MIRRORED_BUFFER
+
+
+// Mirrored buffers are disabled by default
+bool FIFOSampleBuffer::bAllowMirroring = false;
+
+
 // Constructor
 FIFOSampleBuffer::FIFOSampleBuffer(int numChannels)
 {
@@ -59,6 +146,7 @@ FIFOSampleBuffer::FIFOSampleBuffer(int numChannels)
     sizeInBytes = 0; // reasonable initial value
     buffer = NULL;
     bufferUnaligned = NULL;
+    bMirrored = false;
     samplesInBuffer = 0;
     bufferPos = 0;
     channels = (uint)numChannels;
@@ -69,9 +157,30 @@ FIFOSampleBuffer::FIFOSampleBuffer(int numChannels)
 // destructor
 FIFOSampleBuffer::~FIFOSampleBuffer()
 {
+    freeBuffer();
+}
+
+
+// static function to enable or disable the mirrored buffers
+void FIFOSampleBuffer::setMirroring(bool enable)
+{
+    bAllowMirroring = enable;
+}
+
+
+// Releases the buffer memory
+void FIFOSampleBuffer::freeBuffer()
+{
+#ifdef SOUNDTOUCH_MIRRORED_BUFFER
+    if (bMirrored)
+    {
+        freeMirrored(buffer, sizeInBytes);
+    }
+#endif // SOUNDTOUCH_MIRRORED_BUFFER
     delete[] bufferUnaligned;
     bufferUnaligned = NULL;
     buffer = NULL;
+    bMirrored = false;
 }
 
 
@@ -140,7 +249,7 @@ void FIFOSampleBuffer::putSamples(uint nSamples)
 SAMPLETYPE *FIFOSampleBuffer::ptrEnd(uint slackCapacity) 
 {
     ensureCapacity(samplesInBuffer + slackCapacity);
-    return buffer + samplesInBuffer * channels;
+    return ptrBegin() + samplesInBuffer * channels;
 }
 
 
@@ -154,7 +263,7 @@ SAMPLETYPE *FIFOSampleBuffer::ptrEnd(uint slackCapacity)
 SAMPLETYPE *FIFOSampleBuffer::ptrBegin()
 {
     assert(buffer);
-    return buffer + bufferPos * channels;
+    return buffer + bufferPos;
 }
 
 
@@ -162,32 +271,54 @@ SAMPLETYPE *FIFOSampleBuffer::ptrBegin()
 // 'capacityRequirement' number of samples. The buffer is grown in steps of
 // 4 kilobytes to eliminate the need for frequently growing up the buffer,
 // as well as to round the buffer size up to the virtual memory page size.
+//
+// A mirrored buffer is used if enabled and possible, because its contents are 
+// contiguous from 'ptrBegin' on also when they wrap over the end of the ring, so
+// that the buffer never needs to be rewound.
 void FIFOSampleBuffer::ensureCapacity(uint capacityRequirement)
 {
     SAMPLETYPE *tempUnaligned, *temp;
+    uint newSize;
 
     if (capacityRequirement > getCapacity()) 
     {
         // enlarge the buffer in 4kbyte steps (round up to next 4k boundary)
-        sizeInBytes = (capacityRequirement * channels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
-        assert(sizeInBytes % 2 == 0);
-        tempUnaligned = new SAMPLETYPE[sizeInBytes / sizeof(SAMPLETYPE) + 16 / sizeof(SAMPLETYPE)];
-        if (tempUnaligned == NULL)
+        newSize = (capacityRequirement * channels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
+        assert(newSize % 2 == 0);
+        tempUnaligned = NULL;
+        temp = NULL;
+
+#ifdef SOUNDTOUCH_MIRRORED_BUFFER
+        if (bAllowMirroring)
+        {
+            // the mirrored memory is mapped in whole pages
+            newSize = (newSize + getPageSize() - 1) / getPageSize() * getPageSize();
+            temp = (SAMPLETYPE *)allocMirrored(newSize);
+        }
+#endif // SOUNDTOUCH_MIRRORED_BUFFER
+
+        if (temp == NULL)
         {
-            ST_THROW_RT_ERROR("Couldn't allocate memory!\n");
+            tempUnaligned = new SAMPLETYPE[newSize / sizeof(SAMPLETYPE) + 16 / sizeof(SAMPLETYPE)];
+            if (tempUnaligned == NULL)
+            {
+                ST_THROW_RT_ERROR("Couldn't allocate memory!\n");
+            }
+            // Align the buffer to begin at 16byte cache line boundary for optimal performance
+            temp = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(tempUnaligned);
         }
-        // Align the buffer to begin at 16byte cache line boundary for optimal performance
-        temp = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(tempUnaligned);
         if (samplesInBuffer)
         {
             memcpy(temp, ptrBegin(), samplesInBuffer * channels * sizeof(SAMPLETYPE));
         }
-        delete[] bufferUnaligned;
+        freeBuffer();
         buffer = temp;
         bufferUnaligned = tempUnaligned;
+        bMirrored = (tempUnaligned == NULL);
+        sizeInBytes = newSize;
         bufferPos = 0;
     } 
-    else 
+    else if (bMirrored == false)
     {
         // simply rewind the buffer (if necessary)
         rewind();
@@ -240,7 +371,13 @@ uint FIFOSampleBuffer::receiveSamples(uint maxSamples)
     }
 
     samplesInBuffer -= maxSamples;
-    bufferPos += maxSamples;
+    bufferPos += maxSamples * channels;
+    if (bMirrored && (bufferPos >= sizeInBytes / sizeof(SAMPLETYPE)))
+    {
+        // wrap around the ring, the rest of the samples continue from the 
+        // beginning of the buffer
+        bufferPos -= sizeInBytes / sizeof(SAMPLETYPE);
+    }
 
     return maxSamples;
 }
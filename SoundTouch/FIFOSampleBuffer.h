@@ -56,9 +56,19 @@ namespace soundtouch
 ///
 /// Notice that in case of stereo audio, one sample is considered to consist of 
 /// both channel data.
+///
+/// On Linux the buffer can be a mirrored ring buffer (see 'bMirrored'), if enabled
+/// with 'setMirroring' and supported by the system. Each growth of such a buffer 
+/// costs a 'memfd_create', an 'ftruncate' and three 'mmap' calls, besides copying
+/// the data. The mirrored buffer memory isn't inherited by child processes created
+/// with 'fork', so then a child process mustn't use the buffers created by its 
+/// parent.
 class FIFOSampleBuffer : public FIFOSamplePipe
 {
 private:
+    /// Nonzero if the buffers allocated from now on may be mirrored ring buffers
+    static bool bAllowMirroring;
+
     /// Sample buffer.
     SAMPLETYPE *buffer;
 
@@ -66,6 +76,12 @@ private:
     // 16-byte aligned location of this buffer
     SAMPLETYPE *bufferUnaligned;
 
+    /// Nonzero if 'buffer' is a mirrored ring buffer, i.e. 'sizeInBytes' bytes of
+    /// memory mapped twice to consecutive virtual addresses, so that the data that
+    /// wraps over the end of the ring is readable & writable as one contiguous block.
+    /// Otherwise 'buffer' is allocated from heap, see 'bufferUnaligned'.
+    bool bMirrored;
+
     /// Sample buffer size in bytes
     uint sizeInBytes;
 
@@ -75,15 +91,19 @@ private:
     /// Channels, 1=mono, 2=stereo.
     uint channels;
 
-    /// Current position pointer to the buffer. This pointer is increased when samples are 
-    /// removed from the pipe so that it's necessary to actually rewind buffer (move data)
-    /// only new data when is put to the pipe.
+    /// Current position pointer to the buffer in SAMPLETYPE units. This pointer is 
+    /// increased when samples are removed from the pipe. With a mirrored buffer the 
+    /// position simply wraps around the ring, otherwise the buffer gets rewound (data 
+    /// moved) when new data is put to the pipe.
     uint bufferPos;
 
     /// Rewind the buffer by moving data from position pointed by 'bufferPos' to real 
-    /// beginning of the buffer.
+    /// beginning of the buffer. Not needed with a mirrored buffer.
     void rewind();
 
+    /// Releases the buffer memory
+    void freeBuffer();
+
     /// Ensures that the buffer has capacity for at least this many samples.
     void ensureCapacity(uint capacityRequirement);
 
@@ -100,6 +120,11 @@ public:
     /// destructor
     ~FIFOSampleBuffer();
 
+    /// Enables or disables the mirrored ring buffers for the buffers that get 
+    /// allocated or grown from now on, in all instances. Disabled by default, as 
+    /// the mirrored buffers aren't usable in child processes created with 'fork'.
+    static void setMirroring(bool enable);
+
     /// Returns a pointer to the beginning of the output samples. 
     /// This function is provided for accessing the output samples directly. 
     /// Please be careful for not to corrupt the book-keeping!
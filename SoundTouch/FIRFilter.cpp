@@ -43,11 +43,33 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "FIRFilter.h"
+#include "FIRKernel.h"
 #include "cpu_detect.h"
 
 using namespace soundtouch;
 
+// Types for the products and sums of the symmetric & multichannel filter routines.
+// With integer samples the sum of a mirrored sample pair times a coefficient can 
+// overflow 'int', and the sum of such products a 32bit 'long'.
+typedef FIRSampleTraits<SAMPLETYPE>::ProductType ProductType;
+typedef FIRSampleTraits<SAMPLETYPE>::AccuType AccuType;
+
+/// Filters of this many taps or longer may use FFT convolution instead of the 
+/// direct form, depending on the CPU extensions and the channel count, see 
+/// 'getFFTThreshold'. Shorter filters always use the direct form, as the FFT 
+/// block overhead grows with short input batches.
+#define FIR_FFT_THRESHOLD   256
+
+/// FFT length in proportion to the filter length. Longer transform produces more 
+/// output samples per transform, but costs more per sample due to the log(N) factor.
+#define FIR_FFT_SIZE_FACTOR 8
+
 /*****************************************************************************
  *
  * Implementation of the class 'FIRFilter'
@@ -61,6 +83,7 @@ FIRFilter::FIRFilter()
     length = 0;
     lengthDiv8 = 0;
     filterCoeffs = NULL;
+    bSymmetric = false;
 }
 
 
@@ -69,10 +92,136 @@ FIRFilter::~FIRFilter()
     delete[] filterCoeffs;
 }
 
+// Runs the generic C++ filter kernel for 'CHANNELS' channels. The common filter 
+// lengths get their own kernel instances with the tap loop unrolled at compile
+// time, up to 128 multiplications per output sample frame to limit the code size.
+template <int CHANNELS>
+static uint evaluateKernel(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples,
+                           const SAMPLETYPE *coeffs, uint length, uint divFactor)
+{
+    int numFrames = (int)(numSamples - length);
+
+    if ((length == 32) && (32 * CHANNELS <= 128))
+    {
+        FIRKernel<SAMPLETYPE, CHANNELS, 32>::evaluate(dest, src, numFrames, coeffs, length, divFactor);
+    }
+    else if ((length == 64) && (64 * CHANNELS <= 128))
+    {
+        FIRKernel<SAMPLETYPE, CHANNELS, 64>::evaluate(dest, src, numFrames, coeffs, length, divFactor);
+    }
+    else if ((length == 128) && (128 * CHANNELS <= 128))
+    {
+        FIRKernel<SAMPLETYPE, CHANNELS, 128>::evaluate(dest, src, numFrames, coeffs, length, divFactor);
+    }
+    else
+    {
+        FIRKernel<SAMPLETYPE, CHANNELS>::evaluate(dest, src, numFrames, coeffs, length, divFactor);
+    }
+    return numFrames;
+}
+
+
 // Usual C-version of the filter routine for stereo sound
 uint FIRFilter::evaluateFilterStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples) const
+{
+    assert(length != 0);
+    assert(src != NULL);
+    assert(dest != NULL);
+    assert(filterCoeffs != NULL);
+
+    return evaluateKernel<2>(dest, src, numSamples, filterCoeffs, length, resultDivFactor);
+}
+
+
+// Usual C-version of the filter routine for mono sound
+uint FIRFilter::evaluateFilterMono(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples) const
+{
+    assert(length != 0);
+
+    return evaluateKernel<1>(dest, src, numSamples, filterCoeffs, length, resultDivFactor);
+}
+
+
+// C-version of the filter routine for multichannel sound. The common 4.0, 5.1 & 
+// 7.1 channel layouts get their own instances of the generic filter kernel, that
+// keep the sums of all the channels in registers; other channel counts use the 
+// loop below, which processes the channels in groups.
+uint FIRFilter::evaluateFilterMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels)
 {
     int j, end;
+    // when using floating point samples, use a scaler instead of a divider
+    // because division is much slower operation than multiplying.
+    double dScaler = 1.0 / (double)resultDivider;
+
+    assert(length != 0);
+    assert(src != NULL);
+    assert(dest != NULL);
+    assert(filterCoeffs != NULL);
+
+    switch (numChannels)
+    {
+        case 4:
+            return evaluateKernel<4>(dest, src, numSamples, filterCoeffs, length, resultDivFactor);
+
+        case 6:
+            return evaluateKernel<6>(dest, src, numSamples, filterCoeffs, length, resultDivFactor);
+
+        case 8:
+            return evaluateKernel<8>(dest, src, numSamples, filterCoeffs, length, resultDivFactor);
+
+        default:
+            break;
+    }
+
+    end = numChannels * (numSamples - length);
+
+    #pragma omp parallel for
+    for (j = 0; j < end; j += numChannels)
+    {
+        AccuType sums[16];
+        uint c0;
+
+        // process the channels in groups of max. 16 channels
+        for (c0 = 0; c0 < numChannels; c0 += 16)
+        {
+            const SAMPLETYPE *ptr;
+            uint c, i, groupChannels;
+
+            groupChannels = (numChannels - c0 < 16) ? numChannels - c0 : 16;
+            for (c = 0; c < groupChannels; c ++)
+            {
+                sums[c] = 0;
+            }
+
+            ptr = src + j + c0;
+
+            for (i = 0; i < length; i ++)
+            {
+                SAMPLETYPE coef=filterCoeffs[i];
+                for (c = 0; c < groupChannels; c ++)
+                {
+                    sums[c] += (ProductType)ptr[c] * coef;
+                }
+                ptr += numChannels;
+            }
+        
+            // scale down and saturate to the sample type
+            for (c = 0; c < groupChannels; c ++)
+            {
+                dest[j + c0 + c] = FIRSampleTraits<SAMPLETYPE>::toSample(sums[c], resultDivFactor, dScaler);
+            }
+        }
+    }
+    return numSamples - length;
+}
+
+
+// C-version of the filter routine for stereo sound with symmetric coefficients.
+// Mirrored samples have equal coefficients, so they're added together first.
+uint FIRFilter::evaluateSymmetricStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples) const
+{
+    int j, end;
+    uint half = length / 2;
 #ifdef SOUNDTOUCH_FLOAT_SAMPLES
     // when using floating point samples, use a scaler instead of a divider
     // because division is much slower operation than multiplying.
@@ -90,23 +239,18 @@ uint FIRFilter::evaluateFilterStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, ui
     for (j = 0; j < end; j += 2) 
     {
         const SAMPLETYPE *ptr;
-        LONG_SAMPLETYPE suml, sumr;
+        AccuType suml, sumr;
         uint i;
 
-        suml = sumr = 0;
         ptr = src + j;
 
-        for (i = 0; i < length; i += 4) 
+        // the first tap has no pair, and the center tap is its own pair
+        suml = (ProductType)ptr[0] * filterCoeffs[0] + (ProductType)ptr[2 * half] * filterCoeffs[half];
+        sumr = (ProductType)ptr[1] * filterCoeffs[0] + (ProductType)ptr[2 * half + 1] * filterCoeffs[half];
+        for (i = 1; i < half; i ++) 
         {
-            // loop is unrolled by factor of 4 here for efficiency
-            suml += ptr[2 * i + 0] * filterCoeffs[i + 0] +
-                    ptr[2 * i + 2] * filterCoeffs[i + 1] +
-                    ptr[2 * i + 4] * filterCoeffs[i + 2] +
-                    ptr[2 * i + 6] * filterCoeffs[i + 3];
-            sumr += ptr[2 * i + 1] * filterCoeffs[i + 0] +
-                    ptr[2 * i + 3] * filterCoeffs[i + 1] +
-                    ptr[2 * i + 5] * filterCoeffs[i + 2] +
-                    ptr[2 * i + 7] * filterCoeffs[i + 3];
+            suml += (ProductType)(ptr[2 * i] + ptr[2 * (length - i)]) * filterCoeffs[i];
+            sumr += (ProductType)(ptr[2 * i + 1] + ptr[2 * (length - i) + 1]) * filterCoeffs[i];
         }
 
 #ifdef SOUNDTOUCH_INTEGER_SAMPLES
@@ -127,12 +271,11 @@ uint FIRFilter::evaluateFilterStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, ui
 }
 
 
-
-
-// Usual C-version of the filter routine for mono sound
-uint FIRFilter::evaluateFilterMono(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples) const
+// C-version of the filter routine for mono sound with symmetric coefficients
+uint FIRFilter::evaluateSymmetricMono(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples) const
 {
     int j, end;
+    uint half = length / 2;
 #ifdef SOUNDTOUCH_FLOAT_SAMPLES
     // when using floating point samples, use a scaler instead of a divider
     // because division is much slower operation than multiplying.
@@ -146,17 +289,14 @@ uint FIRFilter::evaluateFilterMono(SAMPLETYPE *dest, const SAMPLETYPE *src, uint
     for (j = 0; j < end; j ++) 
     {
         const SAMPLETYPE *pSrc = src + j;
-        LONG_SAMPLETYPE sum;
+        AccuType sum;
         uint i;
 
-        sum = 0;
-        for (i = 0; i < length; i += 4) 
+        // the first tap has no pair, and the center tap is its own pair
+        sum = (ProductType)pSrc[0] * filterCoeffs[0] + (ProductType)pSrc[half] * filterCoeffs[half];
+        for (i = 1; i < half; i ++) 
         {
-            // loop is unrolled by factor of 4 here for efficiency
-            sum += pSrc[i + 0] * filterCoeffs[i + 0] + 
-                   pSrc[i + 1] * filterCoeffs[i + 1] + 
-                   pSrc[i + 2] * filterCoeffs[i + 2] + 
-                   pSrc[i + 3] * filterCoeffs[i + 3];
+            sum += (ProductType)(pSrc[i] + pSrc[length - i]) * filterCoeffs[i];
         }
 #ifdef SOUNDTOUCH_INTEGER_SAMPLES
         sum >>= resultDivFactor;
@@ -171,62 +311,6 @@ uint FIRFilter::evaluateFilterMono(SAMPLETYPE *dest, const SAMPLETYPE *src, uint
 }
 
 
-uint FIRFilter::evaluateFilterMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels)
-{
-    int j, end;
-
-#ifdef SOUNDTOUCH_FLOAT_SAMPLES
-    // when using floating point samples, use a scaler instead of a divider
-    // because division is much slower operation than multiplying.
-    double dScaler = 1.0 / (double)resultDivider;
-#endif
-
-    assert(length != 0);
-    assert(src != NULL);
-    assert(dest != NULL);
-    assert(filterCoeffs != NULL);
-    assert(numChannels < 16);
-
-    end = numChannels * (numSamples - length);
-
-    #pragma omp parallel for
-    for (j = 0; j < end; j += numChannels)
-    {
-        const SAMPLETYPE *ptr;
-        LONG_SAMPLETYPE sums[16];
-        uint c, i;
-
-        for (c = 0; c < numChannels; c ++)
-        {
-            sums[c] = 0;
-        }
-
-        ptr = src + j;
-
-        for (i = 0; i < length; i ++)
-        {
-            SAMPLETYPE coef=filterCoeffs[i];
-            for (c = 0; c < numChannels; c ++)
-            {
-                sums[c] += ptr[0] * coef;
-                ptr ++;
-            }
-        }
-        
-        for (c = 0; c < numChannels; c ++)
-        {
-#ifdef SOUNDTOUCH_INTEGER_SAMPLES
-            sums[c] >>= resultDivFactor;
-#else
-            sums[c] *= dScaler;
-#endif // SOUNDTOUCH_INTEGER_SAMPLES
-            dest[j+c] = (SAMPLETYPE)sums[c];
-        }
-    }
-    return numSamples - length;
-}
-
-
 // Set filter coeffiecients and length.
 //
 // Throws an exception if filter length isn't divisible by 8
@@ -235,6 +319,14 @@ void FIRFilter::setCoefficients(const SAMPLETYPE *coeffs, uint newLength, uint u
     assert(newLength > 0);
     if (newLength % 8) ST_THROW_RT_ERROR("FIR filter length not divisible by 8");
 
+    // reallocate only if the length changes, so that updating the coefficients
+    // of same-length filter doesn't allocate memory
+    if ((filterCoeffs == NULL) || (newLength != length))
+    {
+        delete[] filterCoeffs;
+        filterCoeffs = new SAMPLETYPE[newLength];
+    }
+
     lengthDiv8 = newLength / 8;
     length = lengthDiv8 * 8;
     assert(length == newLength);
@@ -242,9 +334,18 @@ void FIRFilter::setCoefficients(const SAMPLETYPE *coeffs, uint newLength, uint u
     resultDivFactor = uResultDivFactor;
     resultDivider = (SAMPLETYPE)::pow(2.0, (int)resultDivFactor);
 
-    delete[] filterCoeffs;
-    filterCoeffs = new SAMPLETYPE[length];
     memcpy(filterCoeffs, coeffs, length * sizeof(SAMPLETYPE));
+
+    // check if the coefficients are symmetric around the center tap
+    bSymmetric = true;
+    for (uint i = 1; i < length / 2; i ++)
+    {
+        if (coeffs[i] != coeffs[length - i])
+        {
+            bSymmetric = false;
+            break;
+        }
+    }
 }
 
 
@@ -269,11 +370,13 @@ uint FIRFilter::evaluate(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSample
 #ifndef USE_MULTICH_ALWAYS
     if (numChannels == 1)
     {
-        return evaluateFilterMono(dest, src, numSamples);
+        return bSymmetric ? evaluateSymmetricMono(dest, src, numSamples) : 
+                            evaluateFilterMono(dest, src, numSamples);
     } 
     else if (numChannels == 2)
     {
-        return evaluateFilterStereo(dest, src, numSamples);
+        return bSymmetric ? evaluateSymmetricStereo(dest, src, numSamples) : 
+                            evaluateFilterStereo(dest, src, numSamples);
     }
     else
 #endif // USE_MULTICH_ALWAYS
@@ -295,13 +398,23 @@ void * FIRFilter::operator new(size_t s)
 }
 
 
-FIRFilter * FIRFilter::newInstance()
+FIRFilter * FIRFilter::newInstance(uint length)
 {
     uint uExtensions;
 
+    if (length >= FIR_FFT_THRESHOLD)
+    {
+        // long filter, FFT convolution is faster than the direct-form version 
+        // at least for multichannel sound
+        FIRFilterFFT *pFFT = ::new FIRFilterFFT;
+
+        pFFT->setDirect(newInstance(0));
+        return pFFT;
+    }
+
     uExtensions = detectCPUextensions();
 
-    // Check if MMX/SSE instruction set extensions supported by CPU
+    // Check if MMX/SSE/AVX2 instruction set extensions supported by CPU
 
 #ifdef SOUNDTOUCH_ALLOW_MMX
     // MMX routines available only with integer sample types
@@ -312,6 +425,15 @@ FIRFilter * FIRFilter::newInstance()
     else
 #endif // SOUNDTOUCH_ALLOW_MMX
 
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    if (uExtensions & SUPPORT_AVX2)
+    {
+        // AVX2 & FMA support
+        return ::new FIRFilterAVX2;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_AVX2
+
 #ifdef SOUNDTOUCH_ALLOW_SSE
     if (uExtensions & SUPPORT_SSE)
     {
@@ -326,3 +448,263 @@ FIRFilter * FIRFilter::newInstance()
         return ::new FIRFilter;
     }
 }
+
+
+
+/*****************************************************************************
+ *
+ * Implementation of the class 'FIRFilterFFT'
+ *
+ *****************************************************************************/
+
+// Returns the filter length from which the FFT convolution of 'numChannels' 
+// channels is faster than the direct-form version that 'newInstance' selects 
+// for the CPU. Determined with SoundTouchBench; the FFT version costs per channel
+// pair, so it gains the least with mono sound, and the most with multichannel 
+// sound that the direct-form versions have no vectorized routines for.
+static uint getFFTThreshold(uint numChannels)
+{
+    uint uExtensions;
+
+    uExtensions = detectCPUextensions();
+
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    if (uExtensions & SUPPORT_AVX2)
+    {
+        // AVX2 mono routine stays faster than FFT up to at least 4096 taps; stereo
+        // breaks even between 1024 & 2048 taps
+        if (numChannels == 1) return 0xffffffffU;
+        if (numChannels == 2) return 2048;
+        return FIR_FFT_THRESHOLD;
+    }
+#endif // SOUNDTOUCH_ALLOW_AVX2
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    if (uExtensions & SUPPORT_SSE)
+    {
+        // SSE mono routine breaks even at about 1024 taps, stereo at about 
+        // 256..512 taps
+        if (numChannels == 1) return 2048;
+        if (numChannels == 2) return 512;
+        return FIR_FFT_THRESHOLD;
+    }
+#endif // SOUNDTOUCH_ALLOW_SSE
+
+    // the plain C & MMX routines break even at 128..256 taps with any channel count
+    (void)uExtensions;
+    (void)numChannels;
+    return FIR_FFT_THRESHOLD;
+}
+
+
+FIRFilterFFT::FIRFilterFFT() : FIRFilter()
+{
+    kernelSpectrum = NULL;
+    blockLength = 0;
+    workBuffers = NULL;
+    numWorkBuffers = 0;
+    pDirect = NULL;
+    fftThreshold[0] = fftThreshold[1] = fftThreshold[2] = 0;
+}
+
+
+FIRFilterFFT::~FIRFilterFFT()
+{
+    delete[] kernelSpectrum;
+    delete[] workBuffers;
+    delete pDirect;
+}
+
+
+void FIRFilterFFT::setDirect(FIRFilter *direct)
+{
+    delete pDirect;
+    pDirect = direct;
+    fftThreshold[0] = getFFTThreshold(1);
+    fftThreshold[1] = getFFTThreshold(2);
+    fftThreshold[2] = getFFTThreshold(6);
+    if ((pDirect != NULL) && (length > 0))
+    {
+        pDirect->setCoefficients(filterCoeffs, length, resultDivFactor);
+    }
+}
+
+
+bool FIRFilterFFT::useFFT(uint numChannels) const
+{
+    uint threshold;
+
+    if (pDirect == NULL) return true;
+    threshold = fftThreshold[(numChannels < 3) ? numChannels - 1 : 2];
+    return (length >= threshold);
+}
+
+
+// Sets filter coefficients, precalculates the filter kernel spectrum and allocates
+// the transform work buffers
+void FIRFilterFFT::setCoefficients(const SAMPLETYPE *coeffs, uint newLength, uint uResultDivFactor)
+{
+    uint i, size, oldLength;
+    int numThreads;
+    double scale;
+
+    oldLength = length;
+    FIRFilter::setCoefficients(coeffs, newLength, uResultDivFactor);
+    // the transform cost doesn't depend on the symmetry
+    bSymmetric = false;
+    if (pDirect)
+    {
+        pDirect->setCoefficients(coeffs, newLength, uResultDivFactor);
+    }
+
+    size = FFT::nextPow2(FIR_FFT_SIZE_FACTOR * length);
+    fft.setSize(size);
+    blockLength = size - length + 1;
+
+    // The filter is a correlation with 'coeffs', i.e. convolution with reversed 
+    // coefficients. Scale the kernel so that the result needn't be scaled.
+    scale = 1.0 / ((double)resultDivider * (double)size);
+
+#ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+#else
+    numThreads = 1;
+#endif
+
+    if ((kernelSpectrum == NULL) || (length != oldLength) || (numThreads != numWorkBuffers))
+    {
+        delete[] kernelSpectrum;
+        delete[] workBuffers;
+        kernelSpectrum = new double[2 * size];
+        workBuffers = new double[2 * size * numThreads];
+        numWorkBuffers = numThreads;
+    }
+    memset(kernelSpectrum, 0, 2 * size * sizeof(double));
+    for (i = 0; i < length; i ++)
+    {
+        kernelSpectrum[2 * i] = scale * (double)coeffs[length - 1 - i];
+    }
+    fft.forward(kernelSpectrum);
+}
+
+
+// Filters channels 'channel' & 'channel + 1' with overlap-save convolution. The
+// samples of the two channels are packed into the real & imaginary parts of the 
+// transform; as the kernel is real, the channels don't mix.
+void FIRFilterFFT::evaluateChannelPair(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, 
+                                       uint numChannels, uint channel) const
+{
+    const bool hasPair = (channel + 1 < numChannels);
+    const int size = (int)fft.getSize();
+    const int end = (int)(numSamples - length);
+    int numBlocks;
+    int b;
+
+    numBlocks = (end + blockLength - 1) / blockLength;
+
+    // the number of threads is limited to the number of the work buffers
+    #pragma omp parallel num_threads(numWorkBuffers)
+    {
+#ifdef _OPENMP
+        double *work = workBuffers + 2 * size * omp_get_thread_num();
+#else
+        double *work = workBuffers;
+#endif
+
+        #pragma omp for
+        for (b = 0; b < numBlocks; b ++)
+        {
+            const SAMPLETYPE *pSrc;
+            SAMPLETYPE *pDest;
+            int pos, count, inCount, i;
+
+            pos = b * blockLength;
+            count = end - pos;
+            if (count > (int)blockLength) count = blockLength;
+            inCount = count + length - 1;
+
+            // load the input block, zero-padded to the transform length
+            pSrc = src + pos * numChannels + channel;
+            for (i = 0; i < inCount; i ++)
+            {
+                work[2 * i] = (double)pSrc[0];
+                work[2 * i + 1] = hasPair ? (double)pSrc[1] : 0.0;
+                pSrc += numChannels;
+            }
+            for (i = 2 * inCount; i < 2 * size; i ++)
+            {
+                work[i] = 0;
+            }
+
+            fft.forward(work);
+
+            // multiply with the kernel spectrum
+            for (i = 0; i < size; i ++)
+            {
+                double re = work[2 * i];
+                double im = work[2 * i + 1];
+                double kre = kernelSpectrum[2 * i];
+                double kim = kernelSpectrum[2 * i + 1];
+
+                work[2 * i] = re * kre - im * kim;
+                work[2 * i + 1] = re * kim + im * kre;
+            }
+
+            fft.inverse(work);
+
+            // the first 'length - 1' items contain circular wrap-around, discard them
+            pDest = dest + pos * numChannels + channel;
+            for (i = 0; i < count; i ++)
+            {
+                double outRe = work[2 * (i + length - 1)];
+                double outIm = work[2 * (i + length - 1) + 1];
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+                // round & saturate to 16 bit integer limits
+                outRe = floor(outRe + 0.5);
+                outIm = floor(outIm + 0.5);
+                outRe = (outRe < -32768) ? -32768 : (outRe > 32767) ? 32767 : outRe;
+                outIm = (outIm < -32768) ? -32768 : (outIm > 32767) ? 32767 : outIm;
+#endif // SOUNDTOUCH_INTEGER_SAMPLES
+                pDest[0] = (SAMPLETYPE)outRe;
+                if (hasPair) pDest[1] = (SAMPLETYPE)outIm;
+                pDest += numChannels;
+            }
+        }
+    }
+}
+
+
+uint FIRFilterFFT::evaluateFFT(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels) const
+{
+    uint c;
+
+    assert(length != 0);
+    assert(kernelSpectrum != NULL);
+
+    for (c = 0; c < numChannels; c += 2)
+    {
+        evaluateChannelPair(dest, src, numSamples, numChannels, c);
+    }
+    return numSamples - length;
+}
+
+
+uint FIRFilterFFT::evaluateFilterStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples) const
+{
+    if (useFFT(2) == false) return pDirect->evaluate(dest, src, numSamples, 2);
+    return evaluateFFT(dest, src, numSamples, 2);
+}
+
+
+uint FIRFilterFFT::evaluateFilterMono(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples) const
+{
+    if (useFFT(1) == false) return pDirect->evaluate(dest, src, numSamples, 1);
+    return evaluateFFT(dest, src, numSamples, 1);
+}
+
+
+uint FIRFilterFFT::evaluateFilterMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels)
+{
+    if (useFFT(numChannels) == false) return pDirect->evaluate(dest, src, numSamples, numChannels);
+    return evaluateFFT(dest, src, numSamples, numChannels);
+}
@@ -44,6 +44,7 @@
 
 #include <stddef.h>
 #include "STTypes.h"
+#include "FFT.h"
 
 namespace soundtouch
 {
@@ -65,6 +66,11 @@ protected:
     // Memory for filter coefficients
     SAMPLETYPE *filterCoeffs;
 
+    // Nonzero if the coefficients are symmetric around the center tap 'length / 2',
+    // as with linear-phase filters. Then the routines that add the mirrored input
+    // sample pairs before multiplying are used.
+    bool bSymmetric;
+
     virtual uint evaluateFilterStereo(SAMPLETYPE *dest, 
                                       const SAMPLETYPE *src, 
                                       uint numSamples) const;
@@ -73,6 +79,13 @@ protected:
                                     uint numSamples) const;
     virtual uint evaluateFilterMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels);
 
+    virtual uint evaluateSymmetricStereo(SAMPLETYPE *dest, 
+                                         const SAMPLETYPE *src, 
+                                         uint numSamples) const;
+    virtual uint evaluateSymmetricMono(SAMPLETYPE *dest, 
+                                       const SAMPLETYPE *src, 
+                                       uint numSamples) const;
+
 public:
     FIRFilter();
     virtual ~FIRFilter();
@@ -81,7 +94,12 @@ public:
     /// depending on if we've a MMX-capable CPU available or not.
     static void * operator new(size_t s);
 
-    static FIRFilter *newInstance();
+    /// Creates a filter instance suitable for the CPU and for filter length 'length'.
+    /// Long filters get the FFT convolution version, which uses the direct-form 
+    /// version for the channel counts that the FFT isn't faster for with this CPU,
+    /// see FIR_FFT_THRESHOLD. If the length isn't yet known, give zero to get a 
+    /// direct-form version.
+    static FIRFilter *newInstance(uint length = 0);
 
     /// Applies the filter to the given sequence of samples. 
     /// Note : The amount of outputted samples is by value of 'filter_length' 
@@ -113,6 +131,7 @@ public:
         short *filterCoeffsAlign;
 
         virtual uint evaluateFilterStereo(short *dest, const short *src, uint numSamples) const;
+        virtual uint evaluateFilterMulti(short *dest, const short *src, uint numSamples, uint numChannels);
     public:
         FIRFilterMMX();
         ~FIRFilterMMX();
@@ -123,6 +142,61 @@ public:
 #endif // SOUNDTOUCH_ALLOW_MMX
 
 
+/// Class that implements long filters with overlap-save FFT convolution. The 
+/// filter is evaluated for blocks of samples at a time, so the cost per sample
+/// grows only logarithmically with the filter length.
+class FIRFilterFFT : public FIRFilter
+{
+protected:
+    FFT fft;
+
+    /// Spectrum of the filter kernel, scaled with result divider & inverse FFT scale
+    double *kernelSpectrum;
+
+    /// Number of output samples produced by each transform block
+    uint blockLength;
+
+    /// Transform work buffers, one of '2 * fft.getSize()' items for each thread, so
+    /// that the streaming doesn't need to allocate memory
+    double *workBuffers;
+
+    /// Number of buffers in 'workBuffers', i.e. max. number of parallel threads
+    int numWorkBuffers;
+
+    /// Direct-form version for the channel counts that the FFT convolution isn't
+    /// faster for, or NULL to use the FFT convolution always
+    FIRFilter *pDirect;
+
+    /// Filter lengths from which the FFT convolution is faster than 'pDirect' for
+    /// mono, stereo & multichannel sound
+    uint fftThreshold[3];
+
+    /// Returns true if the FFT convolution is used for 'numChannels' channels
+    bool useFFT(uint numChannels) const;
+
+    /// Filters samples of two channels 'channel' & 'channel + 1' at once, using 
+    /// the real & imaginary parts of complex FFT. If 'channel + 1' doesn't exist,
+    /// the imaginary part is zero.
+    void evaluateChannelPair(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, 
+                             uint numChannels, uint channel) const;
+    uint evaluateFFT(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels) const;
+
+    virtual uint evaluateFilterStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples) const;
+    virtual uint evaluateFilterMono(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples) const;
+    virtual uint evaluateFilterMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels);
+
+public:
+    FIRFilterFFT();
+    ~FIRFilterFFT();
+
+    /// Sets the direct-form version for the channel counts that the FFT isn't 
+    /// faster for with the current CPU. The filter takes the ownership of 'direct'.
+    void setDirect(FIRFilter *direct);
+
+    virtual void setCoefficients(const SAMPLETYPE *coeffs, uint newLength, uint uResultDivFactor);
+};
+
+
 #ifdef SOUNDTOUCH_ALLOW_SSE
     /// Class that implements SSE optimized functions exclusive for floating point samples type.
     class FIRFilterSSE : public FIRFilter
@@ -131,7 +205,17 @@ public:
         float *filterCoeffsUnalign;
         float *filterCoeffsAlign;
 
+        /// Coefficients of symmetric filter folded to half: the first tap, and the
+        /// taps 1 .. length/2 for the mirrored sample pairs, with the center tap 
+        /// halved because the center sample gets paired with itself.
+        float foldedFirst;
+        float *foldedCoeffs;
+
         virtual uint evaluateFilterStereo(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMono(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMulti(float *dest, const float *src, uint numSamples, uint numChannels);
+        virtual uint evaluateSymmetricStereo(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateSymmetricMono(float *dest, const float *src, uint numSamples) const;
     public:
         FIRFilterSSE();
         ~FIRFilterSSE();
@@ -141,6 +225,22 @@ public:
 
 #endif // SOUNDTOUCH_ALLOW_SSE
 
+
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    /// Class that implements AVX2 optimized filter routines for floating point 
+    /// samples type.
+    class FIRFilterAVX2 : public FIRFilterSSE
+    {
+    protected:
+        virtual uint evaluateFilterStereo(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMono(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMulti(float *dest, const float *src, uint numSamples, uint numChannels);
+        virtual uint evaluateSymmetricStereo(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateSymmetricMono(float *dest, const float *src, uint numSamples) const;
+    };
+
+#endif // SOUNDTOUCH_ALLOW_AVX2
+
 }
 
 #endif  // FIRFilter_H
@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Generic FIR filter kernels as C++ templates, parameterized by the sample
+/// type, the number of channels and optionally the number of filter taps.
+///
+/// The kernels don't depend on the SOUNDTOUCH_INTEGER_SAMPLES /
+/// SOUNDTOUCH_FLOAT_SAMPLES build setting, so both 16bit integer and floating
+/// point kernels can be instantiated in the same binary. If the number of taps
+/// is given as template parameter, the tap loop gets unrolled at compile time.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _FIRKernel_H_
+#define _FIRKernel_H_
+
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+/// Sample type dependent parts of the FIR kernels: the accumulator type, the type
+/// that the products of four taps are calculated & summed in, and conversion of
+/// the accumulated sum to the result sample.
+template <typename SampleType> struct FIRSampleTraits;
+
+
+/// 16bit integer samples: the products are accumulated as integers, and the sum
+/// is scaled down by 2^divFactor and saturated to 16 bit limits.
+template <> struct FIRSampleTraits<short>
+{
+    /// 64bit also with compilers where 'long' is 32bit (MSVC), as the sum of
+    /// full-scale products can exceed the 32bit range
+    typedef long long AccuType;
+
+    /// Samples are widened before multiplying, as the sum of four 16bit integer
+    /// products can overflow the 'int' type that they'd be promoted to
+    typedef long long ProductType;
+
+    static inline short toSample(AccuType sum, uint divFactor, double)
+    {
+        sum >>= divFactor;
+        // saturate to 16 bit integer limits
+        sum = (sum < -32768) ? -32768 : (sum > 32767) ? 32767 : sum;
+        return (short)sum;
+    }
+};
+
+
+/// Floating point samples: the products are accumulated in double precision, and
+/// the sum is multiplied by 'scaler' = 1 / 2^divFactor.
+template <> struct FIRSampleTraits<float>
+{
+    typedef double AccuType;
+    typedef float ProductType;
+
+    static inline float toSample(AccuType sum, uint, double scaler)
+    {
+        return (float)(sum * scaler);
+    }
+};
+
+
+/// Accumulates the products of four filter taps for 'CHANNELS' channels to 'sums'
+template <typename SampleType, int CHANNELS>
+struct FIRKernelStep
+{
+    typedef typename FIRSampleTraits<SampleType>::AccuType AccuType;
+    typedef typename FIRSampleTraits<SampleType>::ProductType ProductType;
+
+    static inline void accumulate4(AccuType *sums, const SampleType *src, const SampleType *coeffs)
+    {
+        for (int c = 0; c < CHANNELS; c ++)
+        {
+            sums[c] += (ProductType)src[c + 0 * CHANNELS] * coeffs[0] +
+                       (ProductType)src[c + 1 * CHANNELS] * coeffs[1] +
+                       (ProductType)src[c + 2 * CHANNELS] * coeffs[2] +
+                       (ProductType)src[c + 3 * CHANNELS] * coeffs[3];
+        }
+    }
+};
+
+
+/// Accumulates the products of 'TAPS' filter taps for 'CHANNELS' channels to
+/// 'sums'. The tap loop is unrolled at compile time by recursion, with four taps
+/// summed together before adding to the accumulator for shorter dependency chain.
+template <typename SampleType, int CHANNELS, int TAPS>
+struct FIRUnroll
+{
+    typedef typename FIRSampleTraits<SampleType>::AccuType AccuType;
+
+    static inline void accumulate(AccuType *sums, const SampleType *src, const SampleType *coeffs)
+    {
+        FIRUnroll<SampleType, CHANNELS, TAPS - 4>::accumulate(sums, src, coeffs);
+        FIRKernelStep<SampleType, CHANNELS>::accumulate4(sums, src + (TAPS - 4) * CHANNELS, coeffs + TAPS - 4);
+    }
+};
+
+
+template <typename SampleType, int CHANNELS>
+struct FIRUnroll<SampleType, CHANNELS, 0>
+{
+    typedef typename FIRSampleTraits<SampleType>::AccuType AccuType;
+
+    static inline void accumulate(AccuType *, const SampleType *, const SampleType *)
+    {
+    }
+};
+
+
+/// FIR filter kernel for 'CHANNELS' interleaved channels. If 'TAPS' is nonzero,
+/// the filter length is fixed to 'TAPS' at compile time, otherwise it's given
+/// at run time.
+template <typename SampleType, int CHANNELS, int TAPS = 0>
+class FIRKernel
+{
+public:
+    typedef typename FIRSampleTraits<SampleType>::AccuType AccuType;
+
+    /// Filters 'numFrames' output sample frames from 'src' to 'dest'. 'src' needs
+    /// to have 'numFrames + length' sample frames. 'length' needs to be divisible
+    /// by 4, and is ignored if the filter length is fixed by 'TAPS'. The result
+    /// gets scaled down by 2^divFactor.
+    static void evaluate(SampleType *dest, const SampleType *src, int numFrames,
+                         const SampleType *coeffs, uint length, uint divFactor)
+    {
+        const double scaler = 1.0 / (double)(1 << divFactor);
+        int j;
+
+        #pragma omp parallel for
+        for (j = 0; j < numFrames; j ++)
+        {
+            const SampleType *ptr = src + j * CHANNELS;
+            AccuType sums[CHANNELS];
+            int c;
+
+            for (c = 0; c < CHANNELS; c ++)
+            {
+                sums[c] = 0;
+            }
+
+            if (TAPS > 0)
+            {
+                FIRUnroll<SampleType, CHANNELS, TAPS>::accumulate(sums, ptr, coeffs);
+            }
+            else
+            {
+                for (uint i = 0; i < length; i += 4)
+                {
+                    FIRKernelStep<SampleType, CHANNELS>::accumulate4(sums, ptr, coeffs + i);
+                    ptr += 4 * CHANNELS;
+                }
+            }
+
+            for (c = 0; c < CHANNELS; c ++)
+            {
+                dest[j * CHANNELS + c] = FIRSampleTraits<SampleType>::toSample(sums[c], divFactor, scaler);
+            }
+        }
+    }
+};
+
+}
+
+#endif // _FIRKernel_H_
@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Floating point transposers in the integer build, see 'FloatTransposer.h'.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <assert.h>
+#include <math.h>
+#include "FloatTransposer.h"
+#include "cpu_detect.h"
+
+using namespace soundtouch;
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+
+/*****************************************************************************
+ *
+ * Implementation of the class 'FloatTransposer'
+ *
+ *****************************************************************************/
+
+FloatTransposer::FloatTransposer()
+{
+    numChannels = 0;
+    rate = 1.0f;
+}
+
+
+FloatTransposer::~FloatTransposer()
+{
+}
+
+
+int FloatTransposer::transpose(float *dest, const float *src, int &srcSamples)
+{
+#ifndef USE_MULTICH_ALWAYS
+    if (numChannels == 1)
+    {
+        return transposeMono(dest, src, srcSamples);
+    }
+    else if (numChannels == 2) 
+    {
+        return transposeStereo(dest, src, srcSamples);
+    } 
+#endif // USE_MULTICH_ALWAYS
+    assert(numChannels > 0);
+    return transposeMulti(dest, src, srcSamples);
+}
+
+
+void FloatTransposer::setChannels(int channels)
+{
+    numChannels = channels;
+    resetRegisters();
+}
+
+
+void FloatTransposer::setRate(double newRate)
+{
+    rate = newRate;
+}
+
+
+double FloatTransposer::getPosition() const
+{
+    return 0;
+}
+
+
+int FloatTransposer::setPosition(double position)
+{
+    resetRegisters();
+    return (int)floor(position + 0.5);
+}
+
+
+/*****************************************************************************
+ *
+ * Implementation of the class 'FloatTransposerAdapter'
+ *
+ *****************************************************************************/
+
+FloatTransposerAdapter::FloatTransposerAdapter(FloatTransposer *transposer) : TransposerBase()
+{
+    pTransposer = transposer;
+    floatSrc = NULL;
+    floatDest = NULL;
+    floatSrcSize = 0;
+    floatDestSize = 0;
+}
+
+
+FloatTransposerAdapter::~FloatTransposerAdapter()
+{
+    delete pTransposer;
+    delete[] floatSrc;
+    delete[] floatDest;
+}
+
+
+FloatTransposerAdapter *FloatTransposerAdapter::newInstance(FloatTransposer *transposer)
+{
+#if defined(SOUNDTOUCH_ALLOW_SSE41) && defined(SOUNDTOUCH_ALLOW_MMX)
+    uint uExtensions = detectCPUextensions();
+
+    if ((uExtensions & SUPPORT_SSE41) && (uExtensions & SUPPORT_MMX))
+    {
+        return ::new FloatTransposerAdapterSSE41(transposer);
+    }
+#endif // SOUNDTOUCH_ALLOW_SSE41
+
+    return ::new FloatTransposerAdapter(transposer);
+}
+
+
+void FloatTransposerAdapter::resetRegisters()
+{
+    // the floating point transposer gets reset in 'setChannels'
+}
+
+
+void FloatTransposerAdapter::setRate(double newRate)
+{
+    TransposerBase::setRate(newRate);
+    pTransposer->setRate(newRate);
+}
+
+
+void FloatTransposerAdapter::setChannels(int channels)
+{
+    TransposerBase::setChannels(channels);
+    pTransposer->setChannels(channels);
+}
+
+
+double FloatTransposerAdapter::getPosition() const
+{
+    return pTransposer->getPosition();
+}
+
+
+int FloatTransposerAdapter::setPosition(double position)
+{
+    return pTransposer->setPosition(position);
+}
+
+
+int FloatTransposerAdapter::transposeMono(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+{
+    return transposeFloat(dest, src, srcSamples);
+}
+
+
+int FloatTransposerAdapter::transposeStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+{
+    return transposeFloat(dest, src, srcSamples);
+}
+
+
+int FloatTransposerAdapter::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+{
+    return transposeFloat(dest, src, srcSamples);
+}
+
+
+// Converts the whole input batch to floating point, transposes it, and converts
+// the result back to integers. 'dest' has room for as many output sample frames
+// as 'TransposerBase::transpose' reserves.
+int FloatTransposerAdapter::transposeFloat(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+{
+    int srcSize = srcSamples * numChannels;
+    int destSize = ((int)((double)srcSamples / rate) + 8) * numChannels;
+    int numOutput;
+
+    if (srcSize > floatSrcSize)
+    {
+        delete[] floatSrc;
+        floatSrc = new float[srcSize];
+        floatSrcSize = srcSize;
+    }
+    if (destSize > floatDestSize)
+    {
+        delete[] floatDest;
+        floatDest = new float[destSize];
+        floatDestSize = destSize;
+    }
+
+    toFloat(floatSrc, src, srcSize);
+    numOutput = pTransposer->transpose(floatDest, floatSrc, srcSamples);
+    assert(numOutput * numChannels <= destSize);
+    toShort(dest, floatDest, numOutput * numChannels);
+
+    return numOutput;
+}
+
+
+void FloatTransposerAdapter::toFloat(float *dest, const short *src, int count) const
+{
+    for (int i = 0; i < count; i ++)
+    {
+        dest[i] = (float)src[i];
+    }
+}
+
+
+void FloatTransposerAdapter::toShort(short *dest, const float *src, int count) const
+{
+    for (int i = 0; i < count; i ++)
+    {
+        float value = src[i];
+
+        value += (value >= 0) ? 0.5f : -0.5f;
+        if (value > 32767.0f) value = 32767.0f;
+        if (value < -32768.0f) value = -32768.0f;
+        dest[i] = (short)value;
+    }
+}
+
+#endif // SOUNDTOUCH_INTEGER_SAMPLES
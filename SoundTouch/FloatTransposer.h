@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Base class for the transposers that interpolate floating point samples, 
+/// and an adapter that makes them usable with 16bit integer samples.
+///
+/// In the floating point build the floating point transposers are ordinary 
+/// 'TransposerBase' implementations. In the integer build they can't take the
+/// integer samples directly, so 'FloatTransposerAdapter' converts the input 
+/// samples to floating point, runs the transposer, and converts the result 
+/// back to integers with rounding & saturation. The samples get converted a 
+/// whole input batch at a time, so that the conversions cost only a couple of 
+/// operations per sample compared to the interpolation itself.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef _FloatTransposer_H_
+#define _FloatTransposer_H_
+
+#include "RateTransposer.h"
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+
+/// Base class for transposers that process floating point samples in the 
+/// integer build. Same interface as in 'TransposerBase' apart from the sample 
+/// type.
+class FloatTransposer
+{
+protected:
+    virtual void resetRegisters() = 0;
+
+    virtual int transposeMono(float *dest, 
+                        const float *src, 
+                        int &srcSamples) = 0;
+    virtual int transposeStereo(float *dest, 
+                        const float *src, 
+                        int &srcSamples) = 0;
+    virtual int transposeMulti(float *dest, 
+                        const float *src, 
+                        int &srcSamples) = 0;
+
+public:
+    double rate;
+    int numChannels;
+
+    FloatTransposer();
+    virtual ~FloatTransposer();
+
+    /// Transposes 'srcSamples' sample frames from 'src' to 'dest'. Returns the 
+    /// number of output sample frames, and updates 'srcSamples' to the number of
+    /// consumed source sample frames.
+    int transpose(float *dest, const float *src, int &srcSamples);
+
+    virtual void setRate(double newRate);
+    virtual void setChannels(int channels);
+
+    /// See 'TransposerBase::getPosition' & 'TransposerBase::setPosition'
+    virtual double getPosition() const;
+    virtual int setPosition(double position);
+};
+
+
+/// Integer sample transposer that runs a floating point transposer between
+/// conversions of the samples.
+class FloatTransposerAdapter : public TransposerBase
+{
+protected:
+    /// The floating point transposer, owned by this object
+    FloatTransposer *pTransposer;
+
+    /// Work buffers for the input & output samples converted to floating point
+    float *floatSrc;
+    float *floatDest;
+    int floatSrcSize;
+    int floatDestSize;
+
+    virtual void resetRegisters();
+
+    virtual int transposeMono(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+    virtual int transposeStereo(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+    virtual int transposeMulti(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+
+    /// Transposes the samples through the floating point transposer
+    int transposeFloat(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples);
+
+    /// Converts 'count' samples from integer to floating point
+    virtual void toFloat(float *dest, const short *src, int count) const;
+
+    /// Converts 'count' samples from floating point to integer, with rounding
+    /// and saturation to 16 bit range
+    virtual void toShort(short *dest, const float *src, int count) const;
+
+public:
+    /// Takes the ownership of 'transposer'
+    FloatTransposerAdapter(FloatTransposer *transposer);
+    virtual ~FloatTransposerAdapter();
+
+    virtual void setRate(double newRate);
+    virtual void setChannels(int channels);
+    virtual double getPosition() const;
+    virtual int setPosition(double position);
+
+    /// Returns adapter for 'transposer' with the sample conversions optimized
+    /// for the CPU
+    static FloatTransposerAdapter *newInstance(FloatTransposer *transposer);
+};
+
+
+#if defined(SOUNDTOUCH_ALLOW_SSE41) && defined(SOUNDTOUCH_ALLOW_MMX)
+    /// Class that implements SSE4.1 optimized sample conversions.
+    class FloatTransposerAdapterSSE41 : public FloatTransposerAdapter
+    {
+    protected:
+        virtual void toFloat(float *dest, const short *src, int count) const;
+        virtual void toShort(short *dest, const float *src, int count) const;
+
+    public:
+        FloatTransposerAdapterSSE41(FloatTransposer *transposer);
+    };
+
+#endif // SOUNDTOUCH_ALLOW_SSE41
+
+#else
+
+/// In the floating point build the floating point transposers process the 
+/// samples directly
+typedef TransposerBase FloatTransposer;
+
+#endif // SOUNDTOUCH_INTEGER_SAMPLES
+
+}
+
+#endif
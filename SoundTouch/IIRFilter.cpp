@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Low-pass IIR filter realized as a cascade of second-order sections 
+/// (biquads), designed as a Butterworth filter with bilinear transform.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <memory.h>
+#include <assert.h>
+#include <math.h>
+#include "IIRFilter.h"
+#include "cpu_detect.h"
+
+using namespace soundtouch;
+
+#define PI 3.14159265358979323846
+
+/*****************************************************************************
+ *
+ * Implementation of the class 'IIRFilter'
+ *
+ *****************************************************************************/
+
+IIRFilter::IIRFilter()
+{
+    numSections = 0;
+    cutoff = 0;
+    targetCutoff = 0;
+    rampSteps = 0;
+    numChannels = 0;
+    stride = 0;
+    state = NULL;
+    stateUnalign = NULL;
+    memset(coeffs, 0, sizeof(coeffs));
+}
+
+
+IIRFilter::~IIRFilter()
+{
+    delete[] stateUnalign;
+}
+
+
+// Designs a Butterworth low-pass filter with bilinear transform. The analog 
+// prototype's poles are paired to second-order sections, each of which gets
+// unity gain at DC.
+//
+// The sections are state variable filters discretized with the trapezoidal 
+// rule, which is equal to the bilinear transform. Unlike in the direct form 
+// sections, the state variables are the integrator outputs, i.e. they don't 
+// depend on the coefficients, so that the cut-off frequency can be ramped to a
+// new value while filtering without a transient.
+void IIRFilter::setLowpass(double cutoffFreq, int order)
+{
+    assert(order > 0);
+    assert(order % 2 == 0);
+    assert(order <= 2 * IIR_MAX_SECTIONS);
+    assert(cutoffFreq > 0);
+    assert(cutoffFreq < 0.5);
+
+    targetCutoff = cutoffFreq;
+    if (numSections != order / 2)
+    {
+        // the filter structure changes, so the old state isn't valid any more
+        numSections = order / 2;
+        clear();
+        cutoff = cutoffFreq;
+        rampSteps = 0;
+        calcCoeffs(cutoff);
+    }
+    else if (targetCutoff != cutoff)
+    {
+        // ramp the frequency to the new value in 'evaluate'
+        rampSteps = IIR_RAMP_STEPS;
+    }
+}
+
+
+// With 'g' the pre-warped cut-off frequency and 'k = 1 / q' the damping of the 
+// section, the coefficients of the section are:
+//   a1 = 1 / (1 + g * (g + k)), a2 = g * a1, a3 = g * a2
+void IIRFilter::calcCoeffs(double cutoffFreq)
+{
+    double g;
+    int i;
+
+    // pre-warp the cut-off frequency for the bilinear transform
+    g = tan(PI * cutoffFreq);
+
+    for (i = 0; i < numSections; i ++)
+    {
+        // damping, i.e. 1 / quality factor, of the i'th pole pair of the 
+        // Butterworth prototype
+        double k = 2.0 * cos(PI * (2 * i + 1) / (4.0 * numSections));
+        double a1 = 1.0 / (1.0 + g * (g + k));
+        float *c = coeffs + 3 * i;
+
+        c[0] = (float)a1;
+        c[1] = (float)(g * a1);
+        c[2] = (float)(g * g * a1);
+    }
+}
+
+
+void IIRFilter::setChannels(int channels)
+{
+    assert(channels > 0);
+
+    numChannels = channels;
+    stride = (channels + 3) & ~3;
+
+    delete[] stateUnalign;
+    stateUnalign = new float[2 * IIR_MAX_SECTIONS * stride + 4];
+    state = (float *)SOUNDTOUCH_ALIGN_POINTER_16(stateUnalign);
+    clear();
+}
+
+
+void IIRFilter::clear()
+{
+    // without past samples there's no transient to avoid by ramping
+    if (rampSteps > 0)
+    {
+        cutoff = targetCutoff;
+        rampSteps = 0;
+        calcCoeffs(cutoff);
+    }
+
+    if (state == NULL) return;
+    memset(state, 0, 2 * IIR_MAX_SECTIONS * stride * sizeof(float));
+}
+
+
+// Applies the filter. The output sample count equals to the input sample count,
+// as the IIR filter needs no extra input samples ahead. If the cut-off frequency
+// is being ramped, the first samples get filtered in short batches, moving the 
+// frequency geometrically towards the target between the batches.
+uint IIRFilter::evaluate(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint channels)
+{
+    uint count, done;
+
+    assert(numSections > 0);
+    assert(src != NULL);
+    assert(dest != NULL);
+
+    if ((int)channels != numChannels)
+    {
+        setChannels((int)channels);
+    }
+
+    done = 0;
+    while ((rampSteps > 0) && (done < numSamples))
+    {
+        cutoff *= pow(targetCutoff / cutoff, 1.0 / rampSteps);
+        rampSteps --;
+        if (rampSteps == 0) cutoff = targetCutoff;
+        calcCoeffs(cutoff);
+
+        count = numSamples - done;
+        if (count > IIR_RAMP_LENGTH) count = IIR_RAMP_LENGTH;
+        evaluateChannels(dest + done * channels, src + done * channels, count);
+        done += count;
+    }
+    if (numSamples > done)
+    {
+        evaluateChannels(dest + done * channels, src + done * channels, numSamples - done);
+    }
+    return numSamples;
+}
+
+
+// Usual C-version of the filter routine. Filters each channel at a time through
+// the cascade of state variable filter sections.
+void IIRFilter::evaluateChannels(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples)
+{
+    int c;
+
+    for (c = 0; c < numChannels; c ++)
+    {
+        float z1[IIR_MAX_SECTIONS], z2[IIR_MAX_SECTIONS];
+        uint j;
+        int s;
+
+        for (s = 0; s < numSections; s ++)
+        {
+            z1[s] = state[2 * s * stride + c];
+            z2[s] = state[(2 * s + 1) * stride + c];
+        }
+
+        for (j = 0; j < numSamples; j ++)
+        {
+            float x = (float)src[j * numChannels + c] + IIR_ANTI_DENORMAL;
+
+            for (s = 0; s < numSections; s ++)
+            {
+                const float *cf = coeffs + 3 * s;
+                float v3 = x - z2[s];
+                float v1 = cf[0] * z1[s] + cf[1] * v3;
+                float v2 = z2[s] + cf[1] * z1[s] + cf[2] * v3;
+
+                // update the integrator states, the low-pass output is 'v2'
+                z1[s] = 2 * v1 - z1[s];
+                z2[s] = 2 * v2 - z2[s];
+                x = v2;
+            }
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+            // round & saturate to 16 bit integer limits
+            x += (x >= 0) ? 0.5f : -0.5f;
+            x = (x < -32768.0f) ? -32768.0f : (x > 32767.0f) ? 32767.0f : x;
+#endif // SOUNDTOUCH_INTEGER_SAMPLES
+            dest[j * numChannels + c] = (SAMPLETYPE)x;
+        }
+
+        for (s = 0; s < numSections; s ++)
+        {
+            state[2 * s * stride + c] = z1[s];
+            state[(2 * s + 1) * stride + c] = z2[s];
+        }
+    }
+}
+
+
+// Operator 'new' is overloaded so that it automatically creates a suitable instance 
+// depending on if we've a MMX/SSE/etc-capable CPU available or not.
+void * IIRFilter::operator new(size_t /*s*/)
+{
+    // Notice! don't use "new IIRFilter" directly, use "newInstance" to create a new instance instead!
+    ST_THROW_RT_ERROR("Error in IIRFilter::new: Don't use 'new IIRFilter', use 'newInstance' member instead!");
+    return newInstance();
+}
+
+
+IIRFilter * IIRFilter::newInstance()
+{
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    uint uExtensions;
+
+    uExtensions = detectCPUextensions();
+
+    // Check if SSE instruction set extension is supported by the CPU
+    if (uExtensions & SUPPORT_SSE)
+    {
+        // SSE support
+        return ::new IIRFilterSSE;
+    }
+#endif // SOUNDTOUCH_ALLOW_SSE
+
+    // ISA optimizations not supported, use plain C version
+    return ::new IIRFilter;
+}
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Low-pass IIR filter realized as a cascade of second-order sections 
+/// (biquads), designed as a Butterworth filter with bilinear transform. Used as
+/// a low-latency alternative to the FIR anti-alias filter: the filter doesn't
+/// buffer input samples, and needs only few multiplications per sample. Unlike 
+/// the FIR filter, the IIR filter isn't linear-phase.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _IIRFilter_H_
+#define _IIRFilter_H_
+
+#include <stddef.h>
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+/// Maximum number of second-order sections, i.e. maximum filter order / 2
+#define IIR_MAX_SECTIONS    8
+
+/// Tiny offset added to the input to prevent the filter state from decaying to 
+/// denormal floats in silence, which would be very slow to process
+#define IIR_ANTI_DENORMAL   1e-18f
+
+/// When the cut-off frequency changes, it's moved to the new value in this many
+/// steps of IIR_RAMP_LENGTH sample frames each, so that the filter delay doesn't 
+/// jump abruptly
+#define IIR_RAMP_STEPS      16
+#define IIR_RAMP_LENGTH     16
+
+class IIRFilter
+{
+protected:
+    /// Number of second-order sections
+    int numSections;
+
+    /// Coefficients of the sections, in order a1, a2, a3 for each section, see 
+    /// 'setLowpass'
+    float coeffs[3 * IIR_MAX_SECTIONS];
+
+    /// Cut-off frequency that the coefficients are calculated for, the frequency
+    /// given to 'setLowpass', and number of steps left for reaching it
+    double cutoff;
+    double targetCutoff;
+    int rampSteps;
+
+    /// Number of channels that the filter state is allocated for
+    int numChannels;
+
+    /// Channel count rounded up to multiple of 4, i.e. the state array row length
+    int stride;
+
+    /// Filter state of the sections, i.e. the integrator states 'ic1eq' & 'ic2eq'.
+    /// The array has two rows of 'stride' items for each section, each row having
+    /// the state variable of all channels in consecutive order. Aligned to 16 bytes.
+    float *state;
+    float *stateUnalign;
+
+    /// Allocates & clears the filter state for given number of channels
+    void setChannels(int channels);
+
+    /// Calculates the coefficients of the sections for cut-off frequency 
+    /// 'cutoffFreq'
+    void calcCoeffs(double cutoffFreq);
+
+    virtual void evaluateChannels(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples);
+
+public:
+    IIRFilter();
+    virtual ~IIRFilter();
+
+    /// Operator 'new' is overloaded so that it automatically creates a suitable instance 
+    /// depending on if we've a MMX/SSE/etc-capable CPU available or not.
+    static void * operator new(size_t s);
+
+    static IIRFilter *newInstance();
+
+    /// Designs a Butterworth low-pass filter of given order with cut-off edge 
+    /// frequency 'cutoffFreq' scaled to sampling frequency (nyquist frequency = 
+    /// 0.5). The cut-off frequency is the -3dB point of the response. 'order' 
+    /// needs to be even, max. 2 * IIR_MAX_SECTIONS. When only the cut-off 
+    /// frequency changes, the filter state is kept, and the frequency is ramped
+    /// to the new value over IIR_RAMP_STEPS * IIR_RAMP_LENGTH sample frames.
+    void setLowpass(double cutoffFreq, int order);
+
+    /// Clears the filter state, i.e. the past input samples
+    void clear();
+
+    /// Applies the filter to 'numSamples' sample frames in 'src', and writes the
+    /// result to 'dest'. Returns the number of output sample frames, which is
+    /// equal to 'numSamples'.
+    uint evaluate(SAMPLETYPE *dest, 
+                  const SAMPLETYPE *src, 
+                  uint numSamples, 
+                  uint numChannels);
+};
+
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    /// Class that implements SSE optimized IIR filter routine for floating point 
+    /// samples type. Processes four channels in parallel.
+    class IIRFilterSSE : public IIRFilter
+    {
+    protected:
+        virtual void evaluateChannels(float *dest, const float *src, uint numSamples);
+    };
+
+#endif // SOUNDTOUCH_ALLOW_SSE
+
+}
+
+#endif // _IIRFilter_H_
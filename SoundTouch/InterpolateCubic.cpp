@@ -41,7 +41,7 @@
 using namespace soundtouch;
 
 // cubic interpolation coefficients
-static const float _coeffs[]= 
+const float InterpolateCubic::_coeffs[16] = 
 { -0.5f,  1.0f, -0.5f, 0.0f,
    1.5f, -2.5f,  0.0f, 1.0f,
   -1.5f,  2.0f,  0.5f, 0.0f,
@@ -60,10 +60,26 @@ void InterpolateCubic::resetRegisters()
 }
 
 
+// The output sample frame is 'fract' after the second source sample frame
+double InterpolateCubic::getPosition() const
+{
+    return 1.0 + fract;
+}
+
+
+int InterpolateCubic::setPosition(double position)
+{
+    int whole = (int)floor(position - 1.0);
+
+    fract = position - 1.0 - whole;
+    return whole;
+}
+
+
 /// Transpose mono audio. Returns number of produced output samples, and 
 /// updates "srcSamples" to amount of consumed source samples
-int InterpolateCubic::transposeMono(SAMPLETYPE *pdest, 
-                    const SAMPLETYPE *psrc, 
+int InterpolateCubic::transposeMono(float *pdest, 
+                    const float *psrc, 
                     int &srcSamples)
 {
     int i;
@@ -89,7 +105,7 @@ int InterpolateCubic::transposeMono(SAMPLETYPE *pdest,
 
         out = y0 * psrc[0] + y1 * psrc[1] + y2 * psrc[2] + y3 * psrc[3];
 
-        pdest[i] = (SAMPLETYPE)out;
+        pdest[i] = out;
         i ++;
 
         // update position fraction
@@ -107,8 +123,8 @@ int InterpolateCubic::transposeMono(SAMPLETYPE *pdest,
 
 /// Transpose stereo audio. Returns number of produced output samples, and 
 /// updates "srcSamples" to amount of consumed source samples
-int InterpolateCubic::transposeStereo(SAMPLETYPE *pdest, 
-                    const SAMPLETYPE *psrc, 
+int InterpolateCubic::transposeStereo(float *pdest, 
+                    const float *psrc, 
                     int &srcSamples)
 {
     int i;
@@ -135,8 +151,8 @@ int InterpolateCubic::transposeStereo(SAMPLETYPE *pdest,
         out0 = y0 * psrc[0] + y1 * psrc[2] + y2 * psrc[4] + y3 * psrc[6];
         out1 = y0 * psrc[1] + y1 * psrc[3] + y2 * psrc[5] + y3 * psrc[7];
 
-        pdest[2*i]   = (SAMPLETYPE)out0;
-        pdest[2*i+1] = (SAMPLETYPE)out1;
+        pdest[2*i]   = out0;
+        pdest[2*i+1] = out1;
         i ++;
 
         // update position fraction
@@ -152,12 +168,15 @@ int InterpolateCubic::transposeStereo(SAMPLETYPE *pdest,
 }
 
 
-/// Transpose multi-channel audio. Returns number of produced output samples, and 
-/// updates "srcSamples" to amount of consumed source samples
-int InterpolateCubic::transposeMulti(SAMPLETYPE *pdest, 
-                    const SAMPLETYPE *psrc, 
+/// Transpose multi-channel audio of 'CHANNELS' channels, or of 'numChannels'
+/// channels if 'CHANNELS' is zero. Returns number of produced output samples,
+/// and updates "srcSamples" to amount of consumed source samples
+template <int CHANNELS>
+int InterpolateCubic::transposeChannels(float *pdest, 
+                    const float *psrc, 
                     int &srcSamples)
 {
+    const int channels = (CHANNELS > 0) ? CHANNELS : numChannels;
     int i;
     int srcSampleEnd = srcSamples - 4;
     int srcCount = 0;
@@ -178,11 +197,11 @@ int InterpolateCubic::transposeMulti(SAMPLETYPE *pdest,
         y2 =  _coeffs[8] * x0 +  _coeffs[9] * x1 + _coeffs[10] * x2 + _coeffs[11] * x3;
         y3 = _coeffs[12] * x0 + _coeffs[13] * x1 + _coeffs[14] * x2 + _coeffs[15] * x3;
 
-        for (int c = 0; c < numChannels; c ++)
+        for (int c = 0; c < channels; c ++)
         {
             float out;
-            out = y0 * psrc[c] + y1 * psrc[c + numChannels] + y2 * psrc[c + 2 * numChannels] + y3 * psrc[c + 3 * numChannels];
-            pdest[0] = (SAMPLETYPE)out;
+            out = y0 * psrc[c] + y1 * psrc[c + channels] + y2 * psrc[c + 2 * channels] + y3 * psrc[c + 3 * channels];
+            pdest[0] = out;
             pdest ++;
         }
         i ++;
@@ -192,9 +211,39 @@ int InterpolateCubic::transposeMulti(SAMPLETYPE *pdest,
         // update whole positions
         int whole = (int)fract;
         fract -= whole;
-        psrc += numChannels*whole;
+        psrc += channels*whole;
         srcCount += whole;
     }
     srcSamples = srcCount;
     return i;
 }
+
+
+/// Transpose multi-channel audio. Returns number of produced output samples, and 
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolateCubic::transposeMulti(float *pdest, 
+                    const float *psrc, 
+                    int &srcSamples)
+{
+    // the common channel counts have the channel loops fixed at compile time
+    switch (numChannels)
+    {
+        case 1:
+            return transposeChannels<1>(pdest, psrc, srcSamples);
+
+        case 2:
+            return transposeChannels<2>(pdest, psrc, srcSamples);
+
+        case 4:
+            return transposeChannels<4>(pdest, psrc, srcSamples);
+
+        case 6:
+            return transposeChannels<6>(pdest, psrc, srcSamples);
+
+        case 8:
+            return transposeChannels<8>(pdest, psrc, srcSamples);
+
+        default:
+            return transposeChannels<0>(pdest, psrc, srcSamples);
+    }
+}
@@ -36,32 +36,61 @@
 #ifndef _InterpolateCubic_H_
 #define _InterpolateCubic_H_
 
-#include "RateTransposer.h"
+#include "FloatTransposer.h"
 #include "STTypes.h"
 
 namespace soundtouch
 {
 
-class InterpolateCubic : public TransposerBase
+class InterpolateCubic : public FloatTransposer
 {
 protected:
     virtual void resetRegisters();
-    virtual int transposeMono(SAMPLETYPE *dest, 
-                        const SAMPLETYPE *src, 
+    virtual int transposeMono(float *dest, 
+                        const float *src, 
                         int &srcSamples);
-    virtual int transposeStereo(SAMPLETYPE *dest, 
-                        const SAMPLETYPE *src, 
+    virtual int transposeStereo(float *dest, 
+                        const float *src, 
                         int &srcSamples);
-    virtual int transposeMulti(SAMPLETYPE *dest, 
-                        const SAMPLETYPE *src, 
+    virtual int transposeMulti(float *dest, 
+                        const float *src, 
+                        int &srcSamples);
+
+    /// 'transposeMulti' for 'CHANNELS' channels, or for 'numChannels' channels 
+    /// if 'CHANNELS' is zero
+    template <int CHANNELS> int transposeChannels(float *dest, 
+                        const float *src, 
                         int &srcSamples);
 
     double fract;
 
+    /// cubic interpolation coefficients
+    static const float _coeffs[16];
+
 public:
     InterpolateCubic();
+
+    virtual double getPosition() const;
+    virtual int setPosition(double position);
 };
 
+
+#ifdef SOUNDTOUCH_ALLOW_FLOAT_SSE
+    /// Class that implements SSE optimized cubic interpolation for floating point 
+    /// samples type. Calculates four output sample frames at a time.
+    class InterpolateCubicSSE : public InterpolateCubic
+    {
+    protected:
+        virtual int transposeMono(float *dest, 
+                            const float *src, 
+                            int &srcSamples);
+        virtual int transposeStereo(float *dest, 
+                            const float *src, 
+                            int &srcSamples);
+    };
+
+#endif // SOUNDTOUCH_ALLOW_FLOAT_SSE
+
 }
 
 #endif
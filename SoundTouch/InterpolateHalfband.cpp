@@ -0,0 +1,373 @@
+////////////////////////////////////////////////////////////////////////////////
+/// 
+/// Sample rate transposer for exact octave changes, i.e. rate 2 or 1/2, using
+/// a half-band low-pass filter that does the anti-alias filtering and the 
+/// decimation or interpolation in one pass.
+///
+/// Half-band filter cuts off at quarter of the sampling frequency of the higher
+/// rate signal. Its impulse response is zero at every other tap except at the 
+/// center tap, so that:
+///
+/// - When decimating (rate 2), each output sample is the center input sample 
+///   times 0.5 plus the symmetric input sample pairs in between the zero taps
+///   times the nonzero coefficients, and only every other output sample gets 
+///   calculated.
+///
+/// - When interpolating (rate 1/2), every other output sample is the input 
+///   sample as such, and the ones in between are calculated from the input 
+///   sample pairs around them.
+///
+/// The nonzero taps form a symmetric FIR filter of '2 * halfTaps' taps, which
+/// is evaluated with the CPU-optimized 'FIRFilter' routines: when decimating,
+/// over the even input sample frames, and when interpolating, over all input 
+/// sample frames. Compared with the separate anti-alias filter and 
+/// interpolation, this takes several times less multiplications per output 
+/// sample.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <memory.h>
+#include <assert.h>
+#include "InterpolateHalfband.h"
+#include "FIRFilter.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+#define PI      3.141592653589793
+
+/// Minimum number of nonzero coefficient pairs
+#define HALFBAND_MIN_HALFTAPS   4
+
+
+// Saturates the integer samples to 16 bit limits
+static inline SAMPLETYPE saturate(LONG_SAMPLETYPE value)
+{
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    if (value > 32767) return 32767;
+    if (value < -32768) return -32768;
+#endif
+    return (SAMPLETYPE)value;
+}
+
+
+InterpolateHalfband::InterpolateHalfband()
+{
+    halfTaps = 0;
+    aaLength = 64;
+    bMidFirst = false;
+    pFIR = NULL;
+    coeffRate = 0;
+    pWork = NULL;
+    workSize = 0;
+    rate = 2.0;
+}
+
+
+InterpolateHalfband::~InterpolateHalfband()
+{
+    delete pFIR;
+    delete[] pWork;
+}
+
+
+void InterpolateHalfband::resetRegisters()
+{
+    // no other state between the calls, the input buffer keeps the filter history
+    bMidFirst = false;
+}
+
+
+// Returns true if the rate is 2 or 1/2, allowing for rounding errors in 
+// calculating the rate e.g. from octaves
+bool InterpolateHalfband::isHalfbandRate(double rate)
+{
+    return (fabs(rate - 2.0) < 1e-9) || (fabs(rate - 0.5) < 1e-9);
+}
+
+
+void InterpolateHalfband::setRate(double newRate)
+{
+    assert(isHalfbandRate(newRate));
+    TransposerBase::setRate((newRate > 1.0) ? 2.0 : 0.5);
+}
+
+
+// Sets the filter length. The half-band filter is the anti-alias filter, so it
+// can't be disabled. The filter with 'length' taps has about 'length / 4' nonzero 
+// coefficient pairs, which gives about the same transition band width as the 
+// 'length' tap anti-alias filter has.
+void InterpolateHalfband::setAAFilter(bool /*enable*/, int length)
+{
+    aaLength = length;
+}
+
+
+bool InterpolateHalfband::hasAAFilter() const
+{
+    return true;
+}
+
+
+// When decimating, the output sample frame is at the center tap of the filter, 
+// i.e. after the tap '2 * halfTaps - 1'. When interpolating, the output sample 
+// frame is the input sample frame 'halfTaps - 1', or halfway to the next one.
+double InterpolateHalfband::getPosition() const
+{
+    int numHalfTaps = getHalfTaps();
+
+    if (rate > 1.0)
+    {
+        return (double)(2 * numHalfTaps - 1);
+    }
+    return (double)(numHalfTaps - 1) + (bMidFirst ? 0.5 : 0.0);
+}
+
+
+int InterpolateHalfband::setPosition(double position)
+{
+    int numHalfTaps = getHalfTaps();
+    int whole;
+
+    if (rate > 1.0)
+    {
+        return (int)floor(position - (2 * numHalfTaps - 1) + 0.5);
+    }
+
+    // round to the nearest half input sample frame
+    int halfSteps = (int)floor(2.0 * (position - (numHalfTaps - 1)) + 0.5);
+    whole = (int)floor(0.5 * halfSteps);
+    bMidFirst = (halfSteps != 2 * whole);
+    return whole;
+}
+
+
+// Returns the number of nonzero coefficient pairs for the anti-alias filter length
+int InterpolateHalfband::getHalfTaps() const
+{
+    int numHalfTaps = (aaLength / 16) * 4;
+
+    return (numHalfTaps < HALFBAND_MIN_HALFTAPS) ? HALFBAND_MIN_HALFTAPS : numHalfTaps;
+}
+
+
+// Designs the half-band filter: a Hamming-windowed sinc with cut-off at quarter
+// of the sampling frequency, same as 'AAFilter' designs, but keeping only the 
+// nonzero taps besides the center tap. These make the FIR filter of 
+// '2 * halfTaps' taps, 'halfTaps' being divisible by 4 so that the FIR length is
+// divisible by 8. When interpolating, the taps get gain 2 to compensate for the 
+// zero samples in between the input samples. The filter is redesigned only if
+// the length or the rate changes.
+void InterpolateHalfband::calcCoeffs()
+{
+    int newHalfTaps, k, length;
+    double sum, gain;
+    double *work;
+    SAMPLETYPE *coeffs;
+
+    newHalfTaps = getHalfTaps();
+    if ((newHalfTaps == halfTaps) && (rate == coeffRate)) return;
+
+    if (newHalfTaps != halfTaps)
+    {
+        // FIR implementation depends on the length
+        delete pFIR;
+        pFIR = FIRFilter::newInstance(2 * newHalfTaps);
+    }
+    halfTaps = newHalfTaps;
+    coeffRate = rate;
+    length = 4 * halfTaps - 1;
+
+    work = new double[halfTaps];
+    sum = 0;
+    for (k = 0; k < halfTaps; k ++)
+    {
+        // distance of the tap from the center tap
+        double t = (double)(2 * k + 1);
+        double x = 0.5 * PI * t;
+        double h = 0.5 * sin(x) / x;                                // sinc function
+        double w = 0.54 + 0.46 * cos(2.0 * PI * t / (length + 1));  // hamming window
+
+        work[k] = h * w;
+        sum += 2.0 * h * w;
+    }
+
+    // center tap 0.5 and the pairs give the DC gain; scale the pairs so that
+    // the gain is exactly 1. Scale the result so that it can be divided by 16384,
+    // as with the anti-alias filter.
+    gain = (rate < 1.0) ? 2.0 : 1.0;
+    coeffs = new SAMPLETYPE[2 * halfTaps];
+    for (k = 0; k < halfTaps; k ++)
+    {
+        double temp = work[k] * 0.5 / sum * gain * 16384.0;
+
+        // round to nearest integer
+        temp += (temp >= 0) ? 0.5 : -0.5;
+
+        // the FIR taps are the pairs in the order of the input samples
+        coeffs[halfTaps - 1 - k] = (SAMPLETYPE)(int)temp;
+        coeffs[halfTaps + k] = (SAMPLETYPE)(int)temp;
+    }
+    pFIR->setCoefficients(coeffs, 2 * halfTaps, 14);
+
+    delete[] coeffs;
+    delete[] work;
+}
+
+
+// Ensures that the work buffer has room for 'numSamples' sample frames
+SAMPLETYPE *InterpolateHalfband::getWork(int numSamples)
+{
+    if (numSamples * numChannels > workSize)
+    {
+        delete[] pWork;
+        workSize = numSamples * numChannels;
+        pWork = new SAMPLETYPE[workSize];
+    }
+    return pWork;
+}
+
+
+// Decimates by 2. Output sample frame 'i' is the center input sample frame
+// '2 * i + 2 * halfTaps - 1' times 0.5, plus the FIR filter result from the even
+// input sample frames '2 * i' ... '2 * i + 4 * halfTaps - 2'.
+int InterpolateHalfband::decimate(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+{
+    const SAMPLETYPE *center;
+    SAMPLETYPE *even;
+    int numEven, numOutput, i, c;
+
+    numEven = (srcSamples + 1) / 2;
+    if (numEven <= 2 * halfTaps)
+    {
+        srcSamples = 0;
+        return 0;
+    }
+
+    // gather the even input sample frames
+    even = getWork(numEven);
+    for (i = 0; i < numEven; i ++)
+    {
+        for (c = 0; c < numChannels; c ++)
+        {
+            even[i * numChannels + c] = src[2 * i * numChannels + c];
+        }
+    }
+
+    numOutput = (int)pFIR->evaluate(dest, even, numEven, numChannels);
+
+    center = src + (2 * halfTaps - 1) * numChannels;
+    for (i = 0; i < numOutput; i ++)
+    {
+        for (c = 0; c < numChannels; c ++)
+        {
+            LONG_SAMPLETYPE sum = (LONG_SAMPLETYPE)dest[i * numChannels + c] + 
+                                  center[2 * i * numChannels + c] / 2;
+            dest[i * numChannels + c] = saturate(sum);
+        }
+    }
+    srcSamples = 2 * numOutput;
+    return numOutput;
+}
+
+
+// Interpolates by 2. Each input sample frame produces two output sample frames:
+// the input sample frame as such, and the FIR filter result halfway to the 
+// next input sample frame.
+int InterpolateHalfband::interpolate(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+{
+    const SAMPLETYPE *prev;
+    SAMPLETYPE *mid;
+    int numInput, i, c;
+
+    if (srcSamples <= 2 * halfTaps)
+    {
+        srcSamples = 0;
+        return 0;
+    }
+
+    mid = getWork(srcSamples);
+    numInput = (int)pFIR->evaluate(mid, src, srcSamples, numChannels);
+
+    // the FIR output 'i' is between the input sample frames 'i + halfTaps - 1'
+    // and 'i + halfTaps'
+    prev = src + (halfTaps - 1) * numChannels;
+    for (i = 0; i < numInput; i ++)
+    {
+        for (c = 0; c < numChannels; c ++)
+        {
+            dest[2 * i * numChannels + c] = prev[i * numChannels + c];
+            dest[(2 * i + 1) * numChannels + c] = mid[i * numChannels + c];
+        }
+    }
+    srcSamples = numInput;
+
+    if (bMidFirst && (numInput > 0))
+    {
+        // start from the output sample frame halfway between the input sample frames
+        memmove(dest, dest + numChannels, (2 * numInput - 1) * numChannels * sizeof(SAMPLETYPE));
+        bMidFirst = false;
+        return 2 * numInput - 1;
+    }
+    return 2 * numInput;
+}
+
+
+/// Transpose mono audio. Returns number of produced output samples, and 
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolateHalfband::transposeMono(SAMPLETYPE *pdest, 
+                    const SAMPLETYPE *psrc, 
+                    int &srcSamples)
+{
+    return transposeMulti(pdest, psrc, srcSamples);
+}
+
+
+/// Transpose stereo audio. Returns number of produced output samples, and 
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolateHalfband::transposeStereo(SAMPLETYPE *pdest, 
+                    const SAMPLETYPE *psrc, 
+                    int &srcSamples)
+{
+    return transposeMulti(pdest, psrc, srcSamples);
+}
+
+
+/// Transpose multi-channel audio. Returns number of produced output samples, and 
+/// updates "srcSamples" to amount of consumed source samples. The FIR filter
+/// routines handle the channel count, so all the channel counts come here.
+int InterpolateHalfband::transposeMulti(SAMPLETYPE *pdest, 
+                    const SAMPLETYPE *psrc, 
+                    int &srcSamples)
+{
+    calcCoeffs();
+    if (rate > 1.0)
+    {
+        return decimate(pdest, psrc, srcSamples);
+    }
+    return interpolate(pdest, psrc, srcSamples);
+}
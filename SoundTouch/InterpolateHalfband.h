@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////////////
+/// 
+/// Sample rate transposer for exact octave changes, i.e. rate 2 or 1/2, using
+/// a half-band low-pass filter that does the anti-alias filtering and the 
+/// decimation or interpolation in one pass.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _InterpolateHalfband_H_
+#define _InterpolateHalfband_H_
+
+#include "RateTransposer.h"
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+class InterpolateHalfband : public TransposerBase
+{
+protected:
+    void resetRegisters();
+    int transposeMono(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+    int transposeStereo(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+    int transposeMulti(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+
+    /// Number of nonzero coefficient pairs on either side of the center tap. 
+    /// The half-band filter has '4 * halfTaps - 1' taps, of which every other 
+    /// is zero except the center tap.
+    int halfTaps;
+
+    /// Anti-alias filter length given by 'setAAFilter'
+    int aaLength;
+
+    /// When interpolating, true if the next output sample frame is the one halfway
+    /// between two input sample frames, see 'setPosition'
+    bool bMidFirst;
+
+    /// FIR filter of the nonzero taps besides the center tap, and the rate that
+    /// the coefficients are designed for
+    class FIRFilter *pFIR;
+    double coeffRate;
+
+    /// Work buffer for the FIR filter input or output
+    SAMPLETYPE *pWork;
+    int workSize;
+
+    void calcCoeffs();
+    int getHalfTaps() const;
+    SAMPLETYPE *getWork(int numSamples);
+
+    int decimate(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples);
+    int interpolate(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples);
+
+public:
+    InterpolateHalfband();
+    virtual ~InterpolateHalfband();
+
+    /// Sets rate, which needs to be 2 (decimation) or 0.5 (interpolation)
+    virtual void setRate(double newRate);
+    virtual void setAAFilter(bool enable, int length);
+    virtual bool hasAAFilter() const;
+    virtual double getPosition() const;
+
+    /// Sets the position within the resolution of the output: whole input sample 
+    /// frames when decimating, and half input sample frames when interpolating
+    virtual int setPosition(double position);
+
+    /// Returns true if 'rate' is such that this transposer can be used
+    static bool isHalfbandRate(double rate);
+};
+
+}
+
+#endif
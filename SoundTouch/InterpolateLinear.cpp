@@ -35,6 +35,7 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <math.h>
 #include "InterpolateLinear.h"
 
 using namespace soundtouch;
@@ -64,6 +65,22 @@ void InterpolateLinearInteger::resetRegisters()
 }
 
 
+// The output sample frame is 'iFract' after the first source sample frame
+double InterpolateLinearInteger::getPosition() const
+{
+    return (double)iFract / SCALE;
+}
+
+
+int InterpolateLinearInteger::setPosition(double position)
+{
+    int whole = (int)floor(position);
+
+    iFract = (int)((position - whole) * SCALE);
+    return whole;
+}
+
+
 // Transposes the sample rate of the given samples using linear interpolation. 
 // 'Mono' version of the routine. Returns the number of samples returned in 
 // the "dest" buffer
@@ -134,8 +151,13 @@ int InterpolateLinearInteger::transposeStereo(SAMPLETYPE *dest, const SAMPLETYPE
 }
 
 
-int InterpolateLinearInteger::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+/// Transpose multi-channel audio of 'CHANNELS' channels, or of 'numChannels'
+/// channels if 'CHANNELS' is zero. Returns number of produced output samples,
+/// and updates "srcSamples" to amount of consumed source samples
+template <int CHANNELS>
+int InterpolateLinearInteger::transposeChannels(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
 {
+    const int channels = (CHANNELS > 0) ? CHANNELS : numChannels;
     int i;
     int srcSampleEnd = srcSamples - 1;
     int srcCount = 0;
@@ -147,9 +169,9 @@ int InterpolateLinearInteger::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE
     
         assert(iFract < SCALE);
         vol1 = (SCALE - iFract);
-        for (int c = 0; c < numChannels; c ++)
+        for (int c = 0; c < channels; c ++)
         {
-            temp = vol1 * src[c] + iFract * src[c + numChannels];
+            temp = vol1 * src[c] + iFract * src[c + channels];
             dest[0] = (SAMPLETYPE)(temp / SCALE);
             dest ++;
         }
@@ -160,7 +182,7 @@ int InterpolateLinearInteger::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE
         int iWhole = iFract / SCALE;
         iFract -= iWhole * SCALE;
         srcCount += iWhole;
-        src += iWhole * numChannels;
+        src += iWhole * channels;
     }
     srcSamples = srcCount;
 
@@ -168,6 +190,32 @@ int InterpolateLinearInteger::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE
 }
 
 
+int InterpolateLinearInteger::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+{
+    // the common channel counts have the channel loops fixed at compile time
+    switch (numChannels)
+    {
+        case 1:
+            return transposeChannels<1>(dest, src, srcSamples);
+
+        case 2:
+            return transposeChannels<2>(dest, src, srcSamples);
+
+        case 4:
+            return transposeChannels<4>(dest, src, srcSamples);
+
+        case 6:
+            return transposeChannels<6>(dest, src, srcSamples);
+
+        case 8:
+            return transposeChannels<8>(dest, src, srcSamples);
+
+        default:
+            return transposeChannels<0>(dest, src, srcSamples);
+    }
+}
+
+
 // Sets new target iRate. Normal iRate = 1.0, smaller values represent slower 
 // iRate, larger faster iRates.
 void InterpolateLinearInteger::setRate(double newRate)
@@ -200,6 +248,22 @@ void InterpolateLinearFloat::resetRegisters()
 }
 
 
+// The output sample frame is 'fract' after the first source sample frame
+double InterpolateLinearFloat::getPosition() const
+{
+    return fract;
+}
+
+
+int InterpolateLinearFloat::setPosition(double position)
+{
+    int whole = (int)floor(position);
+
+    fract = position - whole;
+    return whole;
+}
+
+
 // Transposes the sample rate of the given samples using linear interpolation. 
 // 'Mono' version of the routine. Returns the number of samples returned in 
 // the "dest" buffer
@@ -266,8 +330,13 @@ int InterpolateLinearFloat::transposeStereo(SAMPLETYPE *dest, const SAMPLETYPE *
 }
 
 
-int InterpolateLinearFloat::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+/// Transpose multi-channel audio of 'CHANNELS' channels, or of 'numChannels'
+/// channels if 'CHANNELS' is zero. Returns number of produced output samples,
+/// and updates "srcSamples" to amount of consumed source samples
+template <int CHANNELS>
+int InterpolateLinearFloat::transposeChannels(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
 {
+    const int channels = (CHANNELS > 0) ? CHANNELS : numChannels;
     int i;
     int srcSampleEnd = srcSamples - 1;
     int srcCount = 0;
@@ -279,9 +348,9 @@ int InterpolateLinearFloat::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *s
     
         vol1 = (float)(1.0 - fract);
 		fract_float = (float)fract;
-        for (int c = 0; c < numChannels; c ++)
+        for (int c = 0; c < channels; c ++)
         {
-			temp = vol1 * src[c] + fract_float * src[c + numChannels];
+			temp = vol1 * src[c] + fract_float * src[c + channels];
             *dest = (SAMPLETYPE)temp;
             dest ++;
         }
@@ -292,9 +361,35 @@ int InterpolateLinearFloat::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *s
         int iWhole = (int)fract;
         fract -= iWhole;
         srcCount += iWhole;
-        src += iWhole * numChannels;
+        src += iWhole * channels;
     }
     srcSamples = srcCount;
 
     return i;
 }
+
+
+int InterpolateLinearFloat::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples)
+{
+    // the common channel counts have the channel loops fixed at compile time
+    switch (numChannels)
+    {
+        case 1:
+            return transposeChannels<1>(dest, src, srcSamples);
+
+        case 2:
+            return transposeChannels<2>(dest, src, srcSamples);
+
+        case 4:
+            return transposeChannels<4>(dest, src, srcSamples);
+
+        case 6:
+            return transposeChannels<6>(dest, src, srcSamples);
+
+        case 8:
+            return transposeChannels<8>(dest, src, srcSamples);
+
+        default:
+            return transposeChannels<0>(dest, src, srcSamples);
+    }
+}
@@ -58,12 +58,20 @@ protected:
                          const SAMPLETYPE *src, 
                          int &srcSamples);
     virtual int transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples);
+
+    /// 'transposeMulti' for 'CHANNELS' channels, or for 'numChannels' channels 
+    /// if 'CHANNELS' is zero
+    template <int CHANNELS> int transposeChannels(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples);
+
 public:
     InterpolateLinearInteger();
 
     /// Sets new target rate. Normal rate = 1.0, smaller values represent slower 
     /// rate, larger faster rates.
     virtual void setRate(double newRate);
+
+    virtual double getPosition() const;
+    virtual int setPosition(double position);
 };
 
 
@@ -83,10 +91,34 @@ protected:
                          int &srcSamples);
     virtual int transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples);
 
+    /// 'transposeMulti' for 'CHANNELS' channels, or for 'numChannels' channels 
+    /// if 'CHANNELS' is zero
+    template <int CHANNELS> int transposeChannels(SAMPLETYPE *dest, const SAMPLETYPE *src, int &srcSamples);
+
 public:
     InterpolateLinearFloat();
+
+    virtual double getPosition() const;
+    virtual int setPosition(double position);
 };
 
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    /// Class that implements SSE optimized linear interpolation for floating point 
+    /// samples type. Calculates four output sample frames at a time.
+    class InterpolateLinearFloatSSE : public InterpolateLinearFloat
+    {
+    protected:
+        virtual int transposeMono(SAMPLETYPE *dest, 
+                           const SAMPLETYPE *src, 
+                           int &srcSamples);
+        virtual int transposeStereo(SAMPLETYPE *dest, 
+                             const SAMPLETYPE *src, 
+                             int &srcSamples);
+    };
+
+#endif // SOUNDTOUCH_ALLOW_SSE
+
 }
 
 #endif
@@ -0,0 +1,475 @@
+////////////////////////////////////////////////////////////////////////////////
+/// 
+/// Sample rate transposer for rates that are ratios of small integers, such
+/// as 44100 -> 48000 Hz (rate 147/160). Uses an integer phase accumulator, so
+/// the output position is exact and doesn't drift over long streams, and a 
+/// precalculated windowed-sinc filter for each of the output phases, so the
+/// coefficients needn't be interpolated per output sample. The filter does 
+/// the anti-alias filtering and the interpolation in one step.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <math.h>
+#include <assert.h>
+#include "InterpolateRational.h"
+#include "FIRKernel.h"
+#include "cpu_detect.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+#define PI      3.141592653589793
+
+/// Maximum number of phases, i.e. denominator of the rate. Small enough that 
+/// only the common sample rate conversions, such as 147 / 160 for 44100 -> 
+/// 48000 Hz, use this transposer instead of the one chosen by 'setAlgorithm', 
+/// and that changing the rate doesn't rebuild large filter tables.
+#define RATIONAL_MAX_PHASES     160
+
+/// Relative tolerance of the rate to the ratio
+#define RATIONAL_TOLERANCE      1e-9
+
+/// Filter length used when the anti-alias filtering is disabled, i.e. for
+/// plain band-limited interpolation
+#define RATIONAL_MIN_TAPS       8
+
+
+InterpolateRational::InterpolateRational()
+{
+    step = 1;
+    numPhases = 1;
+    phase = 0;
+    span = 0;
+    taps = 0;
+    tapOffset = 0;
+    cutoff = 0;
+    coeffPhases = 0;
+    bUseAAFilter = true;
+    aaLength = 64;
+    pCoeffs = NULL;
+}
+
+
+InterpolateRational::~InterpolateRational()
+{
+    delete[] pCoeffs;
+}
+
+
+// Returns instance of the class with the filter routines optimized for the CPU
+InterpolateRational *InterpolateRational::newInstance()
+{
+    uint uExtensions = detectCPUextensions();
+
+#if defined(SOUNDTOUCH_ALLOW_SSE41) && defined(SOUNDTOUCH_ALLOW_MMX)
+    if ((uExtensions & SUPPORT_SSE41) && (uExtensions & SUPPORT_MMX))
+    {
+        return ::new InterpolateRationalSSE41;
+    }
+#endif // SOUNDTOUCH_ALLOW_SSE41
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    if (uExtensions & SUPPORT_SSE)
+    {
+        return ::new InterpolateRationalSSE;
+    }
+#endif // SOUNDTOUCH_ALLOW_SSE
+
+    return ::new InterpolateRational;
+}
+
+
+void InterpolateRational::resetRegisters()
+{
+    phase = 0;
+}
+
+
+// The output position is 'phase / numPhases' after the filter center
+double InterpolateRational::getPosition() const
+{
+    double center = (span > 0) ? (double)(span / 2 - 1) : 0.0;
+
+    return center + (double)phase / (double)numPhases;
+}
+
+
+// Sets the position rounded to the nearest phase
+int InterpolateRational::setPosition(double position)
+{
+    int whole;
+
+    if (taps == 0) calcCoeffs();
+    position -= span / 2 - 1;
+    whole = (int)floor(position);
+    phase = (int)floor((position - whole) * numPhases + 0.5);
+    if (phase >= numPhases)
+    {
+        phase -= numPhases;
+        whole ++;
+    }
+    return whole;
+}
+
+
+// Finds the ratio by continued fraction expansion of 'rate': the convergents 
+// 'num / den' of the expansion are the best approximations of 'rate' with
+// denominators up to 'den'.
+bool InterpolateRational::getRatio(double rate, int &num, int &den)
+{
+    double x = rate;
+    long num0 = 0, num1 = 1;
+    long den0 = 1, den1 = 0;
+
+    if (rate <= 0) return false;
+
+    while (1)
+    {
+        double a = floor(x);
+        long num2, den2;
+
+        if (a > RATIONAL_MAX_PHASES * 16) return false;
+        num2 = (long)a * num1 + num0;
+        den2 = (long)a * den1 + den0;
+        if (den2 > RATIONAL_MAX_PHASES) return false;
+
+        num0 = num1;
+        num1 = num2;
+        den0 = den1;
+        den1 = den2;
+        if (fabs(rate - (double)num1 / (double)den1) <= RATIONAL_TOLERANCE * rate)
+        {
+            num = (int)num1;
+            den = (int)den1;
+            return true;
+        }
+        x = 1.0 / (x - a);
+    }
+}
+
+
+bool InterpolateRational::isRationalRate(double rate)
+{
+    int num, den;
+
+    if (getRatio(rate, num, den) == false) return false;
+
+    // the unity rate doesn't drift, and needs no filtering
+    return (num != den);
+}
+
+
+void InterpolateRational::setRate(double newRate)
+{
+    int newStep, newPhases;
+
+    assert(isRationalRate(newRate));
+    if (getRatio(newRate, newStep, newPhases) == false) return;
+
+    // keep the current output position when the number of phases changes
+    phase = (int)((long)phase * newPhases / numPhases);
+    step = newStep;
+    numPhases = newPhases;
+
+    TransposerBase::setRate((double)step / (double)numPhases);
+    calcCoeffs();
+}
+
+
+// Sets the anti-alias filter length, or disables the anti-alias filtering 
+void InterpolateRational::setAAFilter(bool enable, int length)
+{
+    if ((enable == bUseAAFilter) && (length == aaLength)) return;
+
+    bUseAAFilter = enable;
+    aaLength = length;
+    calcCoeffs();
+}
+
+
+bool InterpolateRational::hasAAFilter() const
+{
+    return true;
+}
+
+
+// Designs the filters for the current rate & anti-alias filter settings. When
+// decimating, the cut-off is lowered to the output nyquist frequency; when 
+// interpolating, the filter length is scaled down by the rate, as that gives 
+// the same transition band as the anti-alias filter designed at the output 
+// sample rate. The filters are recalculated only if the number of phases, the
+// filter length or the cut-off frequency changes.
+void InterpolateRational::calcCoeffs()
+{
+    int newSpan, newTaps, p, k;
+    double newCutoff;
+    double *work;
+
+    if (bUseAAFilter)
+    {
+        newSpan = (aaLength > RATIONAL_MIN_TAPS) ? aaLength : RATIONAL_MIN_TAPS;
+        newSpan = (newSpan + 3) & ~3;
+        if (rate > 1.0)
+        {
+            // cut off frequencies above the nyquist frequency of the output
+            newTaps = newSpan;
+            newCutoff = 0.5 / rate;
+        }
+        else
+        {
+            // filter length in input samples, rounded up to divisible by 4
+            newTaps = ((int)(newSpan * rate) + 3) & ~3;
+            if (newTaps < RATIONAL_MIN_TAPS) newTaps = RATIONAL_MIN_TAPS;
+            if (newTaps > newSpan) newTaps = newSpan;
+            newCutoff = 0.5;
+        }
+    }
+    else
+    {
+        newSpan = newTaps = RATIONAL_MIN_TAPS;
+        newCutoff = 0.5;
+    }
+
+    if ((newSpan == span) && (newTaps == taps) && (newCutoff == cutoff) && 
+        (numPhases == coeffPhases)) return;
+
+    if ((newTaps != taps) || (numPhases != coeffPhases))
+    {
+        delete[] pCoeffs;
+        pCoeffs = new SAMPLETYPE[numPhases * newTaps];
+    }
+    span = newSpan;
+    taps = newTaps;
+    tapOffset = (span - taps) / 2;
+    cutoff = newCutoff;
+    coeffPhases = numPhases;
+
+    work = new double[taps];
+    for (p = 0; p < numPhases; p ++)
+    {
+        SAMPLETYPE *pPhase = pCoeffs + p * taps;
+        double sum = 0;
+
+        for (k = 0; k < taps; k ++)
+        {
+            // distance of the tap from the output position. Output position is 
+            // 'p / numPhases' after the tap 'taps / 2 - 1'.
+            double t = (double)(k - taps / 2 + 1) - (double)p / numPhases;
+            double x = 2.0 * PI * cutoff * t;
+            double h = (x != 0) ? sin(x) / x : 1.0;                   // sinc function
+            double w = 0.54 + 0.46 * cos(2.0 * PI * t / taps);        // hamming window
+
+            work[k] = h * w;
+            sum += h * w;
+        }
+
+        // normalize each phase to unity gain at DC
+        assert(sum > 0);
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+        {
+            long isum = 0;
+
+            for (k = 0; k < taps; k ++)
+            {
+                double value = work[k] / sum * (1 << RATIONAL_DIV_FACTOR);
+
+                pPhase[k] = (SAMPLETYPE)floor(value + 0.5);
+                isum += pPhase[k];
+            }
+            // put the rounding error to the nearest tap, so that the integer 
+            // coefficients sum exactly to the unity gain
+            pPhase[taps / 2 - 1 + ((2 * p >= numPhases) ? 1 : 0)] += (SAMPLETYPE)((1 << RATIONAL_DIV_FACTOR) - isum);
+        }
+#else
+        for (k = 0; k < taps; k ++)
+        {
+            pPhase[k] = (SAMPLETYPE)(work[k] / sum);
+        }
+#endif
+    }
+    delete[] work;
+}
+
+
+// Calculates one mono output sample
+void InterpolateRational::filterMono(SAMPLETYPE *dest, const SAMPLETYPE *src, const SAMPLETYPE *phase) const
+{
+    FIRSampleTraits<SAMPLETYPE>::AccuType sum = 0;
+
+    for (int k = 0; k < taps; k += 4)
+    {
+        FIRKernelStep<SAMPLETYPE, 1>::accumulate4(&sum, src + k, phase + k);
+    }
+    dest[0] = FIRSampleTraits<SAMPLETYPE>::toSample(sum, RATIONAL_DIV_FACTOR, 1.0);
+}
+
+
+// Calculates one stereo output sample frame
+void InterpolateRational::filterStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, const SAMPLETYPE *phase) const
+{
+    FIRSampleTraits<SAMPLETYPE>::AccuType sums[2] = {0, 0};
+
+    for (int k = 0; k < taps; k += 4)
+    {
+        FIRKernelStep<SAMPLETYPE, 2>::accumulate4(sums, src + 2 * k, phase + k);
+    }
+    dest[0] = FIRSampleTraits<SAMPLETYPE>::toSample(sums[0], RATIONAL_DIV_FACTOR, 1.0);
+    dest[1] = FIRSampleTraits<SAMPLETYPE>::toSample(sums[1], RATIONAL_DIV_FACTOR, 1.0);
+}
+
+
+/// Transpose multi-channel audio of 'CHANNELS' channels, or of 'numChannels'
+/// channels if 'CHANNELS' is zero. Returns number of produced output samples,
+/// and updates "srcSamples" to amount of consumed source samples
+template <int CHANNELS>
+int InterpolateRational::transposeChannels(SAMPLETYPE *pdest, 
+                    const SAMPLETYPE *psrc, 
+                    int &srcSamples)
+{
+    typedef FIRSampleTraits<SAMPLETYPE> Traits;
+    const int channels = (CHANNELS > 0) ? CHANNELS : numChannels;
+    const int wholeStep = step / numPhases;
+    const int phaseStep = step % numPhases;
+    int i, k, c;
+    int srcSampleEnd;
+    int srcCount = 0;
+
+    if (taps == 0) calcCoeffs();
+    srcSampleEnd = srcSamples - span;
+    psrc += channels * tapOffset;
+
+    i = 0;
+    while (srcCount < srcSampleEnd)
+    {
+        const SAMPLETYPE *pPhase = pCoeffs + phase * taps;
+        typename Traits::AccuType sums[CHANNELS > 0 ? CHANNELS : 1];
+
+        assert(phase < numPhases);
+        if (CHANNELS == 1)
+        {
+            filterMono(pdest, psrc, pPhase);
+        }
+        else if (CHANNELS == 2)
+        {
+            filterStereo(pdest, psrc, pPhase);
+        }
+        else if (CHANNELS > 0)
+        {
+            for (c = 0; c < CHANNELS; c ++)
+            {
+                sums[c] = 0;
+            }
+            for (k = 0; k < taps; k += 4)
+            {
+                FIRKernelStep<SAMPLETYPE, CHANNELS>::accumulate4(sums, psrc + k * CHANNELS, pPhase + k);
+            }
+            for (c = 0; c < CHANNELS; c ++)
+            {
+                pdest[c] = Traits::toSample(sums[c], RATIONAL_DIV_FACTOR, 1.0);
+            }
+        }
+        else
+        {
+            for (c = 0; c < channels; c ++)
+            {
+                const SAMPLETYPE *ptr = psrc + c;
+
+                sums[0] = 0;
+                for (k = 0; k < taps; k ++)
+                {
+                    sums[0] += ptr[k * channels] * pPhase[k];
+                }
+                pdest[c] = Traits::toSample(sums[0], RATIONAL_DIV_FACTOR, 1.0);
+            }
+        }
+        pdest += channels;
+        i ++;
+
+        // advance the position with the exact integer phase
+        int whole = wholeStep;
+        phase += phaseStep;
+        if (phase >= numPhases)
+        {
+            phase -= numPhases;
+            whole ++;
+        }
+        psrc += channels * whole;
+        srcCount += whole;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+/// Transpose mono audio. Returns number of produced output samples, and 
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolateRational::transposeMono(SAMPLETYPE *pdest, 
+                    const SAMPLETYPE *psrc, 
+                    int &srcSamples)
+{
+    return transposeChannels<1>(pdest, psrc, srcSamples);
+}
+
+
+/// Transpose stereo audio. Returns number of produced output samples, and 
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolateRational::transposeStereo(SAMPLETYPE *pdest, 
+                    const SAMPLETYPE *psrc, 
+                    int &srcSamples)
+{
+    return transposeChannels<2>(pdest, psrc, srcSamples);
+}
+
+
+/// Transpose multi-channel audio. Returns number of produced output samples, and 
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolateRational::transposeMulti(SAMPLETYPE *pdest, 
+                    const SAMPLETYPE *psrc, 
+                    int &srcSamples)
+{
+    // the common channel counts have the channel loops fixed at compile time
+    switch (numChannels)
+    {
+        case 1:
+            return transposeChannels<1>(pdest, psrc, srcSamples);
+
+        case 2:
+            return transposeChannels<2>(pdest, psrc, srcSamples);
+
+        case 4:
+            return transposeChannels<4>(pdest, psrc, srcSamples);
+
+        case 6:
+            return transposeChannels<6>(pdest, psrc, srcSamples);
+
+        case 8:
+            return transposeChannels<8>(pdest, psrc, srcSamples);
+
+        default:
+            return transposeChannels<0>(pdest, psrc, srcSamples);
+    }
+}
@@ -0,0 +1,155 @@
+////////////////////////////////////////////////////////////////////////////////
+/// 
+/// Sample rate transposer for rates that are ratios of small integers, such
+/// as 44100 -> 48000 Hz (rate 147/160). Uses an integer phase accumulator, so
+/// the output position is exact and doesn't drift over long streams, and a 
+/// precalculated windowed-sinc filter for each of the output phases, so the
+/// coefficients needn't be interpolated per output sample. The filter does 
+/// the anti-alias filtering and the interpolation in one step.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef _InterpolateRational_H_
+#define _InterpolateRational_H_
+
+#include "RateTransposer.h"
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    /// Integer filter coefficients are scaled by 2^RATIONAL_DIV_FACTOR
+    #define RATIONAL_DIV_FACTOR 14
+#else
+    #define RATIONAL_DIV_FACTOR 0
+#endif
+
+class InterpolateRational : public TransposerBase
+{
+protected:
+    void resetRegisters();
+    int transposeMono(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+    int transposeStereo(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+    int transposeMulti(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+
+    /// 'transposeMulti' for 'CHANNELS' channels, or for 'numChannels' channels 
+    /// if 'CHANNELS' is zero
+    template <int CHANNELS> int transposeChannels(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        int &srcSamples);
+
+    /// The rate as ratio 'step / numPhases': each output sample frame advances 
+    /// the input position by 'step' phases, and 'numPhases' phases make one 
+    /// input sample frame
+    int step;
+    int numPhases;
+
+    /// Current output position between two input sample frames, in phases
+    int phase;
+
+    /// Length of the input window that each output sample is calculated from,
+    /// filter length & its offset in the window, and cut-off frequency scaled 
+    /// to the input sample rate. Zero length means that the filters haven't 
+    /// been designed yet.
+    int span;
+    int taps;
+    int tapOffset;
+    double cutoff;
+
+    /// Number of phases that the filters are designed for
+    int coeffPhases;
+
+    /// Anti-alias filter settings given by 'setAAFilter'
+    bool bUseAAFilter;
+    int aaLength;
+
+    /// Filter coefficients, 'taps' for each phase
+    SAMPLETYPE *pCoeffs;
+
+    void calcCoeffs();
+
+    /// Calculate one output sample frame from the filter length of input sample
+    /// frames at 'src' using the filter 'phase'
+    virtual void filterMono(SAMPLETYPE *dest, const SAMPLETYPE *src, const SAMPLETYPE *phase) const;
+    virtual void filterStereo(SAMPLETYPE *dest, const SAMPLETYPE *src, const SAMPLETYPE *phase) const;
+
+public:
+    InterpolateRational();
+    virtual ~InterpolateRational();
+
+    /// Sets rate, which needs to be such that 'isRationalRate' is true
+    virtual void setRate(double newRate);
+    virtual void setAAFilter(bool enable, int length);
+    virtual bool hasAAFilter() const;
+    virtual double getPosition() const;
+    virtual int setPosition(double position);
+
+    /// Finds 'num / den' equal to 'rate', with at most RATIONAL_MAX_PHASES 
+    /// as denominator. Returns false if there isn't such.
+    static bool getRatio(double rate, int &num, int &den);
+
+    /// Returns true if 'rate' is such that this transposer can be used
+    static bool isRationalRate(double rate);
+
+    /// Returns instance with the filter routines optimized for the CPU
+    static InterpolateRational *newInstance();
+};
+
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    /// Class that implements SSE optimized filter routines for floating point samples type.
+    class InterpolateRationalSSE : public InterpolateRational
+    {
+    protected:
+        virtual void filterMono(float *dest, const float *src, const float *phase) const;
+        virtual void filterStereo(float *dest, const float *src, const float *phase) const;
+    };
+
+#endif // SOUNDTOUCH_ALLOW_SSE
+
+
+#if defined(SOUNDTOUCH_ALLOW_SSE41) && defined(SOUNDTOUCH_ALLOW_MMX)
+    /// Class that implements SSE4.1 optimized filter routines for integer samples type.
+    class InterpolateRationalSSE41 : public InterpolateRational
+    {
+    protected:
+        virtual void filterMono(short *dest, const short *src, const short *phase) const;
+        virtual void filterStereo(short *dest, const short *src, const short *phase) const;
+    };
+
+#endif // SOUNDTOUCH_ALLOW_SSE41
+
+}
+
+#endif
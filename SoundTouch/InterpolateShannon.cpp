@@ -3,9 +3,10 @@
 /// Sample interpolation routine using 8-tap band-limited Shannon interpolation 
 /// with kaiser window.
 ///
-/// Notice. This algorithm is remarkably much heavier than linear or cubic
-/// interpolation, and not remarkably better than cubic algorithm. Thus mostly
-/// for experimental purposes
+/// The windowed sinc coefficients are taken from a table that is precalculated
+/// at SHANNON_PHASES fractional positions between two input samples, and 
+/// interpolated linearly between the two nearest positions, so that no 
+/// trigonometric functions need to be evaluated per output sample.
 ///
 /// Author        : Copyright (c) Olli Parviainen
 /// Author e-mail : oparviai 'at' iki.fi
@@ -39,14 +40,23 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <math.h>
+#include <assert.h>
+#include <mutex>
 #include "InterpolateShannon.h"
 #include "STTypes.h"
 
 using namespace soundtouch;
 
+#define PI 3.1415926536
+
+/// Number of precalculated phases between two input samples
+#define SHANNON_PHASES      256
 
-/// Kaiser window with beta = 2.0
-/// Values scaled down by 5% to avoid overflows
+/// Number of filter taps
+#define SHANNON_TAPS        8
+
+/// Kaiser window with beta = 2.0. The table phases get normalized to unity DC gain,
+/// so the 5% downscaling of these values doesn't show in the output.
 static const double _kaiser8[8] = 
 {
    0.41778693317814,
@@ -60,9 +70,81 @@ static const double _kaiser8[8] =
 };
 
 
+/// Table of windowed sinc coefficients. Calculated once at first use, and 
+/// shared by all the instances.
+class ShannonTable
+{
+private:
+    static std::once_flag tableFlag;
+    static float coeffs[2 * SHANNON_PHASES * SHANNON_TAPS];
+
+    /// Calculates the table. Called only once via 'std::call_once', so the 
+    /// work buffer needn't be on the caller's stack.
+    static void calculate()
+    {
+        static double work[(SHANNON_PHASES + 1) * SHANNON_TAPS];
+        int p, k;
+
+        // one extra phase at the end for interpolating beyond the last phase
+        for (p = 0; p <= SHANNON_PHASES; p ++)
+        {
+            double fract = (double)p / SHANNON_PHASES;
+            double sum = 0;
+
+            for (k = 0; k < SHANNON_TAPS; k ++)
+            {
+                // distance of the tap from the output position, that is 'fract'
+                // after the tap 3
+                double x = PI * ((double)(k - 3) - fract);
+                double h = (x != 0) ? sin(x) / x : 1.0;                 // sinc function
+
+                work[p * SHANNON_TAPS + k] = h * _kaiser8[k];
+                sum += work[p * SHANNON_TAPS + k];
+            }
+
+            // normalize each phase to unity DC gain like the other transposers 
+            // have. Otherwise the gain would vary with the phase, and jump when 
+            // RateTransposer switches to the half-band or rational transposer. 
+            // Integer output gets saturated in 'FloatTransposerAdapter::toShort'.
+            for (k = 0; k < SHANNON_TAPS; k ++)
+            {
+                work[p * SHANNON_TAPS + k] /= sum;
+            }
+        }
+
+        for (p = 0; p < SHANNON_PHASES; p ++)
+        {
+            float *pPhase = coeffs + 2 * p * SHANNON_TAPS;
+            const double *pCur = work + p * SHANNON_TAPS;
+
+            for (k = 0; k < SHANNON_TAPS; k ++)
+            {
+                pPhase[k] = (float)pCur[k];
+                pPhase[SHANNON_TAPS + k] = (float)(pCur[SHANNON_TAPS + k] - pCur[k]);
+            }
+        }
+    }
+
+public:
+    static const float *getInstance()
+    {
+        // the VS2013 compiler doesn't make the initialization of local statics
+        // thread-safe, so calculate the table with 'std::call_once'
+        std::call_once(tableFlag, calculate);
+
+        return coeffs;
+    }
+};
+
+
+std::once_flag ShannonTable::tableFlag;
+float ShannonTable::coeffs[2 * SHANNON_PHASES * SHANNON_TAPS];
+
+
 InterpolateShannon::InterpolateShannon()
 {
     fract = 0;
+    pTable = ShannonTable::getInstance();
 }
 
 
@@ -72,42 +154,93 @@ void InterpolateShannon::resetRegisters()
 }
 
 
-#define PI 3.1415926536
-#define sinc(x) (sin(PI * (x)) / (PI * (x)))
+// The output sample frame is 'fract' after the center tap, i.e. the tap 3
+double InterpolateShannon::getPosition() const
+{
+    return 3.0 + fract;
+}
+
+
+int InterpolateShannon::setPosition(double position)
+{
+    int whole = (int)floor(position - 3.0);
+
+    fract = position - 3.0 - whole;
+    return whole;
+}
+
+
+// Returns the coefficients for the current position fraction 'fract', and the
+// weight 'k' of the coefficient differences to the next phase
+const float *InterpolateShannon::getPhase(float &k) const
+{
+    double phase;
+    int p;
+
+    phase = fract * SHANNON_PHASES;
+    p = (int)phase;
+    k = (float)(phase - p);
+    return pTable + 2 * p * SHANNON_TAPS;
+}
+
+
+// Calculates one mono output sample. Use separate sums for better CPU-level 
+// parallelization
+void InterpolateShannon::filterMono(float *dest, const float *src, const float *phase, float k) const
+{
+    const float *delta = phase + SHANNON_TAPS;
+    float sum0, sum1;
+    int i;
+
+    sum0 = sum1 = 0;
+    for (i = 0; i < SHANNON_TAPS; i += 2)
+    {
+        sum0 += src[i] * (phase[i] + k * delta[i]);
+        sum1 += src[i + 1] * (phase[i + 1] + k * delta[i + 1]);
+    }
+    dest[0] = sum0 + sum1;
+}
+
+
+// Calculates one stereo output sample frame
+void InterpolateShannon::filterStereo(float *dest, const float *src, const float *phase, float k) const
+{
+    const float *delta = phase + SHANNON_TAPS;
+    float suml, sumr;
+    int i;
+
+    suml = sumr = 0;
+    for (i = 0; i < SHANNON_TAPS; i ++)
+    {
+        float c = phase[i] + k * delta[i];
+
+        suml += src[2 * i] * c;
+        sumr += src[2 * i + 1] * c;
+    }
+    dest[0] = suml;
+    dest[1] = sumr;
+}
+
 
 /// Transpose mono audio. Returns number of produced output samples, and 
 /// updates "srcSamples" to amount of consumed source samples
-int InterpolateShannon::transposeMono(SAMPLETYPE *pdest, 
-                    const SAMPLETYPE *psrc, 
+int InterpolateShannon::transposeMono(float *pdest, 
+                    const float *psrc, 
                     int &srcSamples)
 {
     int i;
-    int srcSampleEnd = srcSamples - 8;
+    int srcSampleEnd = srcSamples - SHANNON_TAPS;
     int srcCount = 0;
 
     i = 0;
     while (srcCount < srcSampleEnd)
     {
-        double out;
-        assert(fract < 1.0);
-
-        out  = psrc[0] * sinc(-3.0 - fract) * _kaiser8[0];
-        out += psrc[1] * sinc(-2.0 - fract) * _kaiser8[1];
-        out += psrc[2] * sinc(-1.0 - fract) * _kaiser8[2];
-        if (fract < 1e-6)
-        {
-            out += psrc[3] * _kaiser8[3];     // sinc(0) = 1
-        }
-        else
-        {
-            out += psrc[3] * sinc(- fract) * _kaiser8[3];
-        }
-        out += psrc[4] * sinc( 1.0 - fract) * _kaiser8[4];
-        out += psrc[5] * sinc( 2.0 - fract) * _kaiser8[5];
-        out += psrc[6] * sinc( 3.0 - fract) * _kaiser8[6];
-        out += psrc[7] * sinc( 4.0 - fract) * _kaiser8[7];
+        const float *pPhase;
+        float k;
 
-        pdest[i] = (SAMPLETYPE)out;
+        assert(fract < 1.0);
+        pPhase = getPhase(k);
+        filterMono(pdest + i, psrc, pPhase, k);
         i ++;
 
         // update position fraction
@@ -125,39 +258,105 @@ int InterpolateShannon::transposeMono(SAMPLETYPE *pdest,
 
 /// Transpose stereo audio. Returns number of produced output samples, and 
 /// updates "srcSamples" to amount of consumed source samples
-int InterpolateShannon::transposeStereo(SAMPLETYPE *pdest, 
-                    const SAMPLETYPE *psrc, 
+int InterpolateShannon::transposeStereo(float *pdest, 
+                    const float *psrc, 
+                    int &srcSamples)
+{
+    int i;
+    int srcSampleEnd = srcSamples - SHANNON_TAPS;
+    int srcCount = 0;
+
+    i = 0;
+    while (srcCount < srcSampleEnd)
+    {
+        const float *pPhase;
+        float k;
+
+        assert(fract < 1.0);
+        pPhase = getPhase(k);
+        filterStereo(pdest + 2 * i, psrc, pPhase, k);
+        i ++;
+
+        // update position fraction
+        fract += rate;
+        // update whole positions
+        int whole = (int)fract;
+        fract -= whole;
+        psrc += 2 * whole;
+        srcCount += whole;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+/// Transpose multi-channel audio of 'CHANNELS' channels, or of 'numChannels'
+/// channels if 'CHANNELS' is zero. Returns number of produced output samples,
+/// and updates "srcSamples" to amount of consumed source samples
+template <int CHANNELS>
+int InterpolateShannon::transposeChannels(float *pdest, 
+                    const float *psrc, 
                     int &srcSamples)
 {
+    const int channels = (CHANNELS > 0) ? CHANNELS : numChannels;
     int i;
-    int srcSampleEnd = srcSamples - 8;
+    int srcSampleEnd = srcSamples - SHANNON_TAPS;
     int srcCount = 0;
 
     i = 0;
     while (srcCount < srcSampleEnd)
     {
-        double out0, out1, w;
+        const float *pPhase;
+        float coeffs[SHANNON_TAPS];
+        float k;
+        int c, t;
+
         assert(fract < 1.0);
+        pPhase = getPhase(k);
+
+        // interpolate the coefficients once for all the channels
+        for (t = 0; t < SHANNON_TAPS; t ++)
+        {
+            coeffs[t] = pPhase[t] + k * pPhase[SHANNON_TAPS + t];
+        }
+
+        if (CHANNELS > 0)
+        {
+            // fixed channel count: accumulate all the channels at each tap
+            float sums[CHANNELS > 0 ? CHANNELS : 1];
 
-        w = sinc(-3.0 - fract) * _kaiser8[0];
-        out0 = psrc[0] * w; out1 = psrc[1] * w;
-        w = sinc(-2.0 - fract) * _kaiser8[1];
-        out0 += psrc[2] * w; out1 += psrc[3] * w;
-        w = sinc(-1.0 - fract) * _kaiser8[2];
-        out0 += psrc[4] * w; out1 += psrc[5] * w;
-        w = _kaiser8[3] * ((fract < 1e-5) ? 1.0 : sinc(- fract));   // sinc(0) = 1
-        out0 += psrc[6] * w; out1 += psrc[7] * w;
-        w = sinc( 1.0 - fract) * _kaiser8[4];
-        out0 += psrc[8] * w; out1 += psrc[9] * w;
-        w = sinc( 2.0 - fract) * _kaiser8[5];
-        out0 += psrc[10] * w; out1 += psrc[11] * w;
-        w = sinc( 3.0 - fract) * _kaiser8[6];
-        out0 += psrc[12] * w; out1 += psrc[13] * w;
-        w = sinc( 4.0 - fract) * _kaiser8[7];
-        out0 += psrc[14] * w; out1 += psrc[15] * w;
-
-        pdest[2*i]   = (SAMPLETYPE)out0;
-        pdest[2*i+1] = (SAMPLETYPE)out1;
+            for (c = 0; c < CHANNELS; c ++)
+            {
+                sums[c] = 0;
+            }
+            for (t = 0; t < SHANNON_TAPS; t ++)
+            {
+                for (c = 0; c < CHANNELS; c ++)
+                {
+                    sums[c] += psrc[t * CHANNELS + c] * coeffs[t];
+                }
+            }
+            for (c = 0; c < CHANNELS; c ++)
+            {
+                pdest[c] = sums[c];
+            }
+            pdest += CHANNELS;
+        }
+        else
+        {
+            for (c = 0; c < channels; c ++)
+            {
+                const float *ptr = psrc + c;
+                float sum = 0;
+
+                for (t = 0; t < SHANNON_TAPS; t ++)
+                {
+                    sum += ptr[t * channels] * coeffs[t];
+                }
+                *pdest = sum;
+                pdest ++;
+            }
+        }
         i ++;
 
         // update position fraction
@@ -165,7 +364,7 @@ int InterpolateShannon::transposeStereo(SAMPLETYPE *pdest,
         // update whole positions
         int whole = (int)fract;
         fract -= whole;
-        psrc += 2*whole;
+        psrc += channels * whole;
         srcCount += whole;
     }
     srcSamples = srcCount;
@@ -173,13 +372,31 @@ int InterpolateShannon::transposeStereo(SAMPLETYPE *pdest,
 }
 
 
-/// Transpose stereo audio. Returns number of produced output samples, and 
+/// Transpose multi-channel audio. Returns number of produced output samples, and 
 /// updates "srcSamples" to amount of consumed source samples
-int InterpolateShannon::transposeMulti(SAMPLETYPE *pdest, 
-                    const SAMPLETYPE *psrc, 
+int InterpolateShannon::transposeMulti(float *pdest, 
+                    const float *psrc, 
                     int &srcSamples)
 {
-    // not implemented
-    assert(false);
-    return 0;
+    // the common channel counts have the channel loops fixed at compile time
+    switch (numChannels)
+    {
+        case 1:
+            return transposeChannels<1>(pdest, psrc, srcSamples);
+
+        case 2:
+            return transposeChannels<2>(pdest, psrc, srcSamples);
+
+        case 4:
+            return transposeChannels<4>(pdest, psrc, srcSamples);
+
+        case 6:
+            return transposeChannels<6>(pdest, psrc, srcSamples);
+
+        case 8:
+            return transposeChannels<8>(pdest, psrc, srcSamples);
+
+        default:
+            return transposeChannels<0>(pdest, psrc, srcSamples);
+    }
 }
@@ -3,9 +3,9 @@
 /// Sample interpolation routine using 8-tap band-limited Shannon interpolation 
 /// with kaiser window.
 ///
-/// Notice. This algorithm is remarkably much heavier than linear or cubic
-/// interpolation, and not remarkably better than cubic algorithm. Thus mostly
-/// for experimental purposes
+/// The windowed sinc coefficients are taken from a table that is precalculated
+/// at SHANNON_PHASES fractional positions between two input samples, and 
+/// interpolated linearly between the two nearest positions.
 ///
 /// Author        : Copyright (c) Olli Parviainen
 /// Author e-mail : oparviai 'at' iki.fi
@@ -41,32 +41,66 @@
 #ifndef _InterpolateShannon_H_
 #define _InterpolateShannon_H_
 
-#include "RateTransposer.h"
+#include "FloatTransposer.h"
 #include "STTypes.h"
 
 namespace soundtouch
 {
 
-class InterpolateShannon : public TransposerBase
+class InterpolateShannon : public FloatTransposer
 {
 protected:
     void resetRegisters();
-    int transposeMono(SAMPLETYPE *dest, 
-                        const SAMPLETYPE *src, 
+    int transposeMono(float *dest, 
+                        const float *src, 
                         int &srcSamples);
-    int transposeStereo(SAMPLETYPE *dest, 
-                        const SAMPLETYPE *src, 
+    int transposeStereo(float *dest, 
+                        const float *src, 
                         int &srcSamples);
-    int transposeMulti(SAMPLETYPE *dest, 
-                        const SAMPLETYPE *src, 
+    int transposeMulti(float *dest, 
+                        const float *src, 
+                        int &srcSamples);
+
+    /// 'transposeMulti' for 'CHANNELS' channels, or for 'numChannels' channels 
+    /// if 'CHANNELS' is zero
+    template <int CHANNELS> int transposeChannels(float *dest, 
+                        const float *src, 
                         int &srcSamples);
 
     double fract;
 
+    /// Coefficient table shared by all instances. Contains the coefficients of
+    /// each phase, each followed by differences of the coefficients to the next
+    /// phase.
+    const float *pTable;
+
+    const float *getPhase(float &k) const;
+
+    /// Calculate one output sample frame from the 8 input sample frames at 'src'
+    /// using the coefficients of 'phase', interpolated by 'k' towards the next 
+    /// phase
+    virtual void filterMono(float *dest, const float *src, const float *phase, float k) const;
+    virtual void filterStereo(float *dest, const float *src, const float *phase, float k) const;
+
 public:
     InterpolateShannon();
+
+    virtual double getPosition() const;
+    virtual int setPosition(double position);
 };
 
+
+#ifdef SOUNDTOUCH_ALLOW_FLOAT_SSE
+    /// Class that implements SSE optimized filter routines for floating point samples type.
+    class InterpolateShannonSSE : public InterpolateShannon
+    {
+    protected:
+        virtual void filterMono(float *dest, const float *src, const float *phase, float k) const;
+        virtual void filterStereo(float *dest, const float *src, const float *phase, float k) const;
+    };
+
+#endif // SOUNDTOUCH_ALLOW_FLOAT_SSE
+
 }
 
 #endif
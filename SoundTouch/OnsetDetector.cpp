@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Amplitude envelope follower and sound onset (transient) detector.
+///
+/// An onset is detected when the amplitude envelope of the decimated sound
+/// rises clearly above its slower sliding average. Detected onsets closer than
+/// the hold-off time to the previous onset are ignored, so that the decaying
+/// ripple of a single hit doesn't produce a burst of onsets.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include "OnsetDetector.h"
+
+using namespace soundtouch;
+
+/// decay constant for calculating RMS volume sliding average approximation 
+/// (time constant is about 10 sec)
+const float avgdecay = 0.99986f;
+
+/// Normalization coefficient for calculating RMS sliding average approximation.
+const float avgnorm = (1 - avgdecay);
+
+/// Decay constant of the slow envelope average used as onset reference level
+/// (time constant is about 30 ms at the decimated 1000 Hz rate)
+#define ONSET_SLOW_DECAY    0.967
+
+/// Onset is detected when envelope exceeds the slow average by this factor
+#define ONSET_THRESHOLD     2.0
+
+/// Minimum distance between detected onsets in milliseconds
+#define ONSET_HOLDOFF_MS    50
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// class AmplitudeEnvelope
+//
+//////////////////////////////////////////////////////////////////////////////
+
+AmplitudeEnvelope::AmplitudeEnvelope()
+{
+    clear();
+}
+
+
+void AmplitudeEnvelope::clear()
+{
+    envelopeAccu = 0;
+
+    // Initialize RMS volume accumulator to RMS level of 1500 (out of 32768) that's
+    // safe initial RMS signal level value for song data. This value is then adapted
+    // to the actual level during processing.
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    // integer samples
+    RMSVolumeAccu = (1500 * 1500) / avgnorm;
+#else
+    // float samples, scaled to range [-1..+1[
+    RMSVolumeAccu = (0.045f * 0.045f) / avgnorm;
+#endif
+}
+
+
+// Calculates amplitude envelope for the buffer of samples.
+// Result is output to 'samples'.
+void AmplitudeEnvelope::calcEnvelope(SAMPLETYPE *samples, int numsamples) 
+{
+    const static double decay = 0.7f;               // decay constant for smoothing the envelope
+    const static double norm = (1 - decay);
+
+    int i;
+    LONG_SAMPLETYPE out;
+    double val;
+
+    for (i = 0; i < numsamples; i ++) 
+    {
+        // calc average RMS volume
+        RMSVolumeAccu *= avgdecay;
+        val = (float)fabs((float)samples[i]);
+        RMSVolumeAccu += val * val;
+
+        // cut amplitudes that are below cutoff ~2 times RMS volume
+        // (we're interested in peak values, not the silent moments)
+        if (val < 0.5 * sqrt(RMSVolumeAccu * avgnorm))
+        {
+            val = 0;
+        }
+
+        // smooth amplitude envelope
+        envelopeAccu *= decay;
+        envelopeAccu += val;
+        out = (LONG_SAMPLETYPE)(envelopeAccu * norm);
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+        // cut peaks (shouldn't be necessary though)
+        if (out > 32767) out = 32767;
+#endif // SOUNDTOUCH_INTEGER_SAMPLES
+        samples[i] = (SAMPLETYPE)out;
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// class OnsetDetector
+//
+//////////////////////////////////////////////////////////////////////////////
+
+OnsetDetector::OnsetDetector()
+{
+    pOnsets = NULL;
+    onsetsSize = 0;
+    channels = 1;
+    decimateBy = 44;
+    holdOff = 44100 * ONSET_HOLDOFF_MS / 1000;
+    clear();
+}
+
+
+OnsetDetector::~OnsetDetector()
+{
+    delete[] pOnsets;
+}
+
+
+// Sets number of channels & sample rate of the input sound
+void OnsetDetector::setParameters(int numChannels, int sampleRate)
+{
+    assert(numChannels > 0);
+    channels = numChannels;
+
+    // choose decimation factor so that result is approx. 1000 Hz
+    decimateBy = sampleRate / 1000;
+    if (decimateBy < 1) decimateBy = 1;
+    holdOff = sampleRate * ONSET_HOLDOFF_MS / 1000;
+
+    // restart the decimation, the partial sum may have different channel count
+    decimateSum = 0;
+    decimateCount = 0;
+}
+
+
+// Clears the detector state & onsets
+void OnsetDetector::clear(double streamPosition)
+{
+    envelope.clear();
+    decimateSum = 0;
+    decimateCount = 0;
+    slowAccu = 0;
+    position = streamPosition;
+    lastOnset = -1e30;
+    numOnsets = 0;
+}
+
+
+void OnsetDetector::addOnset(double onsetPosition)
+{
+    if (numOnsets >= onsetsSize)
+    {
+        // grow the onset array
+        double *pNew;
+
+        onsetsSize = (onsetsSize > 0) ? 2 * onsetsSize : 16;
+        pNew = new double[onsetsSize];
+        if (numOnsets > 0)
+        {
+            memcpy(pNew, pOnsets, numOnsets * sizeof(double));
+        }
+        delete[] pOnsets;
+        pOnsets = pNew;
+    }
+    pOnsets[numOnsets] = onsetPosition;
+    numOnsets ++;
+    lastOnset = onsetPosition;
+}
+
+
+// Analyzes a block of input samples for onsets
+void OnsetDetector::inputSamples(const SAMPLETYPE *samples, int numSamples)
+{
+    int i, j;
+
+    for (i = 0; i < numSamples; i ++) 
+    {
+        SAMPLETYPE env;
+        LONG_SAMPLETYPE out;
+
+        // convert to mono and accumulate
+        for (j = 0; j < channels; j ++)
+        {
+            decimateSum += samples[j];
+        }
+        samples += channels;
+        position += 1;
+
+        decimateCount ++;
+        if (decimateCount < decimateBy) continue;
+
+        // take average of every 'decimateBy' sample frames
+        out = (LONG_SAMPLETYPE)(decimateSum / (decimateBy * channels));
+        decimateSum = 0;
+        decimateCount = 0;
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+        if (out > 32767) 
+        {
+            out = 32767;
+        } 
+        else if (out < -32768) 
+        {
+            out = -32768;
+        }
+#endif // SOUNDTOUCH_INTEGER_SAMPLES
+        env = (SAMPLETYPE)out;
+        envelope.calcEnvelope(&env, 1);
+
+        // detect steep envelope rise against the slow average level. Envelope
+        // is zero below the RMS cutoff level, so silence doesn't give onsets.
+        if ((env > 0) && (env > ONSET_THRESHOLD * slowAccu) && 
+            (position - lastOnset >= holdOff))
+        {
+            // the onset is within the latest decimated block
+            addOnset(position - decimateBy);
+        }
+        slowAccu = ONSET_SLOW_DECAY * slowAccu + (1 - ONSET_SLOW_DECAY) * env;
+    }
+}
+
+
+// Returns true if there's an onset at input stream position 'from' <= pos < 'to'
+bool OnsetDetector::hasOnset(double from, double to) const
+{
+    int i;
+
+    for (i = 0; i < numOnsets; i ++)
+    {
+        if ((pOnsets[i] >= from) && (pOnsets[i] < to)) return true;
+    }
+    return false;
+}
+
+
+// Discards the onsets before input stream position 'before'
+void OnsetDetector::discardOnsets(double before)
+{
+    int i;
+
+    // onsets are in increasing order
+    for (i = 0; i < numOnsets; i ++)
+    {
+        if (pOnsets[i] >= before) break;
+    }
+    if (i > 0)
+    {
+        numOnsets -= i;
+        memmove(pOnsets, pOnsets + i, numOnsets * sizeof(double));
+    }
+}
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Amplitude envelope follower and sound onset (transient) detector.
+///
+/// The envelope follower is shared with the BPM detector: it takes absolute
+/// value of the decimated sound, cuts away levels that are below a fraction of
+/// the long-term RMS level, and smooths the result with a sliding average.
+///
+/// The onset detector tracks the envelope against its slower sliding average
+/// and reports positions where the envelope rises steeply, e.g. drum hits. The
+/// tempo changer uses these for adapting the processing sequence placement.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _OnsetDetector_H_
+#define _OnsetDetector_H_
+
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+/// Amplitude envelope follower for decimated mono sound
+class AmplitudeEnvelope
+{
+protected:
+    /// Amplitude envelope sliding average approximation level accumulator
+    double envelopeAccu;
+
+    /// RMS volume sliding average approximation level accumulator
+    double RMSVolumeAccu;
+
+public:
+    AmplitudeEnvelope();
+
+    /// Resets the envelope & RMS level accumulators to initial values
+    void clear();
+
+    /// Calculates amplitude envelope for the buffer of samples.
+    /// Result is output to 'samples'.
+    void calcEnvelope(SAMPLETYPE *samples,  ///< Pointer to input/output data buffer
+                      int numsamples        ///< Number of samples in buffer
+                      );
+};
+
+
+/// Detects sound onsets and keeps list of their positions in the input stream
+class OnsetDetector
+{
+protected:
+    AmplitudeEnvelope envelope;
+
+    /// Number of channels
+    int channels;
+
+    /// Decimate sound by this coefficient to reach approx. 1000 Hz.
+    int decimateBy;
+
+    /// Sample average counter & accumulator for decimation
+    int decimateCount;
+    LONG_SAMPLETYPE decimateSum;
+
+    /// Slow sliding average of the envelope, reference level for onsets
+    double slowAccu;
+
+    /// Input stream position of the next input sample frame
+    double position;
+
+    /// Position of the latest detected onset, and minimum distance of onsets
+    double lastOnset;
+    int holdOff;
+
+    /// Positions of the detected onsets that haven't been discarded yet
+    double *pOnsets;
+    int numOnsets;
+    int onsetsSize;
+
+    void addOnset(double onsetPosition);
+
+public:
+    OnsetDetector();
+    ~OnsetDetector();
+
+    /// Sets number of channels & sample rate of the input sound
+    void setParameters(int numChannels, int sampleRate);
+
+    /// Clears the detector state & onsets, and sets the input stream position
+    /// of the next input sample frame
+    void clear(double streamPosition = 0);
+
+    /// Analyzes a block of input samples for onsets
+    void inputSamples(const SAMPLETYPE *samples,    ///< Input sample data
+                      int numSamples                ///< Number of sample frames
+                      );
+
+    /// Returns true if there's an onset at input stream position 'from' <= pos < 'to'
+    bool hasOnset(double from, double to) const;
+
+    /// Discards the onsets before input stream position 'before'
+    void discardOnsets(double before);
+};
+
+}
+
+#endif // _OnsetDetector_H_
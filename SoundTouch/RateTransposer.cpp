@@ -42,11 +42,15 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 #include "RateTransposer.h"
 #include "InterpolateLinear.h"
 #include "InterpolateCubic.h"
 #include "InterpolateShannon.h"
 #include "AAFilter.h"
+#include "InterpolateHalfband.h"
+#include "InterpolateRational.h"
+#include "cpu_detect.h"
 
 using namespace soundtouch;
 
@@ -62,6 +66,10 @@ RateTransposer::RateTransposer() : FIFOProcessor(&outputBuffer)
     // Instantiates the anti-alias filter
     pAAFilter = new AAFilter(64);
     pTransposer = TransposerBase::newInstance();
+    pHalfband = new InterpolateHalfband;
+    pRational = InterpolateRational::newInstance();
+    path = PATH_NONE;
+    pathPosition = 0;
 }
 
 
@@ -70,6 +78,8 @@ RateTransposer::~RateTransposer()
 {
     delete pAAFilter;
     delete pTransposer;
+    delete pHalfband;
+    delete pRational;
 }
 
 
@@ -102,6 +112,14 @@ void RateTransposer::setRate(double newRate)
     double fCutoff;
 
     pTransposer->setRate(newRate);
+    if (InterpolateHalfband::isHalfbandRate(newRate))
+    {
+        pHalfband->setRate(newRate);
+    }
+    if (InterpolateRational::isRationalRate(newRate))
+    {
+        pRational->setRate(newRate);
+    }
 
     // design a new anti-alias filter
     if (newRate > 1.0) 
@@ -124,53 +142,236 @@ void RateTransposer::putSamples(const SAMPLETYPE *samples, uint nSamples)
 }
 
 
+// Selects the processing path for the current rate & anti-alias filter settings
+RateTransposer::PATH RateTransposer::selectPath() const
+{
+    // Octave changes with the FIR anti-alias filter use the half-band filter,
+    // which filters & decimates or interpolates in one pass
+    if (bUseAAFilter && (pAAFilter->getType() == AAFilter::FIR) &&
+        InterpolateHalfband::isHalfbandRate(pTransposer->rate))
+    {
+        return PATH_HALFBAND;
+    }
+
+    // Rates that are ratios of small integers use the rational transposer, which
+    // has exact output positions, and does the anti-alias filtering by itself
+    if (((bUseAAFilter == false) || (pAAFilter->getType() == AAFilter::FIR)) &&
+        InterpolateRational::isRationalRate(pTransposer->rate))
+    {
+        return PATH_RATIONAL;
+    }
+
+    // If anti-alias filter is turned off, or the transposer filters the samples
+    // by itself, simply transpose without applying the separate filter
+    if ((bUseAAFilter == false) || pTransposer->hasAAFilter()) 
+    {
+        return PATH_TRANSPOSE;
+    }
+
+    // If the parameter 'Rate' value is smaller than 1, first transpose the 
+    // samples and then apply the anti-alias filter to remove aliasing. If 
+    // larger than 1, first apply the anti-alias filter to remove high 
+    // frequencies (prevent them from folding over the lover frequencies), 
+    // then transpose.
+    return (pTransposer->rate < 1.0f) ? PATH_TRANSPOSE_FIRST : PATH_FILTER_FIRST;
+}
+
+
+// Returns the delay of the anti-alias filter. The FIR filter output is at the 
+// center tap; the delay of the IIR filter is small, and isn't accounted for.
+double RateTransposer::getAALatency() const
+{
+    if (pAAFilter->getType() == AAFilter::FIR)
+    {
+        return (double)(pAAFilter->getLength() / 2);
+    }
+    return 0;
+}
+
+
+// Returns the position of the next output sample frame of the current path, in 
+// sample frames from the beginning of 'inputBuffer'. With the separate anti-alias
+// filter, the samples in 'midBuffer' are between the input and the output.
+double RateTransposer::getPathPosition() const
+{
+    switch (path)
+    {
+        case PATH_HALFBAND:
+            return pHalfband->getPosition();
+
+        case PATH_RATIONAL:
+            return pRational->getPosition();
+
+        case PATH_FILTER_FIRST:
+            // 'midBuffer' contains filtered input sample frames, which are delayed
+            // by the filter
+            return pTransposer->getPosition() - (double)midBuffer.numSamples() + getAALatency();
+
+        case PATH_TRANSPOSE_FIRST:
+            // 'midBuffer' contains transposed sample frames, which are 'rate' input
+            // sample frames apart, and the filter delays them
+            return pTransposer->getPosition() + 
+                   (getAALatency() - (double)midBuffer.numSamples()) * pTransposer->rate;
+
+        default:
+            return pTransposer->getPosition();
+    }
+}
+
+
+// Switches to the path 'newPath' so that the output continues from 'position' of
+// 'inputBuffer'. The samples in 'midBuffer' are accounted for in 'position', so 
+// they are discarded, and the transposer of the new path gets positioned to 
+// 'position'. If the previous path already consumed input samples that the new
+// path needs for its filter history, they are restored from 'historyBuffer'.
+void RateTransposer::changePath(PATH newPath, double position)
+{
+    int skip;
+
+    midBuffer.clear();
+    switch (newPath)
+    {
+        case PATH_HALFBAND:
+            skip = pHalfband->setPosition(position);
+            break;
+
+        case PATH_RATIONAL:
+            skip = pRational->setPosition(position);
+            break;
+
+        case PATH_FILTER_FIRST:
+            skip = pTransposer->setPosition(position - getAALatency());
+            break;
+
+        case PATH_TRANSPOSE_FIRST:
+            skip = pTransposer->setPosition(position - getAALatency() * pTransposer->rate);
+            break;
+
+        default:
+            skip = pTransposer->setPosition(position);
+            break;
+    }
+
+    if (skip > 0)
+    {
+        inputBuffer.receiveSamples((uint)skip);
+    }
+    else if (skip < 0)
+    {
+        int channels = inputBuffer.getChannels();
+        uint numInput = inputBuffer.numSamples();
+        uint numHistory = historyBuffer.numSamples();
+        uint numNeeded = numInput + (uint)(-skip);
+        uint numZeros;
+
+        // 'inputBuffer' contains the latest samples of 'historyBuffer'
+        if (numHistory < numInput) return;
+
+        // samples before the beginning of the history are silence
+        numZeros = (numNeeded > numHistory) ? numNeeded - numHistory : 0;
+        inputBuffer.clear();
+        memset(inputBuffer.ptrEnd(numZeros), 0, numZeros * channels * sizeof(SAMPLETYPE));
+        inputBuffer.putSamples(numZeros);
+        inputBuffer.putSamples(historyBuffer.ptrBegin() + (numHistory - numNeeded + numZeros) * channels, 
+                               numNeeded - numZeros);
+    }
+}
+
+
+// Stores the latest input samples to 'historyBuffer'. The history needs to cover
+// the input samples left in 'inputBuffer' and the filter history of any path,
+// which are both at most the anti-alias filter length.
+void RateTransposer::storeHistory(const SAMPLETYPE *src, uint nSamples)
+{
+    uint maxHistory = 2 * pAAFilter->getLength() + 16;
+    uint numHistory;
+
+    if (nSamples > maxHistory)
+    {
+        src += (nSamples - maxHistory) * historyBuffer.getChannels();
+        nSamples = maxHistory;
+    }
+    historyBuffer.putSamples(src, nSamples);
+    numHistory = historyBuffer.numSamples();
+    if (numHistory > maxHistory)
+    {
+        historyBuffer.receiveSamples(numHistory - maxHistory);
+    }
+}
+
+
 // Transposes sample rate by applying anti-alias filter to prevent folding. 
 // Returns amount of samples returned in the "dest" buffer.
 // The maximum amount of samples that can be returned at a time is set by
 // the 'set_returnBuffer_size' function.
 void RateTransposer::processSamples(const SAMPLETYPE *src, uint nSamples)
 {
-    uint count;
+    PATH newPath;
 
     if (nSamples == 0) return;
 
-    // Store samples to input buffer
-    inputBuffer.putSamples(src, nSamples);
+    newPath = selectPath();
 
-    // If anti-alias filter is turned off, simply transpose without applying
-    // the filter
-    if (bUseAAFilter == false) 
+    // pass the current anti-alias filter settings to the transposers that do
+    // the anti-alias filtering by themselves
+    if (newPath == PATH_HALFBAND)
     {
-        count = pTransposer->transpose(outputBuffer, inputBuffer);
-        return;
+        pHalfband->setAAFilter(true, pAAFilter->getLength());
+    }
+    else if (newPath == PATH_RATIONAL)
+    {
+        pRational->setAAFilter(bUseAAFilter, pAAFilter->getLength());
+    }
+    else if (pTransposer->hasAAFilter())
+    {
+        pTransposer->setAAFilter(bUseAAFilter, pAAFilter->getLength());
     }
 
-    assert(pAAFilter);
-
-    // Transpose with anti-alias filter
-    if (pTransposer->rate < 1.0f) 
+    // If the path changes, or the new settings move the output position of the
+    // path, continue the output from where the previous batch ended
+    if ((path != PATH_NONE) && 
+        ((newPath != path) || (fabs(getPathPosition() - pathPosition) > 1e-6)))
     {
-        // If the parameter 'Rate' value is smaller than 1, first transpose
-        // the samples and then apply the anti-alias filter to remove aliasing.
+        changePath(newPath, pathPosition);
+    }
+    path = newPath;
 
-        // Transpose the samples, store the result to end of "midBuffer"
-        pTransposer->transpose(midBuffer, inputBuffer);
+    // Store samples to input buffer
+    inputBuffer.putSamples(src, nSamples);
+    storeHistory(src, nSamples);
 
-        // Apply the anti-alias filter for transposed samples in midBuffer
-        pAAFilter->evaluate(outputBuffer, midBuffer);
-    } 
-    else  
+    switch (path)
     {
-        // If the parameter 'Rate' value is larger than 1, first apply the
-        // anti-alias filter to remove high frequencies (prevent them from folding
-        // over the lover frequencies), then transpose.
+        case PATH_HALFBAND:
+            pHalfband->transpose(outputBuffer, inputBuffer);
+            break;
+
+        case PATH_RATIONAL:
+            pRational->transpose(outputBuffer, inputBuffer);
+            break;
+
+        case PATH_TRANSPOSE_FIRST:
+            // Transpose the samples, store the result to end of "midBuffer"
+            pTransposer->transpose(midBuffer, inputBuffer);
+
+            // Apply the anti-alias filter for transposed samples in midBuffer
+            pAAFilter->evaluate(outputBuffer, midBuffer);
+            break;
 
-        // Apply the anti-alias filter for samples in inputBuffer
-        pAAFilter->evaluate(midBuffer, inputBuffer);
+        case PATH_FILTER_FIRST:
+            // Apply the anti-alias filter for samples in inputBuffer
+            pAAFilter->evaluate(midBuffer, inputBuffer);
 
-        // Transpose the AA-filtered samples in "midBuffer"
-        pTransposer->transpose(outputBuffer, midBuffer);
+            // Transpose the AA-filtered samples in "midBuffer"
+            pTransposer->transpose(outputBuffer, midBuffer);
+            break;
+
+        default:
+            pTransposer->transpose(outputBuffer, inputBuffer);
+            break;
     }
+
+    pathPosition = getPathPosition();
 }
 
 
@@ -181,8 +382,13 @@ void RateTransposer::setChannels(int nChannels)
 
     if (pTransposer->numChannels == nChannels) return;
     pTransposer->setChannels(nChannels);
+    pHalfband->setChannels(nChannels);
+    pRational->setChannels(nChannels);
 
     inputBuffer.setChannels(nChannels);
+    historyBuffer.setChannels(nChannels);
+    historyBuffer.clear();
+    path = PATH_NONE;
     midBuffer.setChannels(nChannels);
     outputBuffer.setChannels(nChannels);
 }
@@ -194,6 +400,9 @@ void RateTransposer::clear()
     outputBuffer.clear();
     midBuffer.clear();
     inputBuffer.clear();
+    historyBuffer.clear();
+    pAAFilter->clear();
+    path = PATH_NONE;
 }
 
 
@@ -276,22 +485,95 @@ void TransposerBase::setRate(double newRate)
 }
 
 
+void TransposerBase::setAAFilter(bool /*enable*/, int /*length*/)
+{
+    // by default the anti-alias filter is applied separately
+}
+
+
+bool TransposerBase::hasAAFilter() const
+{
+    return false;
+}
+
+
+// By default the next output sample frame is at the first source sample frame,
+// and the position can't be set within a source sample frame
+double TransposerBase::getPosition() const
+{
+    return 0;
+}
+
+
+int TransposerBase::setPosition(double position)
+{
+    resetRegisters();
+    return (int)floor(position + 0.5);
+}
+
+
 // static factory function
 TransposerBase *TransposerBase::newInstance()
 {
 #ifdef SOUNDTOUCH_INTEGER_SAMPLES
-    // Notice: For integer arithmetics support only linear algorithm (due to simplest calculus)
-    return ::new InterpolateLinearInteger;
+    // Notice: With integer samples, the linear algorithm uses integer arithmetics. 
+    // The cubic and shannon algorithms process the samples converted to floating
+    // point, so they can use the same SSE routines as with floating point samples.
+    switch (algorithm)
+    {
+        case LINEAR:
+            return ::new InterpolateLinearInteger;
+
+        case CUBIC:
+#ifdef SOUNDTOUCH_ALLOW_FLOAT_SSE
+            if (detectCPUextensions() & SUPPORT_SSE)
+            {
+                return FloatTransposerAdapter::newInstance(new InterpolateCubicSSE);
+            }
+#endif // SOUNDTOUCH_ALLOW_FLOAT_SSE
+            return FloatTransposerAdapter::newInstance(new InterpolateCubic);
+
+        case SHANNON:
+#ifdef SOUNDTOUCH_ALLOW_FLOAT_SSE
+            if (detectCPUextensions() & SUPPORT_SSE)
+            {
+                return FloatTransposerAdapter::newInstance(new InterpolateShannonSSE);
+            }
+#endif // SOUNDTOUCH_ALLOW_FLOAT_SSE
+            return FloatTransposerAdapter::newInstance(new InterpolateShannon);
+
+        default:
+            assert(false);
+            return NULL;
+    }
 #else
     switch (algorithm)
     {
         case LINEAR:
+#ifdef SOUNDTOUCH_ALLOW_SSE
+            if (detectCPUextensions() & SUPPORT_SSE)
+            {
+                return new InterpolateLinearFloatSSE;
+            }
+#endif // SOUNDTOUCH_ALLOW_SSE
             return new InterpolateLinearFloat;
 
         case CUBIC:
+#ifdef SOUNDTOUCH_ALLOW_FLOAT_SSE
+            if (detectCPUextensions() & SUPPORT_SSE)
+            {
+                return new InterpolateCubicSSE;
+            }
+#endif // SOUNDTOUCH_ALLOW_FLOAT_SSE
             return new InterpolateCubic;
 
         case SHANNON:
+#ifdef SOUNDTOUCH_ALLOW_FLOAT_SSE
+            if (detectCPUextensions() & SUPPORT_SSE)
+            {
+                return new InterpolateShannonSSE;
+            }
+#endif // SOUNDTOUCH_ALLOW_FLOAT_SSE
             return new InterpolateShannon;
 
         default:
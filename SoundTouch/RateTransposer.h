@@ -91,6 +91,25 @@ public:
     virtual void setRate(double newRate);
     virtual void setChannels(int channels);
 
+    /// Sets anti-alias filter mode & length for transposers that do the anti-alias
+    /// filtering by themselves, see 'hasAAFilter'. Others ignore this.
+    virtual void setAAFilter(bool enable, int length);
+
+    /// Returns nonzero if the transposer does the anti-alias filtering by itself, 
+    /// so that the samples needn't be filtered separately.
+    virtual bool hasAAFilter() const;
+
+    /// Returns the position of the next output sample frame, in source sample 
+    /// frames from the first source sample frame that hasn't been consumed yet.
+    virtual double getPosition() const;
+
+    /// Sets the transposer state so that the next output sample frame is at 
+    /// 'position' source sample frames from the first source sample frame that 
+    /// hasn't been consumed yet. Returns the number of source sample frames that
+    /// the caller needs to discard from the beginning of the source samples, or
+    /// to add before them if negative, for reaching that position.
+    virtual int setPosition(double position);
+
     // static factory function
     static TransposerBase *newInstance();
 
@@ -108,10 +127,40 @@ protected:
     AAFilter *pAAFilter;
     TransposerBase *pTransposer;
 
+    /// Transposer for exact octave changes, see 'InterpolateHalfband'. Used 
+    /// instead of 'pTransposer' and the anti-alias filter when the rate is 2 or 
+    /// 1/2, and the FIR anti-alias filter is enabled.
+    TransposerBase *pHalfband;
+
+    /// Transposer for rates that are ratios of small integers, see 
+    /// 'InterpolateRational'. Used instead of 'pTransposer' and the anti-alias
+    /// filter when the FIR anti-alias filter is enabled, or the anti-alias 
+    /// filter is disabled.
+    TransposerBase *pRational;
+
+    /// Processing paths, see 'selectPath'
+    enum PATH {
+        PATH_NONE = 0,          ///< Nothing processed yet
+        PATH_HALFBAND,          ///< 'pHalfband' 
+        PATH_RATIONAL,          ///< 'pRational'
+        PATH_TRANSPOSE,         ///< 'pTransposer' without separate anti-alias filter
+        PATH_FILTER_FIRST,      ///< Anti-alias filter, then 'pTransposer'
+        PATH_TRANSPOSE_FIRST    ///< 'pTransposer', then anti-alias filter
+    };
+
+    /// Path used for the previous batch, and position of the next output sample
+    /// frame in 'inputBuffer' after the batch, see 'getPathPosition'
+    PATH path;
+    double pathPosition;
+
     /// Buffer for collecting samples to feed the anti-alias filter between
     /// two batches
     FIFOSampleBuffer inputBuffer;
 
+    /// Copy of the latest input samples. Used for restoring the samples that the
+    /// previous path already consumed, but the next path needs as its history.
+    FIFOSampleBuffer historyBuffer;
+
     /// Buffer for keeping samples between transposing & anti-alias filter
     FIFOSampleBuffer midBuffer;
 
@@ -128,6 +177,22 @@ protected:
     void processSamples(const SAMPLETYPE *src, 
                         uint numSamples);
 
+    PATH selectPath() const;
+
+    /// Returns the delay of the anti-alias filter, in sample frames
+    double getAALatency() const;
+
+    /// Returns the position of the next output sample frame of the current path,
+    /// in sample frames from the beginning of 'inputBuffer'
+    double getPathPosition() const;
+
+    /// Switches to path 'newPath', continuing the output at position 'position' 
+    /// of 'inputBuffer'
+    void changePath(PATH newPath, double position);
+
+    /// Stores the latest input samples into 'historyBuffer'
+    void storeHistory(const SAMPLETYPE *src, uint numSamples);
+
 public:
     RateTransposer();
     virtual ~RateTransposer();
@@ -131,6 +131,12 @@ namespace soundtouch
     #define SOUNDTOUCH_ALLOW_NONEXACT_SIMD_OPTIMIZATION    1
 
 
+    #ifdef SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS
+        // Allow SSE optimizations of the transposers that process floating point
+        // samples with either sample type, see 'FloatTransposer'
+        #define SOUNDTOUCH_ALLOW_FLOAT_SSE     1
+    #endif
+
     #ifdef SOUNDTOUCH_INTEGER_SAMPLES
         // 16bit integer sample type
         typedef short SAMPLETYPE;
@@ -145,6 +151,12 @@ namespace soundtouch
         #ifdef SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS
             // Allow MMX optimizations
             #define SOUNDTOUCH_ALLOW_MMX   1
+
+            // Allow SSE4.1 optimizations. Requires Visual Studio 2008 or GCC 4.3
+            // or later for the intrinsics support
+            #if (defined(__GNUC__) || (_MSC_VER >= 1500))
+                #define SOUNDTOUCH_ALLOW_SSE41     1
+            #endif
         #endif
 
     #else
@@ -157,6 +169,18 @@ namespace soundtouch
         #ifdef SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS
             // Allow SSE optimizations
             #define SOUNDTOUCH_ALLOW_SSE       1
+
+            // Allow AVX2/FMA optimizations. Requires Visual Studio 2013 or GCC 4.9
+            // or later for the intrinsics support
+            #if (defined(__GNUC__) || (_MSC_VER >= 1800))
+                #define SOUNDTOUCH_ALLOW_AVX2      1
+            #endif
+
+            // Allow AVX-512 optimizations. Requires Visual Studio 2017 (15.3) 
+            // or GCC 4.9 or later for the intrinsics support
+            #if (defined(__GNUC__) || (_MSC_VER >= 1911))
+                #define SOUNDTOUCH_ALLOW_AVX512    1
+            #endif
         #endif
 
     #endif  // SOUNDTOUCH_INTEGER_SAMPLES
@@ -103,6 +103,7 @@ SoundTouch::SoundTouch()
     setOutPipe(pTDStretch);
 
     rate = tempo = 0;
+    bPullMode = false;
 
     virtualPitch = 
     virtualRate = 
@@ -112,6 +113,8 @@ SoundTouch::SoundTouch()
 
 	samplesExpectedOut = 0;
 	samplesOutput = 0;
+    samplesInput = 0;
+    bTempoEnvelope = false;
 
     channels = 0;
     bSrateSet = false;
@@ -233,6 +236,50 @@ void SoundTouch::setPitchSemiTones(double newPitch)
 }
 
 
+// Sets tempo envelope
+void SoundTouch::setTempoEnvelope(const double *positions, const double *tempos, uint count)
+{
+    double *tdPositions, *tdTempos;
+    double tdPos, scale;
+    uint i;
+
+    for (i = 0; i < count; i ++)
+    {
+        if ((tempos[i] <= 0) || ((i > 0) && (positions[i] < positions[i - 1])))
+        {
+            ST_THROW_RT_ERROR("SoundTouch : Invalid tempo envelope");
+        }
+    }
+
+    if (count == 0)
+    {
+        // clear the envelope & restore the tempo setting
+        pTDStretch->setTempoEnvelope(NULL, NULL, 0);
+        pTDStretch->setTempo(tempo);
+        bTempoEnvelope = false;
+        return;
+    }
+
+    // Convert the envelope to the input stream of the tempo changer. If the rate 
+    // transposer precedes the tempo changer, it scales the positions by 1/rate.
+    tdPos = pTDStretch->getInputPosition();
+    scale = (output == pTDStretch) ? 1.0 / rate : 1.0;
+
+    tdPositions = new double[count];
+    tdTempos = new double[count];
+    for (i = 0; i < count; i ++)
+    {
+        tdPositions[i] = tdPos + (positions[i] - (double)samplesInput) * scale;
+        tdTempos[i] = tempos[i] / virtualPitch;
+    }
+    pTDStretch->setTempoEnvelope(tdPositions, tdTempos, (int)count);
+    bTempoEnvelope = true;
+
+    delete[] tdPositions;
+    delete[] tdTempos;
+}
+
+
 // Calculates 'effective' rate and tempo values from the
 // nominal control values.
 void SoundTouch::calcEffectiveRateAndTempo()
@@ -271,6 +318,8 @@ void SoundTouch::calcEffectiveRateAndTempo()
             FIFOSamplePipe *transOut;
 
             assert(output == pTDStretch);
+            // process the samples pending in pull mode before moving them
+            pTDStretch->enablePullMode(false);
             // move samples in the current output buffer to the output of pRateTransposer
             transOut = pRateTransposer->getOutput();
             transOut->moveSamples(*output);
@@ -280,6 +329,9 @@ void SoundTouch::calcEffectiveRateAndTempo()
             output = pRateTransposer;
         }
     } 
+
+    // pull mode is possible only when the tempo changer is the last stage
+    pTDStretch->enablePullMode(bPullMode && (output == pTDStretch));
 }
 
 
@@ -323,7 +375,26 @@ void SoundTouch::putSamples(const SAMPLETYPE *samples, uint nSamples)
 
 	// accumulate how many samples are expected out from processing, given the current 
 	// processing setting
-	samplesExpectedOut += (double)nSamples / ((double)rate * (double)tempo);
+    if (bTempoEnvelope)
+    {
+        // integrate over the tempo envelope in short steps, at the positions where
+        // the samples enter the tempo changer
+        double tdPos = pTDStretch->getInputPosition();
+        double scale = (output == pTDStretch) ? 1.0 / rate : 1.0;
+        uint i, step;
+
+        for (i = 0; i < nSamples; i += step)
+        {
+            step = (nSamples - i < 1024) ? nSamples - i : 1024;
+            samplesExpectedOut += (double)step / 
+                ((double)rate * pTDStretch->getEnvelopeTempo(tdPos + (i + 0.5 * step) * scale));
+        }
+    }
+    else
+    {
+        samplesExpectedOut += (double)nSamples / ((double)rate * (double)tempo);
+    }
+    samplesInput += (long)nSamples;
 
 #ifndef SOUNDTOUCH_PREVENT_CLICK_AT_RATE_CROSSOVER
     if (rate <= 1.0f) 
@@ -360,6 +431,9 @@ void SoundTouch::flush()
 	// how many samples are still expected to output
 	numStillExpected = (int)((long)(samplesExpectedOut + 0.5) - samplesOutput);
 
+    // process the pending input normally, so that the output amount is known exactly
+    pTDStretch->enablePullMode(false);
+
     memset(buff, 0, 128 * channels * sizeof(SAMPLETYPE));
     // "Push" the last active samples out from the processing pipeline by
     // feeding blank samples into the processing pipeline until new, 
@@ -377,6 +451,7 @@ void SoundTouch::flush()
     // Clear input buffers
  //   pRateTransposer->clearInput();
     pTDStretch->clearInput();
+    pTDStretch->enablePullMode(bPullMode && (output == pTDStretch));
     // yet leave the output intouched as that's where the
     // flushed samples are!
 }
@@ -403,11 +478,45 @@ bool SoundTouch::setSetting(int settingId, int value)
             pRateTransposer->getAAFilter()->setLength(value);
             return true;
 
+        case SETTING_AA_FILTER_TYPE :
+            // selects anti-alias filter type
+            if ((value < AAFilter::FIR) || (value > AAFilter::IIR)) return false;
+            pRateTransposer->getAAFilter()->setType((AAFilter::TYPE)value);
+            return true;
+
         case SETTING_USE_QUICKSEEK :
             // enables / disables tempo routine quick seeking algorithm
             pTDStretch->enableQuickSeek((value != 0) ? true : false);
             return true;
 
+        case SETTING_SEEK_MODE :
+            // selects tempo routine overlap position seeking algorithm
+            if ((value < TDStretch::SEEK_FULL) || (value > TDStretch::SEEK_PYRAMID)) return false;
+            pTDStretch->setSeekMode((TDStretch::SEEKMODE)value);
+            return true;
+
+        case SETTING_BATCH_MODE :
+            // enables / disables tempo routine batch processing mode
+            pTDStretch->enableBatchMode((value != 0) ? true : false);
+            return true;
+
+        case SETTING_CROSSFADE_SHAPE :
+            // selects tempo routine cross-fade window shape
+            if ((value < TDStretch::CROSSFADE_LINEAR) || (value > TDStretch::CROSSFADE_EQUALPOWER)) return false;
+            pTDStretch->setCrossFade((TDStretch::CROSSFADE)value);
+            return true;
+
+        case SETTING_PULL_MODE :
+            // enables / disables tempo routine pull mode
+            bPullMode = (value != 0) ? true : false;
+            pTDStretch->enablePullMode(bPullMode && (output == pTDStretch));
+            return true;
+
+        case SETTING_TRANSIENT_MODE :
+            // enables / disables tempo routine transient mode
+            pTDStretch->enableTransientMode((value != 0) ? true : false);
+            return true;
+
         case SETTING_SEQUENCE_MS:
             // change time-stretch sequence duration parameter
             pTDStretch->setParameters(sampleRate, value, seekWindowMs, overlapMs);
@@ -445,9 +554,27 @@ int SoundTouch::getSetting(int settingId) const
         case SETTING_AA_FILTER_LENGTH :
             return pRateTransposer->getAAFilter()->getLength();
 
+        case SETTING_AA_FILTER_TYPE :
+            return (int)pRateTransposer->getAAFilter()->getType();
+
         case SETTING_USE_QUICKSEEK :
             return (uint)   pTDStretch->isQuickSeekEnabled();
 
+        case SETTING_SEEK_MODE :
+            return (int)pTDStretch->getSeekMode();
+
+        case SETTING_BATCH_MODE :
+            return (uint)pTDStretch->isBatchModeEnabled();
+
+        case SETTING_CROSSFADE_SHAPE :
+            return (int)pTDStretch->getCrossFade();
+
+        case SETTING_PULL_MODE :
+            return (uint)bPullMode;
+
+        case SETTING_TRANSIENT_MODE :
+            return (uint)pTDStretch->isTransientModeEnabled();
+
         case SETTING_SEQUENCE_MS:
             pTDStretch->getParameters(NULL, &temp, NULL, NULL);
             return temp;
@@ -477,6 +604,7 @@ int SoundTouch::getSetting(int settingId) const
 void SoundTouch::clear()
 {
 	samplesExpectedOut = 0;
+    samplesInput = 0;
     pRateTransposer->clear();
     pTDStretch->clear();
 }
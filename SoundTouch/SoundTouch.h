@@ -141,6 +141,54 @@ namespace soundtouch
 ///   tempo/pitch/rate/samplerate settings.
 #define SETTING_NOMINAL_OUTPUT_SEQUENCE		7
 
+/// Algorithm used in tempo changer routine for seeking the best overlapping position,
+/// see TDStretch::SEEKMODE: 0 = full search, 1 = quick search, 2 = full search with 
+/// FFT-based correlation, 3 = multi-resolution search. FFT-based correlation evaluates 
+/// the same measure as the full search at every offset but needs far less CPU with long 
+/// seek windows. The results agree up to rounding when the full search too tests every
+/// offset; the SSE-optimized float full search however skips offsets where the data 
+/// isn't 16-byte aligned (see SOUNDTOUCH_ALLOW_NONEXACT_SIMD_OPTIMIZATION), so then the 
+/// FFT-based search may pick an offset that the full search never tests.
+/// Multi-resolution search scans decimated signal first and then refines the best 
+/// candidates at full resolution, giving near full search quality at fraction of the cost.
+#define SETTING_SEEK_MODE           8
+
+/// Enable/disable batch processing mode in tempo changer routine (0 = disabled, 1 = enabled)
+/// 
+/// In batch mode, overlap position seeks of all the processing sequences that fit into 
+/// the input buffer are run in parallel threads. Useful for offline processing of long 
+/// files that are fed in large blocks with putSamples. Requires OpenMP support.
+#define SETTING_BATCH_MODE          9
+
+/// Cross-fade window shape for mixing the overlapping sequences in tempo changer routine,
+/// see TDStretch::CROSSFADE: 0 = linear, 1 = raised-cosine, 2 = equal-power. Raised-cosine 
+/// avoids the abrupt gain slope changes of linear fade at the overlap ends, equal-power 
+/// keeps the loudness steady when the overlapping sequences aren't well correlated.
+#define SETTING_CROSSFADE_SHAPE     10
+
+/// Enable/disable pull mode in tempo changer routine (0 = disabled, 1 = enabled)
+///
+/// In pull mode the tempo changer processes the input only when the output is received,
+/// mixing the processing sequences directly into the buffer given to 'receiveSamples'.
+/// This saves copying the output samples via an intermediate buffer. Has effect when
+/// the tempo changer is the last processing stage, i.e. with rate <= 1.0.
+#define SETTING_PULL_MODE           11
+
+/// Enable/disable transient mode in tempo changer routine (0 = disabled, 1 = enabled)
+///
+/// In transient mode the tempo changer detects sound onsets such as drum hits, and uses
+/// shorter processing sequences with full overlap position search around them, and 
+/// longer sequences with cheaper search in the steady regions between them.
+#define SETTING_TRANSIENT_MODE      12
+
+/// Anti-alias filter type of the rate transposer, see AAFilter::TYPE: 0 = FIR, 1 = IIR.
+///
+/// The IIR filter is a cascade of biquad sections. It has lower latency and needs fewer
+/// multiplications than the default linear-phase FIR filter, so it suits live monitoring,
+/// but it distorts the phase response near the cut-off frequency. 'SETTING_AA_FILTER_LENGTH'
+/// applies to the FIR filter only.
+#define SETTING_AA_FILTER_TYPE      13
+
 class SoundTouch : public FIFOProcessor
 {
 private:
@@ -169,6 +217,15 @@ private:
     /// Accumulator for how many samples in total have been read out from the processing so far
     long   samplesOutput;
 
+    /// Accumulator for how many samples in total have been put in since the stream beginning
+    long   samplesInput;
+
+    /// Flag: Is tempo envelope set?
+    bool   bTempoEnvelope;
+
+    /// Flag: Is pull mode requested?
+    bool   bPullMode;
+
     /// Calculates effective rate & tempo valuescfrom 'virtualRate', 'virtualTempo' and 
     /// 'virtualPitch' parameters.
     void calcEffectiveRateAndTempo();
@@ -222,6 +279,18 @@ public:
     void setPitchSemiTones(int newPitch);
     void setPitchSemiTones(double newPitch);
 
+    /// Sets tempo envelope for automating tempo changes in a long input buffer. 
+    /// 'positions' are 'count' breakpoint positions in input sample frames counted
+    /// from the stream beginning, in ascending order, and 'tempos' the tempo control
+    /// values at them as in setTempo. Tempo is interpolated linearly between the 
+    /// breakpoints, and kept constant before the first and after the last breakpoint.
+    /// The tempo changes get applied at the tempo changer processing sequence boundaries.
+    ///
+    /// The envelope overrides the tempo setting until cleared by setting zero breakpoints.
+    /// Set the envelope after the pitch & rate settings, as it's converted according
+    /// to them.
+    void setTempoEnvelope(const double *positions, const double *tempos, uint count);
+
     /// Sets the number of channels, 1 = mono, 2 = stereo
     void setChannels(uint numChannels);
 
@@ -47,6 +47,10 @@
 #include <math.h>
 #include <float.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "STTypes.h"
 #include "cpu_detect.h"
 #include "TDStretch.h"
@@ -55,6 +59,28 @@ using namespace soundtouch;
 
 #define max(x, y) (((x) > (y)) ? (x) : (y))
 
+#define PI      3.141592653589793
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    // scale normalized correlation of 16bit integer samples to range of floating point samples
+    #define CORR_SCALE  (1.0 / 32768.0)
+#else
+    #define CORR_SCALE  1.0
+#endif
+
+// Batch mode is used only if the input buffer contains at least this many 
+// sequences per thread, otherwise the speculative seeks cost more than they gain
+#define BATCH_MIN_SEQUENCES     4
+
+// Number of sequences that each batch mode thread seeks before its own range of
+// sequences, for the speculative overlap position chain to converge
+#define BATCH_WARMUP_SEQUENCES  2
+
+// In transient mode, the sequence length is scaled by these factors in the 
+// regions with & without an onset
+#define TRANSIENT_SEQUENCE_SCALE    0.5
+#define STEADY_SEQUENCE_SCALE       1.5
+
 
 /*****************************************************************************
  *
@@ -84,11 +110,32 @@ const short _scanOffsets[5][24]={
 
 TDStretch::TDStretch() : FIFOProcessor(&outputBuffer)
 {
-    bQuickSeek = false;
+    seekMode = SEEK_FULL;
     channels = 2;
 
     pMidBuffer = NULL;
     pMidBufferUnaligned = NULL;
+    pFadeUnaligned = NULL;
+    pFadeIn = NULL;
+    pFadeOut = NULL;
+    crossFade = CROSSFADE_LINEAR;
+    pFFTWork = NULL;
+    pPyramidWork = NULL;
+    pyramidWorkSize = 0;
+    pNormTable = NULL;
+    normTableSize = 0;
+    bSSE2NormTable = (detectCPUextensions() & SUPPORT_SSE2) ? true : false;
+    pEnvPosition = NULL;
+    pEnvTempo = NULL;
+    envLength = 0;
+    inputBufferPosition = 0;
+    bPullMode = false;
+    bTransientMode = false;
+    bTransientRegion = false;
+    bBatchMode = false;
+    bFrozenNormalizer = false;
+    pWorkers = NULL;
+    numWorkers = 0;
     overlapLength = 0;
 
     bAutoSeqSetting = true;
@@ -98,6 +145,10 @@ TDStretch::TDStretch() : FIFOProcessor(&outputBuffer)
     maxnormf = 1e8;
 
     skipFract = 0;
+    seekWindowLength = 0;
+    seekLength = 0;
+    nominalSkip = 0;
+    sampleReq = 0;
 
     tempo = 1.0f;
     setParameters(44100, DEFAULT_SEQUENCE_MS, DEFAULT_SEEKWINDOW_MS, DEFAULT_OVERLAP_MS);
@@ -111,6 +162,18 @@ TDStretch::TDStretch() : FIFOProcessor(&outputBuffer)
 TDStretch::~TDStretch()
 {
     delete[] pMidBufferUnaligned;
+    delete[] pFadeUnaligned;
+    delete[] pFFTWork;
+    delete[] pPyramidWork;
+    delete[] pNormTable;
+    delete[] pEnvPosition;
+    delete[] pEnvTempo;
+
+    for (int i = 0; i < numWorkers; i ++)
+    {
+        delete pWorkers[i];
+    }
+    delete[] pWorkers;
 }
 
 
@@ -153,11 +216,11 @@ void TDStretch::setParameters(int aSampleRate, int aSequenceMS,
         bAutoSeekSetting = true;
     }
 
-    calcSeqParameters();
+    onsetDetector.setParameters(channels, sampleRate);
 
     calculateOverlapLength(overlapMs);
 
-    // set tempo to recalculate 'sampleReq'
+    // set tempo to recalculate the sequence parameters & 'sampleReq'
     setTempo(tempo);
 }
 
@@ -190,25 +253,6 @@ void TDStretch::getParameters(int *pSampleRate, int *pSequenceMs, int *pSeekWind
 }
 
 
-// Overlaps samples in 'midBuffer' with the samples in 'pInput'
-void TDStretch::overlapMono(SAMPLETYPE *pOutput, const SAMPLETYPE *pInput) const
-{
-    int i;
-    SAMPLETYPE m1, m2;
-
-    m1 = (SAMPLETYPE)0;
-    m2 = (SAMPLETYPE)overlapLength;
-
-    for (i = 0; i < overlapLength ; i ++) 
-    {
-        pOutput[i] = (pInput[i] * m1 + pMidBuffer[i] * m2 ) / overlapLength;
-        m1 += 1;
-        m2 -= 1;
-    }
-}
-
-
-
 void TDStretch::clearMidBuffer()
 {
     memset(pMidBuffer, 0, channels * sizeof(SAMPLETYPE) * overlapLength);
@@ -217,6 +261,8 @@ void TDStretch::clearMidBuffer()
 
 void TDStretch::clearInput()
 {
+    // keep the input stream position running over the discarded samples
+    inputBufferPosition += inputBuffer.numSamples();
     inputBuffer.clear();
     clearMidBuffer();
 }
@@ -227,6 +273,9 @@ void TDStretch::clear()
 {
     outputBuffer.clear();
     clearInput();
+    inputBufferPosition = 0;
+    onsetDetector.clear();
+    bTransientRegion = false;
 }
 
 
@@ -235,52 +284,230 @@ void TDStretch::clear()
 // to enable
 void TDStretch::enableQuickSeek(bool enable)
 {
-    bQuickSeek = enable;
+    if (enable)
+    {
+        seekMode = SEEK_QUICK;
+    }
+    else if (seekMode == SEEK_QUICK)
+    {
+        seekMode = SEEK_FULL;
+    }
 }
 
 
 // Returns nonzero if the quick seeking algorithm is enabled.
 bool TDStretch::isQuickSeekEnabled() const
 {
-    return bQuickSeek;
+    return (seekMode == SEEK_QUICK);
 }
 
 
-// Seeks for the optimal overlap-mixing position.
-int TDStretch::seekBestOverlapPosition(const SAMPLETYPE *refPos)
+// Sets the overlap position seeking algorithm
+void TDStretch::setSeekMode(SEEKMODE mode)
+{
+    seekMode = mode;
+}
+
+
+// Returns the overlap position seeking algorithm in use
+TDStretch::SEEKMODE TDStretch::getSeekMode() const
+{
+    return seekMode;
+}
+
+
+// Sets the cross-fade window shape
+void TDStretch::setCrossFade(CROSSFADE shape)
+{
+    crossFade = shape;
+    if (overlapLength > 0)
+    {
+        calcCrossFadeTable();
+    }
+}
+
+
+// Returns the cross-fade window shape in use
+TDStretch::CROSSFADE TDStretch::getCrossFade() const
+{
+    return crossFade;
+}
+
+
+// Enables/disables the batch processing mode
+void TDStretch::enableBatchMode(bool enable)
+{
+    bBatchMode = enable;
+}
+
+
+// Returns nonzero if the batch processing mode is enabled
+bool TDStretch::isBatchModeEnabled() const
+{
+    return bBatchMode;
+}
+
+
+// Enables/disables the transient mode
+void TDStretch::enableTransientMode(bool enable)
+{
+    if (enable == bTransientMode) return;
+
+    bTransientMode = enable;
+    bTransientRegion = false;
+    // detect onsets from the samples fed after this on
+    onsetDetector.clear(getInputPosition());
+    // recalculate the sequence parameters for the steady/normal mode
+    setTempo(tempo);
+}
+
+
+// Returns nonzero if the transient mode is enabled
+bool TDStretch::isTransientModeEnabled() const
+{
+    return bTransientMode;
+}
+
+
+// Returns the seek algorithm to use for the next sequence. In transient mode
+// the sequences with an onset get the full search, and the steady regions the 
+// cheaper pyramid search, unless the quick or FFT seek has been chosen explicitly.
+TDStretch::SEEKMODE TDStretch::getEffectiveSeekMode() const
 {
-    if (bQuickSeek) 
+    if (bTransientMode == false) return seekMode;
+
+    if (bTransientRegion)
     {
-        return seekBestOverlapPositionQuick(refPos);
+        return (seekMode == SEEK_FFT) ? SEEK_FFT : SEEK_FULL;
     }
-    else 
+    return (seekMode == SEEK_QUICK) ? SEEK_QUICK : SEEK_PYRAMID;
+}
+
+
+// Seeks for the optimal overlap-mixing position.
+int TDStretch::seekBestOverlapPosition(const SAMPLETYPE *refPos)
+{
+    // norms of all the mixing positions are needed by all the seek algorithms
+    calcNormTable(refPos);
+
+    switch (getEffectiveSeekMode())
     {
-        return seekBestOverlapPositionFull(refPos);
+        case SEEK_QUICK:
+            return seekBestOverlapPositionQuick(refPos);
+
+        case SEEK_FFT:
+            return seekBestOverlapPositionFFT(refPos);
+
+        case SEEK_PYRAMID:
+            return seekBestOverlapPositionPyramid(refPos);
+
+        default:
+            return seekBestOverlapPositionFull(refPos);
     }
 }
 
 
-// Overlaps samples in 'midBuffer' with the samples in 'pInputBuffer' at position
-// of 'ovlPos'.
-inline void TDStretch::overlap(SAMPLETYPE *pOutput, const SAMPLETYPE *pInput, uint ovlPos) const
+// Calculates norms (energies) of the mixing data over the overlapping period for 
+// all the mixing positions into 'pNormTable', so that the cross-correlation 
+// routines need to calculate only the dot product. The norms are obtained as 
+// differences of a prefix sum of the sample frame energies.
+void TDStretch::calcNormTable(const SAMPLETYPE *refPos)
 {
-#ifndef USE_MULTICH_ALWAYS
-    if (channels == 1)
+    int i, c;
+    int refFrames = seekLength - 1 + overlapLength;
+    double sum;
+
+    if (normTableSize < refFrames + 1)
     {
-        // mono sound.
-        overlapMono(pOutput, pInput + ovlPos);
+        delete[] pNormTable;
+        pNormTable = new double[refFrames + 1];
+        normTableSize = refFrames + 1;
     }
-    else if (channels == 2)
+
+    // prefix sum of the sample frame energies
+    pNormTable[0] = 0;
+#ifdef SOUNDTOUCH_ALLOW_FLOAT_SSE
+    // with multichannel sound the energy calculation hides the dependency chain
+    // of the scalar prefix sum
+    if (bSSE2NormTable && (channels <= 2))
     {
-        // stereo sound
-        overlapStereo(pOutput, pInput + 2 * ovlPos);
-    } 
-    else 
-#endif // USE_MULTICH_ALWAYS
+        calcEnergyPrefixSSE2(refPos, refFrames);
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_FLOAT_SSE
+    {
+        sum = 0;
+        for (i = 0; i < refFrames; i ++)
+        {
+            double energy = 0;
+            for (c = 0; c < channels; c ++)
+            {
+                energy += (double)refPos[c] * (double)refPos[c];
+            }
+            sum += energy;
+            pNormTable[i + 1] = sum;
+            refPos += channels;
+        }
+    }
+
+    // Convert into norms over overlapLength frames. Can be done in-place, as the 
+    // items of the prefix sum at and after index 'i' are still intact.
+    for (i = 0; i < seekLength; i ++)
+    {
+        pNormTable[i] = pNormTable[i + overlapLength] - pNormTable[i];
+    }
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    // track the norm magnitude for the adaptive normalizer, in same units as the 
+    // intermediate division of the correlation routines. Scaling by power of two
+    // is exact, so only the largest norm needs to be scaled. Four partial maxima
+    // avoid serializing the comparisons into a single dependency chain.
+    double maxNorm[4] = {0, 0, 0, 0};
+    for (i = 0; i < seekLength - 3; i += 4)
     {
-        assert(channels > 0);
-        overlapMulti(pOutput, pInput + channels * ovlPos);
+        for (c = 0; c < 4; c ++)
+        {
+            if (pNormTable[i + c] > maxNorm[c]) maxNorm[c] = pNormTable[i + c];
+        }
+    }
+    for (; i < seekLength; i ++)
+    {
+        if (pNormTable[i] > maxNorm[0]) maxNorm[0] = pNormTable[i];
+    }
+    sum = maxNorm[0];
+    for (c = 1; c < 4; c ++)
+    {
+        if (maxNorm[c] > sum) sum = maxNorm[c];
+    }
+    sum /= (double)(1 << overlapDividerBitsNorm);
+    if (sum > maxnorm)
+    {
+        maxnorm = (unsigned long)sum;
     }
+#endif
+}
+
+
+// Returns normalized cross-correlation for mixing position 'offset', given the 
+// cross-correlation 'corr' of that position. Correlation values are scaled to the
+// same range in integer & floating point builds, so that the heuristics used in 
+// the seek algorithms weigh them similarly.
+inline double TDStretch::normalizeCorr(double corr, int offset) const
+{
+    double norm;
+
+    assert(offset >= 0);
+    norm = pNormTable[offset];
+    return CORR_SCALE * corr / sqrt((norm < 1e-9) ? 1.0 : norm);
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'pInputBuffer' at position
+// of 'ovlPos'.
+inline void TDStretch::overlap(SAMPLETYPE *pOutput, const SAMPLETYPE *pInput, uint ovlPos) const
+{
+    assert(channels > 0);
+    overlapMix(pOutput, pInput + channels * ovlPos);
 }
 
 
@@ -295,42 +522,37 @@ int TDStretch::seekBestOverlapPositionFull(const SAMPLETYPE *refPos)
     int bestOffs;
     double bestCorr;
     int i;
-    double norm;
 
     bestCorr = FLT_MIN;
     bestOffs = 0;
 
     // Scans for the best correlation value by testing each possible position
     // over the permitted range.
-    bestCorr = calcCrossCorr(refPos, pMidBuffer, norm);
+    bestCorr = normalizeCorr(calcCrossCorr(refPos, pMidBuffer), 0);
 
     #pragma omp parallel for
     for (i = 1; i < seekLength; i ++) 
     {
         double corr;
-        // Calculates correlation value for the mixing position corresponding to 'i'
-#ifdef _OPENMP
-        // in parallel OpenMP mode, can't use norm accumulator version as parallel executor won't
-        // iterate the loop in sequential order
-        corr = calcCrossCorr(refPos + channels * i, pMidBuffer, norm);
-#else
-        // In non-parallel version call "calcCrossCorrAccumulate" that is otherwise same
-        // as "calcCrossCorr", but saves time by reusing & updating previously stored 
-        // "norm" value
-        corr = calcCrossCorrAccumulate(refPos + channels * i, pMidBuffer, norm);
-#endif
+        // Calculates correlation value for the mixing position corresponding to 'i'.
+        // The norms come from the precalculated table, so the iterations are 
+        // independent of each other also in parallel OpenMP mode.
+        corr = normalizeCorr(calcCrossCorr(refPos + channels * i, pMidBuffer), i);
+
         // heuristic rule to slightly favour values close to mid of the range
         double tmp = (double)(2 * i - seekLength) / (double)seekLength;
         corr = ((corr + 0.1) * (1.0 - 0.25 * tmp * tmp));
 
-        // Checks for the highest correlation value
-        if (corr > bestCorr) 
+        // Checks for the highest correlation value. Equal values are resolved in 
+        // favour of the smaller offset, so that the result doesn't depend on the 
+        // order in which the parallel OpenMP threads get here.
+        if (corr >= bestCorr) 
         {
             // For optimal performance, enter critical section only in case that best value found.
             // in such case repeat 'if' condition as it's possible that parallel execution may have
             // updated the bestCorr value in the mean time
             #pragma omp critical
-            if (corr > bestCorr)
+            if ((corr > bestCorr) || ((corr == bestCorr) && (i < bestOffs)))
             {
                 bestCorr = corr;
                 bestOffs = i;
@@ -361,6 +583,7 @@ int TDStretch::seekBestOverlapPositionFull(const SAMPLETYPE *refPos)
 int TDStretch::seekBestOverlapPositionQuick(const SAMPLETYPE *refPos)
 {
 #define _MIN(a, b)   (((a) < (b)) ? (a) : (b))
+#define _MAX(a, b)   (((a) > (b)) ? (a) : (b))
 #define SCANSTEP    16
 #define SCANWIND    8
 
@@ -369,7 +592,6 @@ int TDStretch::seekBestOverlapPositionQuick(const SAMPLETYPE *refPos)
     int bestOffs2;
     float bestCorr, corr;
     float bestCorr2;
-    double norm;
 
     // note: 'float' types used in this function in case that the platform would need to use software-fp
 
@@ -396,7 +618,7 @@ int TDStretch::seekBestOverlapPositionQuick(const SAMPLETYPE *refPos)
     {
         // Calculates correlation value for the mixing position corresponding
         // to 'i'
-        corr = (float)calcCrossCorr(refPos + channels*i, pMidBuffer, norm);
+        corr = (float)normalizeCorr(calcCrossCorr(refPos + channels*i, pMidBuffer), i);
         // heuristic rule to slightly favour values close to mid of the seek range
         float tmp = (float)(2 * i - seekLength - 1) / (float)seekLength;
         corr = ((corr + 0.1f) * (1.0f - 0.25f * tmp * tmp));
@@ -420,13 +642,13 @@ int TDStretch::seekBestOverlapPositionQuick(const SAMPLETYPE *refPos)
 
     // Scans surroundings of the found best match with small stepping
     int end = _MIN(bestOffs + SCANWIND + 1, seekLength);
-    for (i = bestOffs - SCANWIND; i < end; i++)
+    for (i = _MAX(bestOffs - SCANWIND, 0); i < end; i++)
     {
         if (i == bestOffs) continue;    // this offset already calculated, thus skip
 
         // Calculates correlation value for the mixing position corresponding
         // to 'i'
-        corr = (float)calcCrossCorr(refPos + channels*i, pMidBuffer, norm);
+        corr = (float)normalizeCorr(calcCrossCorr(refPos + channels*i, pMidBuffer), i);
         // heuristic rule to slightly favour values close to mid of the range
         float tmp = (float)(2 * i - seekLength - 1) / (float)seekLength;
         corr = ((corr + 0.1f) * (1.0f - 0.25f * tmp * tmp));
@@ -442,13 +664,13 @@ int TDStretch::seekBestOverlapPositionQuick(const SAMPLETYPE *refPos)
 
     // Scans surroundings of the 2nd best match with small stepping
     end = _MIN(bestOffs2 + SCANWIND + 1, seekLength);
-    for (i = bestOffs2 - SCANWIND; i < end; i++)
+    for (i = _MAX(bestOffs2 - SCANWIND, 0); i < end; i++)
     {
         if (i == bestOffs2) continue;    // this offset already calculated, thus skip
 
         // Calculates correlation value for the mixing position corresponding
         // to 'i'
-        corr = (float)calcCrossCorr(refPos + channels*i, pMidBuffer, norm);
+        corr = (float)normalizeCorr(calcCrossCorr(refPos + channels*i, pMidBuffer), i);
         // heuristic rule to slightly favour values close to mid of the range
         float tmp = (float)(2 * i - seekLength - 1) / (float)seekLength;
         corr = ((corr + 0.1f) * (1.0f - 0.25f * tmp * tmp));
@@ -473,117 +695,554 @@ int TDStretch::seekBestOverlapPositionQuick(const SAMPLETYPE *refPos)
 }
 
 
+// Full-range seek algorithm that calculates cross-correlation for all the offsets
+// at once by means of FFT-based convolution, in O(n*log(n)) instead of O(n^2) time.
+// Evaluates the same normalized correlation as 'seekBestOverlapPositionFull' at 
+// every offset, so the results agree up to rounding as long as 'calcCrossCorr' 
+// does too. The SSE float version of 'calcCrossCorr' doesn't: with 
+// SOUNDTOUCH_ALLOW_NONEXACT_SIMD_OPTIMIZATION it rejects the offsets where the 
+// mixing data isn't 16-byte aligned, so this routine may select an offset that 
+// the full search skips.
+//
+// Mixing data and the reference 'pMidBuffer' are packed as real & imaginary
+// parts of a single complex vector, so that one forward and one inverse transform 
+// per sequence suffice.
+int TDStretch::seekBestOverlapPositionFFT(const SAMPLETYPE *refPos)
+{
+    int bestOffs;
+    double bestCorr;
+    int i, k;
+    int ovlLength = channels * overlapLength;
+    int refLength = channels * (seekLength - 1) + ovlLength;
+    int fftSize = (int)FFT::nextPow2((uint)refLength);
+
+    if ((int)fft.getSize() != fftSize)
+    {
+        fft.setSize((uint)fftSize);
+        delete[] pFFTWork;
+        pFFTWork = new double[2 * fftSize];
+    }
 
+    // pack mixing data into real part and reference into imaginary part
+    for (k = 0; k < refLength; k ++)
+    {
+        pFFTWork[2 * k] = (double)refPos[k];
+        pFFTWork[2 * k + 1] = (k < ovlLength) ? (double)pMidBuffer[k] : 0.0;
+    }
+    for (; k < fftSize; k ++)
+    {
+        pFFTWork[2 * k] = 0;
+        pFFTWork[2 * k + 1] = 0;
+    }
 
-/// For integer algorithm: adapt normalization factor divider with music so that 
-/// it'll not be pessimistically restrictive that can degrade quality on quieter sections
-/// yet won't cause integer overflows either
-void TDStretch::adaptNormalizer()
-{
-    // Do not adapt normalizer over too silent sequences to avoid averaging filter depleting to
-    // too low values during pauses in music
-    if ((maxnorm > 1000) || (maxnormf > 40000000))
-    { 
-        //norm averaging filter
-        maxnormf = 0.9f * maxnormf + 0.1f * (float)maxnorm;
+    fft.forward(pFFTWork);
 
-        if ((maxnorm > 800000000) && (overlapDividerBitsNorm < 16))
+    // Separate spectra X (mixing data) & M (reference) from Z = X + i*M, and 
+    // replace Z by cross-spectrum X * conj(M), whose inverse transform is the 
+    // cross-correlation. Process bins 'k' and 'fftSize-k' pairwise as both are 
+    // needed for the separation.
+    for (k = 0; k <= fftSize / 2; k ++)
+    {
+        int kn = (fftSize - k) & (fftSize - 1);
+        double zr = pFFTWork[2 * k];
+        double zi = pFFTWork[2 * k + 1];
+        double znr = pFFTWork[2 * kn];
+        double zni = pFFTWork[2 * kn + 1];
+
+        // X[k] = (Z[k] + conj(Z[N-k])) / 2, M[k] = (Z[k] - conj(Z[N-k])) / 2i
+        double xr = 0.5 * (zr + znr);
+        double xi = 0.5 * (zi - zni);
+        double mr = 0.5 * (zi + zni);
+        double mi = -0.5 * (zr - znr);
+
+        // P[k] = X[k] * conj(M[k]); P[N-k] = conj(P[k]) as result is real
+        double pr = xr * mr + xi * mi;
+        double pi = xi * mr - xr * mi;
+
+        pFFTWork[2 * k] = pr;
+        pFFTWork[2 * k + 1] = pi;
+        pFFTWork[2 * kn] = pr;
+        pFFTWork[2 * kn + 1] = -pi;
+    }
+
+    fft.inverse(pFFTWork);
+
+    // compensate for the unscaled inverse transform
+    double corrScale = 1.0 / (double)fftSize;
+
+    bestOffs = 0;
+    bestCorr = FLT_MIN;
+
+    for (i = 0; i < seekLength; i ++)
+    {
+        double corr;
+
+        corr = normalizeCorr(pFFTWork[2 * channels * i] * corrScale, i);
+
+        if (i == 0)
         {
-            // large values, so increase divider
-            overlapDividerBitsNorm++;
-            if (maxnorm > 1600000000) overlapDividerBitsNorm++; // extra large value => extra increase
+            // as in the full search, the first position is taken without weighting
+            bestCorr = corr;
+            continue;
         }
-        else if ((maxnormf < 1000000) && (overlapDividerBitsNorm > 0))
+
+        // heuristic rule to slightly favour values close to mid of the range
+        double tmp = (double)(2 * i - seekLength) / (double)seekLength;
+        corr = ((corr + 0.1) * (1.0 - 0.25 * tmp * tmp));
+
+        // Checks for the highest correlation value
+        if (corr > bestCorr) 
         {
-            // extra small values, decrease divider
-            overlapDividerBitsNorm--;
+            bestCorr = corr;
+            bestOffs = i;
         }
     }
 
-    maxnorm = 0;
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    adaptNormalizer();
+#endif
+
+    return bestOffs;
 }
 
 
-/// clear cross correlation routine state if necessary 
-void TDStretch::clearCrossCorrState()
+// Decimates 'frames' sample frames of 'src' by factor of two into 'dest' by averaging 
+// consecutive frames, which also acts as a crude anti-alias lowpass filter.
+template <class T> static void decimate2(float *dest, const T *src, int frames, int channels)
 {
-    // default implementation is empty.
+    int i, c;
+
+    for (i = 0; i < frames / 2; i ++)
+    {
+        for (c = 0; c < channels; c ++)
+        {
+            dest[c] = 0.5f * ((float)src[c] + (float)src[c + channels]);
+        }
+        dest += channels;
+        src += 2 * channels;
+    }
 }
 
 
-/// Calculates processing sequence length according to tempo setting
-void TDStretch::calcSeqParameters()
+// Calculates normalized cross-correlation of decimated signal vectors of 'length' items.
+// The result is scaled like in 'normalizeCorr', so that the seek heuristics weigh 
+// the decimated & full-resolution correlations similarly also with integer samples.
+static double calcCrossCorrDecimated(const float *mixingPos, const float *compare, int length)
 {
-    // Adjust tempo param according to tempo, so that variating processing sequence length is used
-    // at varius tempo settings, between the given low...top limits
-    #define AUTOSEQ_TEMPO_LOW   0.5     // auto setting low tempo range (-50%)
-    #define AUTOSEQ_TEMPO_TOP   2.0     // auto setting top tempo range (+100%)
+    double corr, norm;
+    int i;
 
-    // sequence-ms setting values at above low & top tempo
-    #define AUTOSEQ_AT_MIN      125.0
-    #define AUTOSEQ_AT_MAX      50.0
-    #define AUTOSEQ_K           ((AUTOSEQ_AT_MAX - AUTOSEQ_AT_MIN) / (AUTOSEQ_TEMPO_TOP - AUTOSEQ_TEMPO_LOW))
-    #define AUTOSEQ_C           (AUTOSEQ_AT_MIN - (AUTOSEQ_K) * (AUTOSEQ_TEMPO_LOW))
+    corr = norm = 0;
+    for (i = 0; i < length; i ++)
+    {
+        corr += mixingPos[i] * compare[i];
+        norm += mixingPos[i] * mixingPos[i];
+    }
+    return CORR_SCALE * corr / sqrt((norm < 1e-9 ? 1.0 : norm));
+}
 
-    // seek-window-ms setting values at above low & top tempoq
-    #define AUTOSEEK_AT_MIN     25.0
-    #define AUTOSEEK_AT_MAX     15.0
-    #define AUTOSEEK_K          ((AUTOSEEK_AT_MAX - AUTOSEEK_AT_MIN) / (AUTOSEQ_TEMPO_TOP - AUTOSEQ_TEMPO_LOW))
-    #define AUTOSEEK_C          (AUTOSEEK_AT_MIN - (AUTOSEEK_K) * (AUTOSEQ_TEMPO_LOW))
 
-    #define CHECK_LIMITS(x, mi, ma) (((x) < (mi)) ? (mi) : (((x) > (ma)) ? (ma) : (x)))
+// Inserts offset 'offs' with correlation 'corr' into list of 'count' best candidates
+// that's sorted into descending order by correlation value
+static void insertCandidate(int *offsList, double *corrList, int count, int offs, double corr)
+{
+    int i;
 
-    double seq, seek;
-    
-    if (bAutoSeqSetting)
+    if (corr <= corrList[count - 1]) return;
+
+    for (i = count - 1; (i > 0) && (corr > corrList[i - 1]); i --)
     {
-        seq = AUTOSEQ_C + AUTOSEQ_K * tempo;
-        seq = CHECK_LIMITS(seq, AUTOSEQ_AT_MAX, AUTOSEQ_AT_MIN);
-        sequenceMs = (int)(seq + 0.5);
+        offsList[i] = offsList[i - 1];
+        corrList[i] = corrList[i - 1];
     }
+    offsList[i] = offs;
+    corrList[i] = corr;
+}
 
-    if (bAutoSeekSetting)
+
+// Multi-resolution seek algorithm: Scans through the whole seek range with signal
+// decimated by factor of 4, refines the best candidates with signal decimated by 
+// factor of 2, and finally with full-resolution signal around the candidates.
+//
+// Unlike the quick seek, tests every position of the seek range at the coarse level,
+// so that sharp correlation peaks e.g. on transients are not missed between probes.
+// Cost is roughly 1/16 of the full search plus a few full-resolution correlations.
+int TDStretch::seekBestOverlapPositionPyramid(const SAMPLETYPE *refPos)
+{
+#define PYRAMID_CANDIDATES  4
+
+    int candOffs[PYRAMID_CANDIDATES];
+    double candCorr[PYRAMID_CANDIDATES];
+    int bestOffs;
+    double bestCorr, corr;
+    int i, n;
+    int refFrames = seekLength - 1 + overlapLength;
+    int needed = channels * (refFrames + overlapLength);
+
+    if (pyramidWorkSize < needed)
     {
-        seek = AUTOSEEK_C + AUTOSEEK_K * tempo;
-        seek = CHECK_LIMITS(seek, AUTOSEEK_AT_MAX, AUTOSEEK_AT_MIN);
-        seekWindowMs = (int)(seek + 0.5);
+        delete[] pPyramidWork;
+        pPyramidWork = new float[needed];
+        pyramidWorkSize = needed;
     }
 
-    // Update seek window lengths
-    seekWindowLength = (sampleRate * sequenceMs) / 1000;
-    if (seekWindowLength < 2 * overlapLength) 
+    // layout of the work buffer: mixing data & reference decimated by 2 and by 4
+    float *pRef2 = pPyramidWork;
+    float *pRef4 = pRef2 + channels * (refFrames / 2);
+    float *pMid2 = pRef4 + channels * (refFrames / 4);
+    float *pMid4 = pMid2 + channels * (overlapLength / 2);
+
+    decimate2(pRef2, refPos, refFrames, channels);
+    decimate2(pRef4, pRef2, refFrames / 2, channels);
+    decimate2(pMid2, pMidBuffer, overlapLength, channels);
+    decimate2(pMid4, pMid2, overlapLength / 2, channels);
+
+    for (n = 0; n < PYRAMID_CANDIDATES; n ++)
     {
-        seekWindowLength = 2 * overlapLength;
+        candOffs[n] = 0;
+        candCorr[n] = -FLT_MAX;
     }
-    seekLength = (sampleRate * seekWindowMs) / 1000;
-}
 
+    // Coarse scan: test every position with 4x decimated signal. Offsets are 
+    // expressed in full-resolution sample frames.
+    for (i = 0; i < seekLength; i += 4)
+    {
+        corr = calcCrossCorrDecimated(pRef4 + channels * (i / 4), pMid4, channels * (overlapLength / 4));
+        // heuristic rule to slightly favour values close to mid of the range
+        double tmp = (double)(2 * i - seekLength) / (double)seekLength;
+        corr = ((corr + 0.1) * (1.0 - 0.25 * tmp * tmp));
 
+        insertCandidate(candOffs, candCorr, PYRAMID_CANDIDATES, i, corr);
+    }
 
-// Sets new target tempo. Normal tempo = 'SCALE', smaller values represent slower 
-// tempo, larger faster tempo.
-void TDStretch::setTempo(double newTempo)
-{
-    int intskip;
+    bestOffs = 0;
+    bestCorr = -FLT_MAX;
 
-    tempo = newTempo;
+    for (n = 0; n < PYRAMID_CANDIDATES; n ++)
+    {
+        int offs2;
+        double bestCorr2;
 
-    // Calculate new sequence duration
-    calcSeqParameters();
+        if (candCorr[n] == -FLT_MAX) break;     // fewer positions than candidates
 
-    // Calculate ideal skip length (according to tempo value) 
-    nominalSkip = tempo * (seekWindowLength - overlapLength);
-    intskip = (int)(nominalSkip + 0.5);
+        // refine the candidate with 2x decimated signal in steps of 2 frames
+        offs2 = candOffs[n];
+        bestCorr2 = -FLT_MAX;
+        for (i = candOffs[n] - 2; i <= candOffs[n] + 2; i += 2)
+        {
+            if ((i < 0) || (i >= seekLength)) continue;
 
-    // Calculate how many samples are needed in the 'inputBuffer' to 
-    // process another batch of samples
-    //sampleReq = max(intskip + overlapLength, seekWindowLength) + seekLength / 2;
-    sampleReq = max(intskip + overlapLength, seekWindowLength) + seekLength;
-}
+            corr = calcCrossCorrDecimated(pRef2 + channels * (i / 2), pMid2, channels * (overlapLength / 2));
+            double tmp = (double)(2 * i - seekLength) / (double)seekLength;
+            corr = ((corr + 0.1) * (1.0 - 0.25 * tmp * tmp));
 
+            if (corr > bestCorr2)
+            {
+                bestCorr2 = corr;
+                offs2 = i;
+            }
+        }
 
+        // finally refine with full-resolution signal
+        for (i = offs2 - 1; i <= offs2 + 1; i ++)
+        {
+            if ((i < 0) || (i >= seekLength)) continue;
 
-// Sets the number of channels, 1 = mono, 2 = stereo
+            corr = normalizeCorr(calcCrossCorr(refPos + channels * i, pMidBuffer), i);
+            double tmp = (double)(2 * i - seekLength) / (double)seekLength;
+            corr = ((corr + 0.1) * (1.0 - 0.25 * tmp * tmp));
+
+            if (corr > bestCorr)
+            {
+                bestCorr = corr;
+                bestOffs = i;
+            }
+        }
+    }
+
+    // clear cross correlation routine state if necessary (is so e.g. in MMX routines).
+    clearCrossCorrState();
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    adaptNormalizer();
+#endif
+
+    return bestOffs;
+}
+
+
+/// For integer algorithm: adapt normalization factor divider with music so that 
+/// it'll not be pessimistically restrictive that can degrade quality on quieter sections
+/// yet won't cause integer overflows either
+void TDStretch::adaptNormalizer()
+{
+    // In batch mode the normalizer is kept constant during the batch, so that the 
+    // seek results don't depend on the order in which the threads seek the sequences.
+    // 'maxnorm' keeps accumulating and gets adapted once after the batch.
+    if (bFrozenNormalizer) return;
+
+    // Do not adapt normalizer over too silent sequences to avoid averaging filter depleting to
+    // too low values during pauses in music
+    if ((maxnorm > 1000) || (maxnormf > 40000000))
+    { 
+        //norm averaging filter
+        maxnormf = 0.9f * maxnormf + 0.1f * (float)maxnorm;
+
+        if ((maxnorm > 800000000) && (overlapDividerBitsNorm < 16))
+        {
+            // large values, so increase divider
+            overlapDividerBitsNorm++;
+            if (maxnorm > 1600000000) overlapDividerBitsNorm++; // extra large value => extra increase
+        }
+        else if ((maxnormf < 1000000) && (overlapDividerBitsNorm > 0))
+        {
+            // extra small values, decrease divider
+            overlapDividerBitsNorm--;
+        }
+    }
+
+    maxnorm = 0;
+}
+
+
+/// clear cross correlation routine state if necessary 
+void TDStretch::clearCrossCorrState()
+{
+    // default implementation is empty.
+}
+
+
+/// Calculates processing sequence length according to the tempo setting of 'params',
+/// and the nominal input skip & the input needed for processing a sequence
+void TDStretch::calcSeqParameters(SEQPARAMS &params) const
+{
+    // Adjust tempo param according to tempo, so that variating processing sequence length is used
+    // at varius tempo settings, between the given low...top limits
+    #define AUTOSEQ_TEMPO_LOW   0.5     // auto setting low tempo range (-50%)
+    #define AUTOSEQ_TEMPO_TOP   2.0     // auto setting top tempo range (+100%)
+
+    // sequence-ms setting values at above low & top tempo
+    #define AUTOSEQ_AT_MIN      125.0
+    #define AUTOSEQ_AT_MAX      50.0
+    #define AUTOSEQ_K           ((AUTOSEQ_AT_MAX - AUTOSEQ_AT_MIN) / (AUTOSEQ_TEMPO_TOP - AUTOSEQ_TEMPO_LOW))
+    #define AUTOSEQ_C           (AUTOSEQ_AT_MIN - (AUTOSEQ_K) * (AUTOSEQ_TEMPO_LOW))
+
+    // seek-window-ms setting values at above low & top tempoq
+    #define AUTOSEEK_AT_MIN     25.0
+    #define AUTOSEEK_AT_MAX     15.0
+    #define AUTOSEEK_K          ((AUTOSEEK_AT_MAX - AUTOSEEK_AT_MIN) / (AUTOSEQ_TEMPO_TOP - AUTOSEQ_TEMPO_LOW))
+    #define AUTOSEEK_C          (AUTOSEEK_AT_MIN - (AUTOSEEK_K) * (AUTOSEQ_TEMPO_LOW))
+
+    #define CHECK_LIMITS(x, mi, ma) (((x) < (mi)) ? (mi) : (((x) > (ma)) ? (ma) : (x)))
+
+    double seq, seek;
+    int seqMs, seekMs, intskip;
+    
+    if (bAutoSeqSetting)
+    {
+        seq = AUTOSEQ_C + AUTOSEQ_K * params.tempo;
+        seq = CHECK_LIMITS(seq, AUTOSEQ_AT_MAX, AUTOSEQ_AT_MIN);
+        seqMs = (int)(seq + 0.5);
+    }
+    else
+    {
+        seqMs = sequenceMs;
+    }
+
+    if (bAutoSeekSetting)
+    {
+        seek = AUTOSEEK_C + AUTOSEEK_K * params.tempo;
+        seek = CHECK_LIMITS(seek, AUTOSEEK_AT_MAX, AUTOSEEK_AT_MIN);
+        seekMs = (int)(seek + 0.5);
+    }
+    else
+    {
+        seekMs = seekWindowMs;
+    }
+
+    // Update seek window lengths
+    params.seekWindowLength = (sampleRate * seqMs) / 1000;
+    if (bTransientMode)
+    {
+        // shorter sequences around onsets, longer in the steady regions
+        params.seekWindowLength = (int)(params.seekWindowLength * 
+            (params.transient ? TRANSIENT_SEQUENCE_SCALE : STEADY_SEQUENCE_SCALE));
+    }
+    if (params.seekWindowLength < 2 * overlapLength) 
+    {
+        params.seekWindowLength = 2 * overlapLength;
+    }
+    params.seekLength = (sampleRate * seekMs) / 1000;
+
+    // Calculate ideal skip length (according to tempo value) 
+    params.nominalSkip = params.tempo * (params.seekWindowLength - overlapLength);
+    intskip = (int)(params.nominalSkip + 0.5);
+
+    // Calculate how many samples are needed in the 'inputBuffer' to 
+    // process another batch of samples
+    //sampleReq = max(intskip + overlapLength, seekWindowLength) + seekLength / 2;
+    params.sampleReq = max(intskip + overlapLength, params.seekWindowLength) + params.seekLength;
+}
+
+
+// Returns the current sequence parameters
+void TDStretch::getSeqParameters(SEQPARAMS &params) const
+{
+    params.tempo = tempo;
+    params.transient = bTransientRegion;
+    params.seekWindowLength = seekWindowLength;
+    params.seekLength = seekLength;
+    params.nominalSkip = nominalSkip;
+    params.sampleReq = sampleReq;
+}
+
+
+// Takes the sequence parameters 'params' into use
+void TDStretch::setSeqParameters(const SEQPARAMS &params)
+{
+    tempo = params.tempo;
+    bTransientRegion = params.transient;
+    seekWindowLength = params.seekWindowLength;
+    seekLength = params.seekLength;
+    nominalSkip = params.nominalSkip;
+    sampleReq = params.sampleReq;
+}
+
+
+
+// Sets new target tempo. Normal tempo = 'SCALE', smaller values represent slower 
+// tempo, larger faster tempo.
+void TDStretch::setTempo(double newTempo)
+{
+    SEQPARAMS params;
+
+    getSeqParameters(params);
+    params.tempo = newTempo;
+
+    // Calculate new sequence duration
+    calcSeqParameters(params);
+    setSeqParameters(params);
+}
+
+
+
+// Sets tempo envelope breakpoints
+void TDStretch::setTempoEnvelope(const double *positions, const double *tempos, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i ++)
+    {
+        if ((tempos[i] <= 0) || ((i > 0) && (positions[i] < positions[i - 1])))
+        {
+            ST_THROW_RT_ERROR("TDStretch : Invalid tempo envelope");
+        }
+    }
+
+    delete[] pEnvPosition;
+    delete[] pEnvTempo;
+    pEnvPosition = NULL;
+    pEnvTempo = NULL;
+    envLength = count;
+
+    if (count > 0)
+    {
+        pEnvPosition = new double[count];
+        pEnvTempo = new double[count];
+        memcpy(pEnvPosition, positions, count * sizeof(double));
+        memcpy(pEnvTempo, tempos, count * sizeof(double));
+    }
+}
+
+
+// Returns the tempo envelope value at input stream position 'position'
+double TDStretch::getEnvelopeTempo(double position) const
+{
+    int lo, hi;
+    double k;
+
+    if (envLength == 0) return tempo;
+    if (position <= pEnvPosition[0]) return pEnvTempo[0];
+    if (position >= pEnvPosition[envLength - 1]) return pEnvTempo[envLength - 1];
+
+    // binary search for the breakpoints around 'position'. Invariant is
+    // pEnvPosition[lo] <= position < pEnvPosition[hi]
+    lo = 0;
+    hi = envLength - 1;
+    while (hi - lo > 1)
+    {
+        int mid = (lo + hi) / 2;
+        if (pEnvPosition[mid] <= position)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    k = (position - pEnvPosition[lo]) / (pEnvPosition[hi] - pEnvPosition[lo]);
+    return pEnvTempo[lo] + k * (pEnvTempo[hi] - pEnvTempo[lo]);
+}
+
+
+// Returns how many sample frames have been fed into the input since the stream beginning
+double TDStretch::getInputPosition() const
+{
+    return inputBufferPosition + inputBuffer.numSamples();
+}
+
+
+// Updates the sequence parameters 'params' of the previous processing sequence for
+// the sequence that begins at input stream position 'position' + 'fract', according
+// to the tempo envelope and the onsets detected in transient mode
+void TDStretch::updateSequenceParameters(SEQPARAMS &params, double position, double fract) const
+{
+    double newTempo;
+    bool transient;
+
+    if (envLength > 0)
+    {
+        newTempo = getEnvelopeTempo(position + fract);
+        if (fabs(newTempo - params.tempo) > 1e-10)
+        {
+            params.tempo = newTempo;
+            calcSeqParameters(params);
+        }
+    }
+
+    if (bTransientMode)
+    {
+        transient = onsetDetector.hasOnset(position, position + params.sampleReq);
+        if (transient != params.transient)
+        {
+            params.transient = transient;
+            calcSeqParameters(params);
+        }
+    }
+}
+
+
+// Updates the tempo & sequence parameters for the next processing sequence
+// according to the tempo envelope and the onsets detected in transient mode
+void TDStretch::updateSequenceParameters()
+{
+    SEQPARAMS params;
+
+    if (bTransientMode)
+    {
+        // onsets before the next sequence aren't needed anymore
+        onsetDetector.discardOnsets(inputBufferPosition);
+    }
+
+    getSeqParameters(params);
+    updateSequenceParameters(params, inputBufferPosition, skipFract);
+    setSeqParameters(params);
+}
+
+
+// Sets the number of channels, 1 = mono, 2 = stereo
 void TDStretch::setChannels(int numChannels)
 {
     assert(numChannels > 0);
@@ -637,8 +1296,7 @@ void TDStretch::processNominalTempo()
 // the result into 'outputBuffer'
 void TDStretch::processSamples()
 {
-    int ovlSkip, offset;
-    int temp;
+    int offset;
 
     /* Removed this small optimization - can introduce a click to sound when tempo setting
        crosses the nominal value
@@ -650,60 +1308,438 @@ void TDStretch::processSamples()
     }
     */
 
+#ifdef _OPENMP
+    if (bBatchMode && (envLength == 0) && (bTransientMode == false))
+    {
+        // process the sequences that fit into 'inputBuffer' in parallel. Not with 
+        // tempo envelope or in transient mode, as then the sequence positions can't
+        // be planned in advance
+        processBatch();
+    }
+#endif
+
     // Process samples as long as there are enough samples in 'inputBuffer'
-    // to form a processing frame.
+    // to form a processing frame. Tempo envelope & transient mode are applied at
+    // the sequence boundaries, as they change the sequence parameters.
+    updateSequenceParameters();
     while ((int)inputBuffer.numSamples() >= sampleReq) 
     {
         // If tempo differs from the normal ('SCALE'), scan for the best overlapping
         // position
         offset = seekBestOverlapPosition(inputBuffer.ptrBegin());
 
-        // Mix the samples in the 'inputBuffer' at position of 'offset' with the 
-        // samples in 'midBuffer' using sliding overlapping
-        // ... first partially overlap with the end of the previous sequence
-        // (that's in 'midBuffer')
-        overlap(outputBuffer.ptrEnd((uint)overlapLength), inputBuffer.ptrBegin(), (uint)offset);
-        outputBuffer.putSamples((uint)overlapLength);
+        processSequence(offset, 0);
+        updateSequenceParameters();
+    }
+}
+
+
+// Mixes & outputs one processing sequence from beginning of 'inputBuffer' using
+// overlap position 'offset' into 'outputBuffer'. See 'mixSequence'.
+void TDStretch::processSequence(int offset, int lengthAdjust)
+{
+    int length;
+
+    length = seekWindowLength - overlapLength + lengthAdjust;
+    outputBuffer.putSamples((uint)mixSequence(outputBuffer.ptrEnd((uint)length), offset, lengthAdjust));
+}
+
+
+// Mixes one processing sequence from beginning of 'inputBuffer' using overlap 
+// position 'offset' into 'pOutput', and removes the processed samples from 
+// 'inputBuffer'. 'lengthAdjust' lengthens or shortens the sequence from the 
+// nominal length. 'pOutput' must have room for 'seekWindowLength - overlapLength
+// + lengthAdjust' sample frames. Returns number of frames written.
+int TDStretch::mixSequence(SAMPLETYPE *pOutput, int offset, int lengthAdjust)
+{
+    int ovlSkip;
+    int temp;
 
-        // ... then copy sequence samples from 'inputBuffer' to output:
+    // Mix the samples in the 'inputBuffer' at position of 'offset' with the 
+    // samples in 'midBuffer' using sliding overlapping
+    // ... first partially overlap with the end of the previous sequence
+    // (that's in 'midBuffer')
+    overlap(pOutput, inputBuffer.ptrBegin(), (uint)offset);
+
+    // ... then copy sequence samples from 'inputBuffer' to output:
+
+    // length of sequence
+    temp = (seekWindowLength - 2 * overlapLength) + lengthAdjust;
+    assert(temp >= 0);
+
+    // crosscheck that we don't have buffer overflow...
+    if ((int)inputBuffer.numSamples() < (offset + temp + overlapLength * 2))
+    {
+        return overlapLength;    // just in case, shouldn't really happen
+    }
+
+    memcpy(pOutput + channels * overlapLength, inputBuffer.ptrBegin() + channels * (offset + overlapLength), 
+        channels * sizeof(SAMPLETYPE) * temp);
+
+    // Copies the end of the current sequence from 'inputBuffer' to 
+    // 'midBuffer' for being mixed with the beginning of the next 
+    // processing sequence and so on
+    assert((offset + temp + overlapLength * 2) <= (int)inputBuffer.numSamples());
+    memcpy(pMidBuffer, inputBuffer.ptrBegin() + channels * (offset + temp + overlapLength), 
+        channels * sizeof(SAMPLETYPE) * overlapLength);
+
+    // Remove the processed samples from the input buffer. Update
+    // the difference between integer & nominal skip step to 'skipFract'
+    // in order to prevent the error from accumulating over time.
+    skipFract += nominalSkip;   // real skip size
+    ovlSkip = (int)skipFract;   // rounded to integer skip
+    skipFract -= ovlSkip;       // maintain the fraction part, i.e. real vs. integer skip
+    inputBuffer.receiveSamples((uint)ovlSkip);
+    inputBufferPosition += ovlSkip;
+
+    return overlapLength + temp;
+}
 
-        // length of sequence
-        temp = (seekWindowLength - 2 * overlapLength);
 
-        // crosscheck that we don't have buffer overflow...
-        if ((int)inputBuffer.numSamples() < (offset + temp + overlapLength * 2))
+// Copies the settings that affect the overlap position seek into a batch mode
+// worker instance
+void TDStretch::syncWorker(TDStretch *worker) const
+{
+    if ((worker->channels != channels) || (worker->overlapLength != overlapLength))
+    {
+        // re-init overlap buffer
+        worker->channels = channels;
+        worker->overlapLength = 0;
+        worker->acceptNewOverlapLength(overlapLength);
+    }
+    worker->seekLength = seekLength;
+    worker->seekMode = seekMode;
+    worker->overlapDividerBitsNorm = overlapDividerBitsNorm;
+    worker->bFrozenNormalizer = true;
+    worker->maxnorm = 0;
+}
+
+
+#ifdef _OPENMP
+
+// Processes all the sequences that fit into 'inputBuffer' so that the overlap 
+// positions are sought in parallel threads.
+//
+// The input positions of the sequences depend only on the tempo, so they can be 
+// planned in advance. The overlap position of a sequence however depends on the 
+// position chosen for the previous sequence, because the end of the previous 
+// sequence is the reference that's matched. Therefore each thread seeks its own 
+// range of sequences starting from a few warm-up sequences before the range with 
+// a guessed reference. 
+//
+// The speculative chains are verified in order. If a chain didn't converge to the
+// true positions during the warm-up (typical for tonal sounds, where a different
+// start phase persists), the first sequence of the range is sought again with the
+// true reference, and its length is adjusted so that it ends where the speculative
+// chain expects, keeping the rest of the chain valid. Thus the batch output differs
+// from sequential processing only by a few milliseconds' longer or shorter sequence 
+// at the thread range boundaries.
+void TDStretch::processBatch()
+{
+    int numThreads, numSeq, segLength;
+    int *seqPos, *offs, *adjust, *chainPrev;
+    int i, seg, pos;
+    double fract;
+    int seqLength = seekWindowLength - 2 * overlapLength;
+    int numInput = (int)inputBuffer.numSamples();
+    const SAMPLETYPE *pInput = inputBuffer.ptrBegin();
+
+    numThreads = omp_get_max_threads();
+    if (numThreads < 2) return;
+
+    // count the sequences that fit into the input buffer
+    numSeq = 0;
+    pos = 0;
+    fract = skipFract;
+    while (numInput - pos >= sampleReq)
+    {
+        numSeq ++;
+        fract += nominalSkip;
+        pos += (int)fract;
+        fract -= (int)fract;
+    }
+    if (numSeq < numThreads * BATCH_MIN_SEQUENCES) return;
+
+    if (numWorkers < numThreads)
+    {
+        TDStretch **pNewWorkers = new TDStretch*[numThreads];
+        for (i = 0; i < numWorkers; i ++)
+        {
+            pNewWorkers[i] = pWorkers[i];
+        }
+        for (; i < numThreads; i ++)
+        {
+            pNewWorkers[i] = newInstance();
+        }
+        delete[] pWorkers;
+        pWorkers = pNewWorkers;
+        numWorkers = numThreads;
+    }
+    for (i = 0; i < numThreads; i ++)
+    {
+        syncWorker(pWorkers[i]);
+    }
+
+    // plan the sequence positions the same way as 'processSequence' advances
+    seqPos = new int[numSeq];
+    offs = new int[numSeq];
+    adjust = new int[numSeq];
+    chainPrev = new int[numThreads];
+    pos = 0;
+    fract = skipFract;
+    for (i = 0; i < numSeq; i ++)
+    {
+        seqPos[i] = pos;
+        adjust[i] = 0;
+        fract += nominalSkip;
+        pos += (int)fract;
+        fract -= (int)fract;
+    }
+
+    segLength = (numSeq + numThreads - 1) / numThreads;
+
+    #pragma omp parallel for schedule(static, 1)
+    for (seg = 0; seg < numThreads; seg ++)
+    {
+        TDStretch *worker = pWorkers[seg];
+        int first = seg * segLength;
+        int end = (first + segLength < numSeq) ? first + segLength : numSeq;
+        int start, prev, k;
+
+        if (first >= end) continue;
+
+        if (first <= BATCH_WARMUP_SEQUENCES)
         {
-            continue;    // just in case, shouldn't really happen
+            // chain begins from the first sequence, whose reference is known
+            start = 0;
+            prev = 0;
+        }
+        else
+        {
+            // guess that the sequence before the warm-up was mixed at mid of the seek range
+            start = first - BATCH_WARMUP_SEQUENCES;
+            prev = seekLength / 2;
         }
 
-        outputBuffer.putSamples(inputBuffer.ptrBegin() + channels * (offset + overlapLength), (uint)temp);
+        for (k = start; k < end; k ++)
+        {
+            if (k == 0)
+            {
+                // reference of the first sequence is the current 'midBuffer'
+                memcpy(worker->pMidBuffer, pMidBuffer, channels * sizeof(SAMPLETYPE) * overlapLength);
+            }
+            else
+            {
+                // reference is the end of the previous sequence in the chain
+                memcpy(worker->pMidBuffer, pInput + channels * (seqPos[k - 1] + prev + seqLength + overlapLength), 
+                    channels * sizeof(SAMPLETYPE) * overlapLength);
+            }
 
-        // Copies the end of the current sequence from 'inputBuffer' to 
-        // 'midBuffer' for being mixed with the beginning of the next 
-        // processing sequence and so on
-        assert((offset + temp + overlapLength * 2) <= (int)inputBuffer.numSamples());
-        memcpy(pMidBuffer, inputBuffer.ptrBegin() + channels * (offset + temp + overlapLength), 
-            channels * sizeof(SAMPLETYPE) * overlapLength);
+            prev = worker->seekBestOverlapPosition(pInput + channels * seqPos[k]);
 
-        // Remove the processed samples from the input buffer. Update
-        // the difference between integer & nominal skip step to 'skipFract'
-        // in order to prevent the error from accumulating over time.
-        skipFract += nominalSkip;   // real skip size
-        ovlSkip = (int)skipFract;   // rounded to integer skip
-        skipFract -= ovlSkip;       // maintain the fraction part, i.e. real vs. integer skip
-        inputBuffer.receiveSamples((uint)ovlSkip);
+            if (k >= first)
+            {
+                offs[k] = prev;
+            }
+            else if (k == first - 1)
+            {
+                chainPrev[seg] = prev;
+            }
+        }
+    }
+
+    // verify the speculative chains in order
+    for (seg = 1; seg < numThreads; seg ++)
+    {
+        TDStretch *worker = pWorkers[0];
+        int first = seg * segLength;
+        int end = (first + segLength < numSeq) ? first + segLength : numSeq;
+        int k;
+
+        if (first >= end) break;
+        if (chainPrev[seg] == offs[first - 1] + adjust[first - 1]) continue;    // chain converged
+
+        // Seek again with the true reference until the chain can be joined. After 
+        // that the rest of the chain is valid.
+        for (k = first; k < end; k ++)
+        {
+            int offset;
+
+            memcpy(worker->pMidBuffer, pInput + channels * (seqPos[k - 1] + offs[k - 1] + adjust[k - 1] + seqLength + overlapLength), 
+                channels * sizeof(SAMPLETYPE) * overlapLength);
+            offset = worker->seekBestOverlapPosition(pInput + channels * seqPos[k]);
+            if (offset == offs[k]) break;     // converged to the speculative chain
+
+            if (seqLength + offs[k] - offset >= 0)
+            {
+                // mix at the new position, but end the sequence at the same position 
+                // as in the speculative chain
+                adjust[k] = offs[k] - offset;
+                offs[k] = offset;
+                break;
+            }
+            // sequence too short for adjusting, continue the chain sequentially
+            offs[k] = offset;
+        }
     }
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    // adapt the normalizer according to the whole batch
+    for (i = 0; i < numThreads; i ++)
+    {
+        if (pWorkers[i]->maxnorm > maxnorm) maxnorm = pWorkers[i]->maxnorm;
+    }
+    adaptNormalizer();
+#endif
+
+    // mix & output the sequences in order
+    for (i = 0; i < numSeq; i ++)
+    {
+        processSequence(offs[i], adjust[i]);
+    }
+
+    delete[] seqPos;
+    delete[] offs;
+    delete[] adjust;
+    delete[] chainPrev;
 }
 
+#endif // _OPENMP
+
 
 // Adds 'numsamples' pcs of samples from the 'samples' memory position into
 // the input of the object.
 void TDStretch::putSamples(const SAMPLETYPE *samples, uint nSamples)
 {
+    if (bTransientMode)
+    {
+        // the detector follows the input stream position of 'inputBuffer' end
+        onsetDetector.inputSamples(samples, (int)nSamples);
+    }
     // Add the samples into the input buffer
     inputBuffer.putSamples(samples, nSamples);
-    // Process the samples in input buffer
-    processSamples();
+    // Process the samples in input buffer. In pull mode they're processed 
+    // only when the output is received.
+    if (bPullMode == false)
+    {
+        processSamples();
+    }
+}
+
+
+// Enables/disables the pull mode. When disabling, processes the pending input
+// samples into the output buffer.
+void TDStretch::enablePullMode(bool enable)
+{
+    bPullMode = enable;
+    if (enable == false)
+    {
+        processSamples();
+    }
+}
+
+
+// Returns nonzero if the pull mode is enabled
+bool TDStretch::isPullModeEnabled() const
+{
+    return bPullMode;
+}
+
+
+// Outputs samples into 'output'. In pull mode, mixes the processing sequences 
+// directly into 'output' as long as whole sequences fit there.
+uint TDStretch::receiveSamples(SAMPLETYPE *output, uint maxSamples)
+{
+    uint count;
+    int offset;
+
+    // samples that have already been processed come first
+    count = outputBuffer.receiveSamples(output, maxSamples);
+    if (bPullMode == false) return count;
+
+    updateSequenceParameters();
+    while ((count < maxSamples) && ((int)inputBuffer.numSamples() >= sampleReq))
+    {
+        offset = seekBestOverlapPosition(inputBuffer.ptrBegin());
+
+        if (maxSamples - count >= (uint)(seekWindowLength - overlapLength))
+        {
+            // whole sequence fits into 'output', mix it there directly
+            count += (uint)mixSequence(output + channels * count, offset, 0);
+        }
+        else
+        {
+            // mix the sequence into 'outputBuffer' and output the part that fits
+            processSequence(offset, 0);
+            count += outputBuffer.receiveSamples(output + channels * count, maxSamples - count);
+        }
+        updateSequenceParameters();
+    }
+
+    return count;
+}
+
+
+// Removes samples from the output. In pull mode processes the pending input first.
+uint TDStretch::receiveSamples(uint maxSamples)
+{
+    if (bPullMode)
+    {
+        processSamples();
+    }
+    return outputBuffer.receiveSamples(maxSamples);
+}
+
+
+// Returns number of samples available for output. In pull mode, that includes the 
+// sequences that can be processed from the pending input. The tempo envelope and
+// transient mode update the sequence parameters of the pending sequences the same
+// way as in processing them, so the amount is exact.
+uint TDStretch::numSamples() const
+{
+    SEQPARAMS params;
+    int pos, numInput;
+    uint numOutput;
+    double fract;
+
+    if (bPullMode == false) return outputBuffer.numSamples();
+
+    // count the sequences that fit into the input buffer, the same way as
+    // 'mixSequence' advances in the input
+    getSeqParameters(params);
+    numInput = (int)inputBuffer.numSamples();
+    numOutput = outputBuffer.numSamples();
+    pos = 0;
+    fract = skipFract;
+    updateSequenceParameters(params, inputBufferPosition, fract);
+    while (numInput - pos >= params.sampleReq)
+    {
+        numOutput += (uint)(params.seekWindowLength - overlapLength);
+        fract += params.nominalSkip;
+        pos += (int)fract;
+        fract -= (int)fract;
+        updateSequenceParameters(params, inputBufferPosition + pos, fract);
+    }
+
+    return numOutput;
+}
+
+
+// Returns nonzero if there aren't any samples available for outputting
+int TDStretch::isEmpty() const
+{
+    return (numSamples() == 0) ? 1 : 0;
+}
+
+
+// Returns a pointer to the beginning of the output samples
+SAMPLETYPE *TDStretch::ptrBegin()
+{
+    if (bPullMode)
+    {
+        processSamples();
+    }
+    return outputBuffer.ptrBegin();
 }
 
 
@@ -726,6 +1762,59 @@ void TDStretch::acceptNewOverlapLength(int newOverlapLength)
         pMidBuffer = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(pMidBufferUnaligned);
 
         clearMidBuffer();
+
+        delete[] pFadeUnaligned;
+
+        pFadeUnaligned = new SAMPLETYPE[2 * overlapLength * channels + 16 / sizeof(SAMPLETYPE)];
+        // overlapLength is divisible by 8, so also 'pFadeOut' gets aligned to 16 byte boundary
+        pFadeIn = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(pFadeUnaligned);
+        pFadeOut = pFadeIn + overlapLength * channels;
+    }
+
+    calcCrossFadeTable();
+}
+
+
+/// Calculates the fade-in & fade-out gains for the samples of the overlapping 
+/// period according to the cross-fade shape. The gains are repeated for each 
+/// channel, so that the overlap routines can process all the channels alike.
+void TDStretch::calcCrossFadeTable()
+{
+    int i, c;
+
+    for (i = 0; i < overlapLength; i ++)
+    {
+        double fadeIn, fadeOut;
+        double x = (double)i / (double)overlapLength;
+
+        switch (crossFade)
+        {
+            case CROSSFADE_COSINE:
+                fadeIn = 0.5 - 0.5 * cos(PI * x);
+                fadeOut = 1.0 - fadeIn;
+                break;
+
+            case CROSSFADE_EQUALPOWER:
+                fadeIn = sin(0.5 * PI * x);
+                fadeOut = cos(0.5 * PI * x);
+                break;
+
+            default:
+                fadeIn = x;
+                fadeOut = 1.0 - fadeIn;
+                break;
+        }
+
+        for (c = 0; c < channels; c ++)
+        {
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+            pFadeIn[i * channels + c] = (short)(fadeIn * (1 << CROSSFADE_BITS) + 0.5);
+            pFadeOut[i * channels + c] = (short)(fadeOut * (1 << CROSSFADE_BITS) + 0.5);
+#else
+            pFadeIn[i * channels + c] = (float)fadeIn;
+            pFadeOut[i * channels + c] = (float)fadeOut;
+#endif
+        }
     }
 }
 
@@ -746,7 +1835,16 @@ TDStretch * TDStretch::newInstance()
 
     uExtensions = detectCPUextensions();
 
-    // Check if MMX/SSE instruction set extensions supported by CPU
+    // Check if MMX/SSE/AVX instruction set extensions supported by CPU
+
+#if defined(SOUNDTOUCH_ALLOW_SSE41) && defined(SOUNDTOUCH_ALLOW_MMX)
+    // SSE4.1 routines available only with integer sample types
+    if ((uExtensions & SUPPORT_SSE41) && (uExtensions & SUPPORT_MMX))
+    {
+        return ::new TDStretchSSE41;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_SSE41
 
 #ifdef SOUNDTOUCH_ALLOW_MMX
     // MMX routines available only with integer sample types
@@ -758,6 +1856,26 @@ TDStretch * TDStretch::newInstance()
 #endif // SOUNDTOUCH_ALLOW_MMX
 
 
+#ifdef SOUNDTOUCH_ALLOW_AVX512
+    if (uExtensions & SUPPORT_AVX512)
+    {
+        // AVX-512 support
+        return ::new TDStretchAVX512;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_AVX512
+
+
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    if (uExtensions & SUPPORT_AVX2)
+    {
+        // AVX2 & FMA support
+        return ::new TDStretchAVX2;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_AVX2
+
+
 #ifdef SOUNDTOUCH_ALLOW_SSE
     if (uExtensions & SUPPORT_SSE)
     {
@@ -782,41 +1900,18 @@ TDStretch * TDStretch::newInstance()
 
 #ifdef SOUNDTOUCH_INTEGER_SAMPLES
 
-// Overlaps samples in 'midBuffer' with the samples in 'input'. The 'Stereo' 
-// version of the routine.
-void TDStretch::overlapStereo(short *poutput, const short *input) const
+// Overlaps samples in 'midBuffer' with the samples in 'input', weighing them
+// with the fixed-point fade gains
+void TDStretch::overlapMix(short *poutput, const short *input) const
 {
     int i;
-    short temp;
-    int cnt2;
 
-    for (i = 0; i < overlapLength ; i ++) 
+    for (i = 0; i < channels * overlapLength; i ++) 
     {
-        temp = (short)(overlapLength - i);
-        cnt2 = 2 * i;
-        poutput[cnt2] = (input[cnt2] * i + pMidBuffer[cnt2] * temp )  / overlapLength;
-        poutput[cnt2 + 1] = (input[cnt2 + 1] * i + pMidBuffer[cnt2 + 1] * temp ) / overlapLength;
-    }
-}
-
-
-// Overlaps samples in 'midBuffer' with the samples in 'input'. The 'Multi'
-// version of the routine.
-void TDStretch::overlapMulti(SAMPLETYPE *poutput, const SAMPLETYPE *input) const
-{
-    SAMPLETYPE m1=(SAMPLETYPE)0;
-    SAMPLETYPE m2;
-    int i=0;
-
-    for (m2 = (SAMPLETYPE)overlapLength; m2; m2 --)
-    {
-        for (int c = 0; c < channels; c ++)
-        {
-            poutput[i] = (input[i] * m1 + pMidBuffer[i] * m2)  / overlapLength;
-            i++;
-        }
+        int temp = (input[i] * pFadeIn[i] + pMidBuffer[i] * pFadeOut[i]) >> CROSSFADE_BITS;
 
-        m1++;
+        // equal-power fade may exceed the sample range
+        poutput[i] = (short)((temp > 32767) ? 32767 : ((temp < -32768) ? -32768 : temp));
     }
 }
 
@@ -855,53 +1950,11 @@ void TDStretch::calculateOverlapLength(int aoverlapMs)
 }
 
 
-double TDStretch::calcCrossCorr(const short *mixingPos, const short *compare, double &norm)
-{
-    long corr;
-    unsigned long lnorm;
-    int i;
-
-    corr = lnorm = 0;
-    // Same routine for stereo and mono. For stereo, unroll loop for better
-    // efficiency and gives slightly better resolution against rounding. 
-    // For mono it same routine, just  unrolls loop by factor of 4
-    for (i = 0; i < channels * overlapLength; i += 4) 
-    {
-        corr += (mixingPos[i] * compare[i] + 
-                 mixingPos[i + 1] * compare[i + 1]) >> overlapDividerBitsNorm;  // notice: do intermediate division here to avoid integer overflow
-        corr += (mixingPos[i + 2] * compare[i + 2] + 
-                mixingPos[i + 3] * compare[i + 3]) >> overlapDividerBitsNorm;
-        lnorm += (mixingPos[i] * mixingPos[i] + 
-                mixingPos[i + 1] * mixingPos[i + 1]) >> overlapDividerBitsNorm; // notice: do intermediate division here to avoid integer overflow
-        lnorm += (mixingPos[i + 2] * mixingPos[i + 2] + 
-                mixingPos[i + 3] * mixingPos[i + 3]) >> overlapDividerBitsNorm;
-    }
-
-    if (lnorm > maxnorm)
-    {
-        maxnorm = lnorm;
-    }
-    // Normalize result by dividing by sqrt(norm) - this step is easiest 
-    // done using floating point operation
-    norm = (double)lnorm;
-    return (double)corr / sqrt((norm < 1e-9) ? 1.0 : norm);
-}
-
-
-/// Update cross-correlation by accumulating "norm" coefficient by previously calculated value
-double TDStretch::calcCrossCorrAccumulate(const short *mixingPos, const short *compare, double &norm)
+double TDStretch::calcCrossCorr(const short *mixingPos, const short *compare)
 {
     long corr;
-    unsigned long lnorm;
     int i;
 
-    // cancel first normalizer tap from previous round
-    lnorm = 0;
-    for (i = 1; i <= channels; i ++)
-    {
-        lnorm -= (mixingPos[-i] * mixingPos[-i]) >> overlapDividerBitsNorm;
-    }
-
     corr = 0;
     // Same routine for stereo and mono. For stereo, unroll loop for better
     // efficiency and gives slightly better resolution against rounding. 
@@ -914,22 +1967,8 @@ double TDStretch::calcCrossCorrAccumulate(const short *mixingPos, const short *c
                  mixingPos[i + 3] * compare[i + 3]) >> overlapDividerBitsNorm;
     }
 
-    // update normalizer with last samples of this round
-    for (int j = 0; j < channels; j ++)
-    {
-        i --;
-        lnorm += (mixingPos[i] * mixingPos[i]) >> overlapDividerBitsNorm;
-    }
-
-    norm += (double)lnorm;
-    if (norm > maxnorm)
-    {
-        maxnorm = (unsigned long)norm;
-    }
-
-    // Normalize result by dividing by sqrt(norm) - this step is easiest 
-    // done using floating point operation
-    return (double)corr / sqrt((norm < 1e-9) ? 1.0 : norm);
+    // undo the intermediate division
+    return (double)corr * (double)(1 << overlapDividerBitsNorm);
 }
 
 #endif // SOUNDTOUCH_INTEGER_SAMPLES
@@ -942,53 +1981,14 @@ double TDStretch::calcCrossCorrAccumulate(const short *mixingPos, const short *c
 #ifdef SOUNDTOUCH_FLOAT_SAMPLES
 
 // Overlaps samples in 'midBuffer' with the samples in 'pInput'
-void TDStretch::overlapStereo(float *pOutput, const float *pInput) const
+void TDStretch::overlapMix(float *pOutput, const float *pInput) const
 {
     int i;
-    float fScale;
-    float f1;
-    float f2;
-
-    fScale = 1.0f / (float)overlapLength;
 
-    f1 = 0;
-    f2 = 1.0f;
-
-    for (i = 0; i < 2 * (int)overlapLength ; i += 2) 
+    for (i = 0; i < channels * overlapLength; i += 2) 
     {
-        pOutput[i + 0] = pInput[i + 0] * f1 + pMidBuffer[i + 0] * f2;
-        pOutput[i + 1] = pInput[i + 1] * f1 + pMidBuffer[i + 1] * f2;
-
-        f1 += fScale;
-        f2 -= fScale;
-    }
-}
-
-
-// Overlaps samples in 'midBuffer' with the samples in 'input'. 
-void TDStretch::overlapMulti(float *pOutput, const float *pInput) const
-{
-    int i;
-    float fScale;
-    float f1;
-    float f2;
-
-    fScale = 1.0f / (float)overlapLength;
-
-    f1 = 0;
-    f2 = 1.0f;
-
-    i=0;
-    for (int i2 = 0; i2 < overlapLength; i2 ++)
-    {
-        // note: Could optimize this slightly by taking into account that always channels > 2
-        for (int c = 0; c < channels; c ++)
-        {
-            pOutput[i] = pInput[i] * f1 + pMidBuffer[i] * f2;
-            i++;
-        }
-        f1 += fScale;
-        f2 -= fScale;
+        pOutput[i + 0] = pInput[i + 0] * pFadeIn[i + 0] + pMidBuffer[i + 0] * pFadeOut[i + 0];
+        pOutput[i + 1] = pInput[i + 1] * pFadeIn[i + 1] + pMidBuffer[i + 1] * pFadeOut[i + 1];
     }
 }
 
@@ -1010,13 +2010,12 @@ void TDStretch::calculateOverlapLength(int overlapInMsec)
 
 
 /// Calculate cross-correlation
-double TDStretch::calcCrossCorr(const float *mixingPos, const float *compare, double &anorm)
+double TDStretch::calcCrossCorr(const float *mixingPos, const float *compare)
 {
     double corr;
-    double norm;
     int i;
 
-    corr = norm = 0;
+    corr = 0;
     // Same routine for stereo and mono. For Stereo, unroll by factor of 2.
     // For mono it's same routine yet unrollsd by factor of 4.
     for (i = 0; i < channels * overlapLength; i += 4) 
@@ -1024,54 +2023,12 @@ double TDStretch::calcCrossCorr(const float *mixingPos, const float *compare, do
         corr += mixingPos[i] * compare[i] +
                 mixingPos[i + 1] * compare[i + 1];
 
-        norm += mixingPos[i] * mixingPos[i] + 
-                mixingPos[i + 1] * mixingPos[i + 1];
-
         // unroll the loop for better CPU efficiency:
         corr += mixingPos[i + 2] * compare[i + 2] +
                 mixingPos[i + 3] * compare[i + 3];
-
-        norm += mixingPos[i + 2] * mixingPos[i + 2] +
-                mixingPos[i + 3] * mixingPos[i + 3];
-    }
-
-    anorm = norm;
-    return corr / sqrt((norm < 1e-9 ? 1.0 : norm));
-}
-
-
-/// Update cross-correlation by accumulating "norm" coefficient by previously calculated value
-double TDStretch::calcCrossCorrAccumulate(const float *mixingPos, const float *compare, double &norm)
-{
-    double corr;
-    int i;
-
-    corr = 0;
-
-    // cancel first normalizer tap from previous round
-    for (i = 1; i <= channels; i ++)
-    {
-        norm -= mixingPos[-i] * mixingPos[-i];
-    }
-
-    // Same routine for stereo and mono. For Stereo, unroll by factor of 2.
-    // For mono it's same routine yet unrollsd by factor of 4.
-    for (i = 0; i < channels * overlapLength; i += 4) 
-    {
-        corr += mixingPos[i] * compare[i] +
-                mixingPos[i + 1] * compare[i + 1] +
-                mixingPos[i + 2] * compare[i + 2] +
-                mixingPos[i + 3] * compare[i + 3];
-    }
-
-    // update normalizer with last samples of this round
-    for (int j = 0; j < channels; j ++)
-    {
-        i --;
-        norm += mixingPos[i] * mixingPos[i];
     }
 
-    return corr / sqrt((norm < 1e-9 ? 1.0 : norm));
+    return corr;
 }
 
 
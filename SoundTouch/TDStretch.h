@@ -48,6 +48,8 @@
 #include "STTypes.h"
 #include "RateTransposer.h"
 #include "FIFOSamplePipe.h"
+#include "FFT.h"
+#include "OnsetDetector.h"
 
 namespace soundtouch
 {
@@ -104,11 +106,31 @@ namespace soundtouch
 /// Increasing this value increases computational burden & vice versa.
 #define DEFAULT_OVERLAP_MS      8
 
+/// Fixed-point precision (bits) of the cross-fade coefficients in the integer
+/// sample version
+#define CROSSFADE_BITS          14
+
 
 /// Class that does the time-stretch (tempo change) effect for the processed
 /// sound.
 class TDStretch : public FIFOProcessor
 {
+public:
+    /// Algorithms for seeking the best overlap-mixing position
+    enum SEEKMODE {
+        SEEK_FULL = 0,      ///< Test every position over the seek window
+        SEEK_QUICK,         ///< Hierarchical quick scan, minor quality compromise
+        SEEK_FFT,           ///< Full-range correlation with FFT-based convolution
+        SEEK_PYRAMID        ///< Coarse-to-fine search over 4x/2x decimated signal
+    };
+
+    /// Window shapes for cross-fading the overlapping sequences
+    enum CROSSFADE {
+        CROSSFADE_LINEAR = 0,   ///< Linear fade, sum of the gains is constant
+        CROSSFADE_COSINE,       ///< Raised-cosine fade, as linear but with smooth ends
+        CROSSFADE_EQUALPOWER    ///< Sine/cosine fade, sum of the gain powers is constant
+    };
+
 protected:
     int channels;
     int sampleReq;
@@ -131,37 +153,116 @@ protected:
     double nominalSkip;
     double skipFract;
 
-    bool bQuickSeek;
+    SEEKMODE seekMode;
     bool bAutoSeqSetting;
     bool bAutoSeekSetting;
 
     SAMPLETYPE *pMidBuffer;
     SAMPLETYPE *pMidBufferUnaligned;
 
+    /// Cross-fade shape & the fade-in/fade-out gain tables for the samples of the 
+    /// overlapping period
+    CROSSFADE crossFade;
+    SAMPLETYPE *pFadeIn;
+    SAMPLETYPE *pFadeOut;
+    SAMPLETYPE *pFadeUnaligned;
+
     FIFOSampleBuffer outputBuffer;
     FIFOSampleBuffer inputBuffer;
 
+    /// FFT & work buffer for the FFT-based correlation seek
+    FFT fft;
+    double *pFFTWork;
+
+    /// Work buffer & its size in items for the decimated signal copies of the
+    /// multi-resolution seek
+    float *pPyramidWork;
+    int pyramidWorkSize;
+
+    /// Norms of the mixing positions of the current seek & the table size
+    double *pNormTable;
+    int normTableSize;
+
+    /// Nonzero if the CPU supports the SSE2 version of the norm table calculation
+    bool bSSE2NormTable;
+
+    /// Tempo envelope: breakpoint positions in the input stream (sample frames) & 
+    /// tempo values at them, and position of 'inputBuffer' beginning in the input stream
+    double *pEnvPosition;
+    double *pEnvTempo;
+    int envLength;
+    double inputBufferPosition;
+
+    /// Pull mode: input gets processed only when output is received
+    bool bPullMode;
+
+    /// Transient mode: onset detector for the input, and whether the next 
+    /// processing sequence contains an onset
+    bool bTransientMode;
+    bool bTransientRegion;
+    OnsetDetector onsetDetector;
+
+    /// Batch mode: worker instances that seek the overlap positions of several 
+    /// sequences in parallel threads
+    bool bBatchMode;
+    bool bFrozenNormalizer;
+    TDStretch **pWorkers;
+    int numWorkers;
+
     void acceptNewOverlapLength(int newOverlapLength);
+    void calcCrossFadeTable();
 
     virtual void clearCrossCorrState();
     void calculateOverlapLength(int overlapMs);
 
-    virtual double calcCrossCorr(const SAMPLETYPE *mixingPos, const SAMPLETYPE *compare, double &norm);
-    virtual double calcCrossCorrAccumulate(const SAMPLETYPE *mixingPos, const SAMPLETYPE *compare, double &norm);
+    /// Calculates cross-correlation of 'mixingPos' and 'compare' over the overlapping
+    /// period, without normalization. The norms are precalculated into 'pNormTable'.
+    virtual double calcCrossCorr(const SAMPLETYPE *mixingPos, const SAMPLETYPE *compare);
+
+    void calcNormTable(const SAMPLETYPE *refPos);
+#ifdef SOUNDTOUCH_ALLOW_FLOAT_SSE
+    /// SSE2 version of the energy prefix sum pass of 'calcNormTable' for mono & stereo sound
+    void calcEnergyPrefixSSE2(const SAMPLETYPE *refPos, int refFrames);
+#endif // SOUNDTOUCH_ALLOW_FLOAT_SSE
+    double normalizeCorr(double corr, int offset) const;
 
     virtual int seekBestOverlapPositionFull(const SAMPLETYPE *refPos);
     virtual int seekBestOverlapPositionQuick(const SAMPLETYPE *refPos);
+    virtual int seekBestOverlapPositionFFT(const SAMPLETYPE *refPos);
+    virtual int seekBestOverlapPositionPyramid(const SAMPLETYPE *refPos);
     virtual int seekBestOverlapPosition(const SAMPLETYPE *refPos);
+    SEEKMODE getEffectiveSeekMode() const;
 
-    virtual void overlapStereo(SAMPLETYPE *output, const SAMPLETYPE *input) const;
-    virtual void overlapMono(SAMPLETYPE *output, const SAMPLETYPE *input) const;
-    virtual void overlapMulti(SAMPLETYPE *output, const SAMPLETYPE *input) const;
+    /// Cross-fades 'midBuffer' with 'input' over the overlapping period using the 
+    /// fade tables. Tables have a gain for each sample, so same routine works for 
+    /// any channel count.
+    virtual void overlapMix(SAMPLETYPE *output, const SAMPLETYPE *input) const;
 
     void clearMidBuffer();
     void overlap(SAMPLETYPE *output, const SAMPLETYPE *input, uint ovlPos) const;
 
-    void calcSeqParameters();
-    void adaptNormalizer();
+    /// Tempo dependent parameters of a processing sequence, see 'calcSeqParameters'
+    struct SEQPARAMS
+    {
+        double tempo;
+        bool transient;
+        int seekWindowLength;
+        int seekLength;
+        double nominalSkip;
+        int sampleReq;
+    };
+
+    void calcSeqParameters(SEQPARAMS &params) const;
+    void getSeqParameters(SEQPARAMS &params) const;
+    void setSeqParameters(const SEQPARAMS &params);
+    void updateSequenceParameters(SEQPARAMS &params, double position, double fract) const;
+    void updateSequenceParameters();
+    virtual void adaptNormalizer();
+
+    void syncWorker(TDStretch *worker) const;
+    void processBatch();
+    void processSequence(int offset, int lengthAdjust);
+    int mixSequence(SAMPLETYPE *pOutput, int offset, int lengthAdjust);
 
 
     /// Changes the tempo of the given sound samples.
@@ -193,6 +294,26 @@ public:
     /// tempo, larger faster tempo.
     void setTempo(double newTempo);
 
+    /// Sets tempo envelope of 'count' breakpoints. 'positions' are the breakpoint 
+    /// positions in the input stream as sample frames counted from the stream beginning 
+    /// (see getInputPosition), in ascending order, and 'tempos' the tempo values at them. 
+    /// Tempo is interpolated linearly between the breakpoints, and kept constant before 
+    /// the first and after the last breakpoint.
+    ///
+    /// The tempo gets updated at each processing sequence boundary, so that a long input
+    /// buffer with varying tempo can be processed with a single putSamples call. The 
+    /// envelope overrides 'setTempo' setting until cleared by setting zero breakpoints.
+    /// Batch processing mode isn't used while the envelope is set.
+    void setTempoEnvelope(const double *positions, const double *tempos, int count);
+
+    /// Returns tempo of the tempo envelope at input stream position 'position', or the
+    /// current tempo if no envelope is set.
+    double getEnvelopeTempo(double position) const;
+
+    /// Returns the input stream position, i.e. how many sample frames have been fed into 
+    /// the input since the stream beginning.
+    double getInputPosition() const;
+
     /// Returns nonzero if there aren't any samples available for outputting.
     virtual void clear();
 
@@ -209,6 +330,42 @@ public:
     /// Returns nonzero if the quick seeking algorithm is enabled.
     bool isQuickSeekEnabled() const;
 
+    /// Sets the overlap position seeking algorithm, see SEEKMODE
+    void setSeekMode(SEEKMODE mode);
+
+    /// Returns the overlap position seeking algorithm in use
+    SEEKMODE getSeekMode() const;
+
+    /// Sets the window shape for cross-fading the overlapping sequences, see CROSSFADE
+    void setCrossFade(CROSSFADE shape);
+
+    /// Returns the cross-fade window shape in use
+    CROSSFADE getCrossFade() const;
+
+    /// Enables/disables the batch processing mode for offline processing of large 
+    /// buffers. In batch mode the overlap positions of all the sequences available 
+    /// in the input buffer are sought in parallel threads, and the output is then 
+    /// stitched together in order. The result differs from the normal mode only so 
+    /// that the sequences at thread range boundaries may be a few milliseconds longer
+    /// or shorter, and that integer sample version adapts its normalizer once per batch.
+    ///
+    /// Has effect only if the library is compiled with OpenMP support.
+    void enableBatchMode(bool enable);
+
+    /// Returns nonzero if the batch processing mode is enabled.
+    bool isBatchModeEnabled() const;
+
+    /// Enables/disables the transient mode. In transient mode sound onsets such as
+    /// drum hits are detected from the input, and the processing sequences that 
+    /// contain an onset are made shorter and their overlap position is sought 
+    /// with the full search, while in the steady regions longer sequences with a 
+    /// cheaper search are used. This keeps the attacks sharp without slowing down 
+    /// the processing. Batch processing mode isn't used in transient mode.
+    void enableTransientMode(bool enable);
+
+    /// Returns nonzero if the transient mode is enabled.
+    bool isTransientModeEnabled() const;
+
     /// Sets routine control parameters. These control are certain time constants
     /// defining how the sound is stretched to the desired duration.
     //
@@ -236,6 +393,33 @@ public:
                                                     ///< contains both channels if stereo
             );
 
+    /// Enables/disables the pull mode. In pull mode the input samples are processed 
+    /// only when the output samples are received, and the processing sequences get 
+    /// mixed directly into the buffer given to 'receiveSamples' instead of copying 
+    /// them via the output buffer. Disabling the pull mode processes the pending input.
+    void enablePullMode(bool enable);
+
+    /// Returns nonzero if the pull mode is enabled.
+    bool isPullModeEnabled() const;
+
+    /// Outputs samples from beginning of the sample buffer, see FIFOSamplePipe. In 
+    /// pull mode processes the pending input directly into 'output'.
+    virtual uint receiveSamples(SAMPLETYPE *output, uint maxSamples);
+
+    /// Removes samples from beginning of the sample buffer, see FIFOSamplePipe.
+    virtual uint receiveSamples(uint maxSamples);
+
+    /// Returns number of samples available for output. In pull mode, includes the 
+    /// samples that can be processed from the pending input.
+    virtual uint numSamples() const;
+
+    /// Returns nonzero if there aren't any samples available for outputting.
+    virtual int isEmpty() const;
+
+    /// Returns a pointer to the beginning of the output samples, see FIFOSamplePipe.
+    /// In pull mode processes the pending input first.
+    virtual SAMPLETYPE *ptrBegin();
+
     /// return nominal input sample requirement for triggering a processing batch
     int getInputSampleReq() const
     {
@@ -258,24 +442,61 @@ public:
     class TDStretchMMX : public TDStretch
     {
     protected:
-        double calcCrossCorr(const short *mixingPos, const short *compare, double &norm);
-        double calcCrossCorrAccumulate(const short *mixingPos, const short *compare, double &norm);
-        virtual void overlapStereo(short *output, const short *input) const;
+        double calcCrossCorr(const short *mixingPos, const short *compare);
+        virtual void overlapMix(short *output, const short *input) const;
         virtual void clearCrossCorrState();
     };
 #endif /// SOUNDTOUCH_ALLOW_MMX
 
 
+#if defined(SOUNDTOUCH_ALLOW_SSE41) && defined(SOUNDTOUCH_ALLOW_MMX)
+    /// Class that implements SSE4.1 optimized routines for 16bit integer samples type. 
+    /// Cross-correlation is accumulated with 64bit precision without intermediate 
+    /// divisions, so that the adaptive normalizer isn't needed.
+    class TDStretchSSE41 : public TDStretchMMX
+    {
+    protected:
+        double calcCrossCorr(const short *mixingPos, const short *compare);
+        virtual void overlapMix(short *output, const short *input) const;
+        virtual void adaptNormalizer();
+    };
+#endif /// SOUNDTOUCH_ALLOW_SSE41
+
+
 #ifdef SOUNDTOUCH_ALLOW_SSE
     /// Class that implements SSE optimized routines for floating point samples type.
     class TDStretchSSE : public TDStretch
     {
     protected:
-        double calcCrossCorr(const float *mixingPos, const float *compare, double &norm);
-        double calcCrossCorrAccumulate(const float *mixingPos, const float *compare, double &norm);
+        double calcCrossCorr(const float *mixingPos, const float *compare);
+        virtual void overlapMix(float *output, const float *input) const;
     };
 
 #endif /// SOUNDTOUCH_ALLOW_SSE
 
+
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    /// Class that implements AVX2 & FMA optimized routines for floating point samples type.
+    class TDStretchAVX2 : public TDStretch
+    {
+    protected:
+        double calcCrossCorr(const float *mixingPos, const float *compare);
+        virtual void overlapMix(float *output, const float *input) const;
+    };
+
+#endif /// SOUNDTOUCH_ALLOW_AVX2
+
+
+#ifdef SOUNDTOUCH_ALLOW_AVX512
+    /// Class that implements AVX-512 optimized routines for floating point samples type.
+    class TDStretchAVX512 : public TDStretch
+    {
+    protected:
+        double calcCrossCorr(const float *mixingPos, const float *compare);
+        virtual void overlapMix(float *output, const float *input) const;
+    };
+
+#endif /// SOUNDTOUCH_ALLOW_AVX512
+
 }
 #endif  /// TDStretch_H
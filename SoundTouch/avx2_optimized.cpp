@@ -0,0 +1,357 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// AVX2 & FMA optimized routines for Intel Haswell, AMD Excavator and later
+/// CPUs. All AVX2 optimized functions have been gathered into this single
+/// source code file, regardless to their class or original source code file,
+/// in order to ease porting the library to other compiler and processor
+/// platforms.
+///
+/// The AVX2-optimizations are programmed using compiler intrinsics that are
+/// supported both by Microsoft Visual C++ and GCC compilers. With GCC, the
+/// AVX2 & FMA code generation gets enabled per function with the 'target'
+/// attribute, so that rest of the library can be compiled for baseline CPU
+/// and the routines get called only if the CPU supports these extensions.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "cpu_detect.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+
+// AVX2 routines available only with float sample type
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of AVX2 optimized functions of class 'TDStretchAVX2'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "TDStretch.h"
+#include <immintrin.h>
+
+#if defined(__GNUC__)
+    // enable AVX2 & FMA instructions for the functions of this file only
+    #define ST_TARGET_AVX2  __attribute__((target("avx2,fma")))
+#else
+    #define ST_TARGET_AVX2
+#endif
+
+
+// Returns sum of the 8 float items in 'v'
+ST_TARGET_AVX2
+static inline float horizontalSum(__m256 v)
+{
+    __m128 vSum;
+
+    vSum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    vSum = _mm_add_ps(vSum, _mm_movehl_ps(vSum, vSum));
+    vSum = _mm_add_ss(vSum, _mm_shuffle_ps(vSum, vSum, 1));
+    return _mm_cvtss_f32(vSum);
+}
+
+
+// Calculates cross correlation of two buffers
+ST_TARGET_AVX2
+double TDStretchAVX2::calcCrossCorr(const float *pV1, const float *pV2)
+{
+    int i;
+    int count;
+    float corr;
+    __m256 vSum0, vSum1;
+
+    // Unlike in SSE version, unaligned loads are about as fast as aligned
+    // loads in AVX2-capable CPUs, so all positions get evaluated.
+    count = channels * overlapLength;
+    vSum0 = vSum1 = _mm256_setzero_ps();
+
+    // Unroll the loop by factor of 2 * 8 items, using two separate
+    // accumulators to hide the FMA instruction latency
+    for (i = 0; i <= count - 16; i += 16)
+    {
+        vSum0 = _mm256_fmadd_ps(_mm256_loadu_ps(pV1 + i), _mm256_loadu_ps(pV2 + i), vSum0);
+        vSum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pV1 + i + 8), _mm256_loadu_ps(pV2 + i + 8), vSum1);
+    }
+    for (; i <= count - 8; i += 8)
+    {
+        vSum0 = _mm256_fmadd_ps(_mm256_loadu_ps(pV1 + i), _mm256_loadu_ps(pV2 + i), vSum0);
+    }
+
+    corr = horizontalSum(_mm256_add_ps(vSum0, vSum1));
+
+    // remaining items, if any
+    for (; i < count; i ++)
+    {
+        corr += pV1[i] * pV2[i];
+    }
+
+    return (double)corr;
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'pInput' using the fade 
+// gain tables
+ST_TARGET_AVX2
+void TDStretchAVX2::overlapMix(float *pOutput, const float *pInput) const
+{
+    int i;
+    int count;
+
+    count = channels * overlapLength;
+
+    for (i = 0; i <= count - 8; i += 8)
+    {
+        __m256 vMix = _mm256_mul_ps(_mm256_loadu_ps(pMidBuffer + i), _mm256_loadu_ps(pFadeOut + i));
+
+        _mm256_storeu_ps(pOutput + i, _mm256_fmadd_ps(_mm256_loadu_ps(pInput + i), _mm256_loadu_ps(pFadeIn + i), vMix));
+    }
+
+    // remaining items, if any
+    for (; i < count; i ++)
+    {
+        pOutput[i] = pInput[i] * pFadeIn[i] + pMidBuffer[i] * pFadeOut[i];
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of AVX2 optimized functions of class 'FIRFilterAVX2'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "FIRFilter.h"
+
+// Register-blocked filter routine for mono & stereo sound, see the SSE version
+// 'evaluateBlockedSSE'. Output tiles are 8 registers of 8 items, so that the 
+// 8 independent accumulators hide the FMA latency.
+template <int CHANNELS>
+ST_TARGET_AVX2
+static int evaluateBlockedAVX2(float *dest, const float *source, const float *coeffs, uint length, int count)
+{
+    const int numItems = count * CHANNELS;
+    const int numTiles = numItems / 64;
+    int t, j;
+
+    // each thread gets contiguous range of output tiles
+    #pragma omp parallel for schedule(static)
+    for (t = 0; t < numTiles; t ++)
+    {
+        const float *pSrc = source + 64 * t;
+        __m256 sum0, sum1, sum2, sum3, sum4, sum5, sum6, sum7;
+        uint i;
+
+        sum0 = sum1 = sum2 = sum3 = sum4 = sum5 = sum6 = sum7 = _mm256_setzero_ps();
+        for (i = 0; i < length; i ++)
+        {
+            __m256 vCoef = _mm256_broadcast_ss(coeffs + 2 * i);
+
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc), vCoef, sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 8), vCoef, sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 16), vCoef, sum2);
+            sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 24), vCoef, sum3);
+            sum4 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 32), vCoef, sum4);
+            sum5 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 40), vCoef, sum5);
+            sum6 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 48), vCoef, sum6);
+            sum7 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 56), vCoef, sum7);
+            pSrc += CHANNELS;
+        }
+
+        _mm256_storeu_ps(dest + 64 * t, sum0);
+        _mm256_storeu_ps(dest + 64 * t + 8, sum1);
+        _mm256_storeu_ps(dest + 64 * t + 16, sum2);
+        _mm256_storeu_ps(dest + 64 * t + 24, sum3);
+        _mm256_storeu_ps(dest + 64 * t + 32, sum4);
+        _mm256_storeu_ps(dest + 64 * t + 40, sum5);
+        _mm256_storeu_ps(dest + 64 * t + 48, sum6);
+        _mm256_storeu_ps(dest + 64 * t + 56, sum7);
+    }
+
+    // remaining items one register at time
+    for (j = 64 * numTiles; j <= numItems - 8; j += 8)
+    {
+        const float *pSrc = source + j;
+        __m256 sum = _mm256_setzero_ps();
+        uint i;
+
+        for (i = 0; i < length; i ++)
+        {
+            sum = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc), _mm256_broadcast_ss(coeffs + 2 * i), sum);
+            pSrc += CHANNELS;
+        }
+        _mm256_storeu_ps(dest + j, sum);
+    }
+
+    // and the last ones one item at time
+    for (; j < numItems; j ++)
+    {
+        const float *pSrc = source + j;
+        float sum = 0;
+        uint i;
+
+        for (i = 0; i < length; i ++)
+        {
+            sum += pSrc[0] * coeffs[2 * i];
+            pSrc += CHANNELS;
+        }
+        dest[j] = sum;
+    }
+
+    return count;
+}
+
+
+// AVX2-optimized version of the filter routine for mono sound
+uint FIRFilterAVX2::evaluateFilterMono(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)(numSamples - length);
+
+    if (count < 1) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert(filterCoeffsAlign != NULL);
+
+    return (uint)evaluateBlockedAVX2<1>(dest, source, filterCoeffsAlign, length, count);
+}
+
+
+// AVX2-optimized version of the filter routine for stereo sound
+uint FIRFilterAVX2::evaluateFilterStereo(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)(numSamples - length);
+
+    if (count < 1) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert(filterCoeffsAlign != NULL);
+
+    return (uint)evaluateBlockedAVX2<2>(dest, source, filterCoeffsAlign, length, count);
+}
+
+
+// Filters 6- or 8-channel sound with all channels of a sample frame in one AVX
+// register. 6-channel frames are loaded & stored with masked moves, so that the
+// neighbour frames don't get touched.
+template <int CHANNELS>
+ST_TARGET_AVX2
+static void evaluateMultiAVX2(float *dest, const float *source, const float *coeffs, uint length, int count)
+{
+    int j;
+
+    #pragma omp parallel for
+    for (j = 0; j < count; j ++)
+    {
+        const __m256i vMask = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 
+                                                (CHANNELS > 6) ? -1 : 0, (CHANNELS > 6) ? -1 : 0);
+        const float *ptr = source + j * CHANNELS;
+        __m256 sum0, sum1, sum2, sum3;
+        uint i;
+
+        // four accumulators for consecutive taps hide the FMA latency
+        sum0 = sum1 = sum2 = sum3 = _mm256_setzero_ps();
+        for (i = 0; i < length; i += 4)
+        {
+            if (CHANNELS == 8)
+            {
+                sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(ptr), _mm256_broadcast_ss(coeffs + 2 * i), sum0);
+                sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(ptr + 8), _mm256_broadcast_ss(coeffs + 2 * i + 2), sum1);
+                sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(ptr + 16), _mm256_broadcast_ss(coeffs + 2 * i + 4), sum2);
+                sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(ptr + 24), _mm256_broadcast_ss(coeffs + 2 * i + 6), sum3);
+            }
+            else
+            {
+                sum0 = _mm256_fmadd_ps(_mm256_maskload_ps(ptr, vMask), _mm256_broadcast_ss(coeffs + 2 * i), sum0);
+                sum1 = _mm256_fmadd_ps(_mm256_maskload_ps(ptr + CHANNELS, vMask), _mm256_broadcast_ss(coeffs + 2 * i + 2), sum1);
+                sum2 = _mm256_fmadd_ps(_mm256_maskload_ps(ptr + 2 * CHANNELS, vMask), _mm256_broadcast_ss(coeffs + 2 * i + 4), sum2);
+                sum3 = _mm256_fmadd_ps(_mm256_maskload_ps(ptr + 3 * CHANNELS, vMask), _mm256_broadcast_ss(coeffs + 2 * i + 6), sum3);
+            }
+            ptr += 4 * CHANNELS;
+        }
+
+        sum0 = _mm256_add_ps(_mm256_add_ps(sum0, sum1), _mm256_add_ps(sum2, sum3));
+        if (CHANNELS == 8)
+        {
+            _mm256_storeu_ps(dest + j * CHANNELS, sum0);
+        }
+        else
+        {
+            _mm256_maskstore_ps(dest + j * CHANNELS, vMask, sum0);
+        }
+    }
+}
+
+
+// AVX2-optimized version of the filter routine for 6- and 8-channel sound. Other 
+// channel counts use the SSE routine.
+uint FIRFilterAVX2::evaluateFilterMulti(float *dest, const float *source, uint numSamples, uint numChannels)
+{
+    int count = (int)(numSamples - length);
+
+    if ((numChannels != 6) && (numChannels != 8))
+    {
+        return FIRFilterSSE::evaluateFilterMulti(dest, source, numSamples, numChannels);
+    }
+
+    if (count < 1) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(filterCoeffsAlign != NULL);
+
+    if (numChannels == 8)
+    {
+        evaluateMultiAVX2<8>(dest, source, filterCoeffsAlign, length, count);
+    }
+    else
+    {
+        evaluateMultiAVX2<6>(dest, source, filterCoeffsAlign, length, count);
+    }
+
+    return (uint)count;
+}
+
+
+// Filter routine for mono sound with symmetric coefficients. Folding the mirrored
+// sample pairs doesn't pay off with AVX2: the extra loads & adds cost more than the
+// halved FMAs, so use the generic register-blocked routine also for these.
+uint FIRFilterAVX2::evaluateSymmetricMono(float *dest, const float *source, uint numSamples) const
+{
+    return evaluateFilterMono(dest, source, numSamples);
+}
+
+
+// Filter routine for stereo sound with symmetric coefficients, see above
+uint FIRFilterAVX2::evaluateSymmetricStereo(float *dest, const float *source, uint numSamples) const
+{
+    return evaluateFilterStereo(dest, source, numSamples);
+}
+
+#endif // SOUNDTOUCH_ALLOW_AVX2
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// AVX-512 optimized routines for Intel Skylake-SP, AMD Zen4 and later CPUs.
+/// All AVX-512 optimized functions have been gathered into this single source
+/// code file, regardless to their class or original source code file, in
+/// order to ease porting the library to other compiler and processor
+/// platforms.
+///
+/// The routines use the AVX-512 Foundation instructions only. With GCC, the
+/// code generation gets enabled per function with the 'target' attribute,
+/// in the same way as in 'avx2_optimized.cpp'.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "cpu_detect.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+#ifdef SOUNDTOUCH_ALLOW_AVX512
+
+// AVX-512 routines available only with float sample type
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of AVX-512 optimized functions of class 'TDStretchAVX512'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "TDStretch.h"
+#include <immintrin.h>
+
+#if defined(__GNUC__)
+    // enable AVX-512 instructions for the functions of this file only
+    #define ST_TARGET_AVX512  __attribute__((target("avx512f")))
+#else
+    #define ST_TARGET_AVX512
+#endif
+
+
+// Returns load mask for the 'count' first items of a vector, count < 16
+#define TAIL_MASK(count)    ((__mmask16)((1 << (count)) - 1))
+
+
+// Returns sum of the 16 float items in 'v'
+ST_TARGET_AVX512
+static inline float horizontalSum(__m512 v)
+{
+    __m128 vSum;
+
+    // fold the 512-bit vector to 128 bits, then sum the remaining 4 items. 
+    // Use the masked intrinsic forms with full mask because the unmasked ones
+    // trigger false 'uninitialized' warnings with some GCC versions.
+    v = _mm512_add_ps(v, _mm512_mask_shuffle_f32x4(v, 0xffff, v, v, 0x4e));
+    v = _mm512_add_ps(v, _mm512_mask_shuffle_f32x4(v, 0xffff, v, v, 0xb1));
+    vSum = _mm512_mask_extractf32x4_ps(_mm_setzero_ps(), 0x0f, v, 0);
+    vSum = _mm_add_ps(vSum, _mm_movehl_ps(vSum, vSum));
+    vSum = _mm_add_ss(vSum, _mm_shuffle_ps(vSum, vSum, 1));
+    return _mm_cvtss_f32(vSum);
+}
+
+
+// Calculates cross correlation of two buffers
+ST_TARGET_AVX512
+double TDStretchAVX512::calcCrossCorr(const float *pV1, const float *pV2)
+{
+    int i;
+    int count;
+    __m512 vSum0, vSum1;
+
+    count = channels * overlapLength;
+    vSum0 = vSum1 = _mm512_setzero_ps();
+
+    // Unroll the loop by factor of 2 * 16 items, using two separate
+    // accumulators to hide the FMA instruction latency
+    for (i = 0; i <= count - 32; i += 32)
+    {
+        vSum0 = _mm512_fmadd_ps(_mm512_loadu_ps(pV1 + i), _mm512_loadu_ps(pV2 + i), vSum0);
+        vSum1 = _mm512_fmadd_ps(_mm512_loadu_ps(pV1 + i + 16), _mm512_loadu_ps(pV2 + i + 16), vSum1);
+    }
+    for (; i < count; i += 16)
+    {
+        // masked loads zero the items beyond the buffer end
+        __mmask16 mask = (count - i >= 16) ? (__mmask16)0xffff : TAIL_MASK(count - i);
+
+        vSum0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, pV1 + i), _mm512_maskz_loadu_ps(mask, pV2 + i), vSum0);
+    }
+
+    return (double)horizontalSum(_mm512_add_ps(vSum0, vSum1));
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'pInput' using the fade 
+// gain tables
+ST_TARGET_AVX512
+void TDStretchAVX512::overlapMix(float *pOutput, const float *pInput) const
+{
+    int i;
+    int count;
+
+    count = channels * overlapLength;
+
+    for (i = 0; i < count; i += 16)
+    {
+        __mmask16 mask = (count - i >= 16) ? (__mmask16)0xffff : TAIL_MASK(count - i);
+        __m512 vMix = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, pMidBuffer + i), _mm512_maskz_loadu_ps(mask, pFadeOut + i));
+
+        vMix = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, pInput + i), _mm512_maskz_loadu_ps(mask, pFadeIn + i), vMix);
+        _mm512_mask_storeu_ps(pOutput + i, mask, vMix);
+    }
+}
+
+#endif // SOUNDTOUCH_ALLOW_AVX512
@@ -50,6 +50,9 @@
 #define SUPPORT_ALTIVEC     0x0004
 #define SUPPORT_SSE         0x0008
 #define SUPPORT_SSE2        0x0010
+#define SUPPORT_AVX2        0x0020      ///< AVX2 & FMA3, with OS support for AVX state
+#define SUPPORT_AVX512      0x0040      ///< AVX-512F, with OS support for AVX-512 state
+#define SUPPORT_SSE41       0x0080      ///< SSE4.1
 
 /// Checks which instruction set extensions are supported by the CPU.
 ///
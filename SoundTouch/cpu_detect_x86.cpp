@@ -45,10 +45,10 @@
 
 #if defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS)
 
-   #if defined(__GNUC__) && defined(__i386__)
+   #if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
        // gcc
        #include "cpuid.h"
-   #elif defined(_M_IX86)
+   #elif defined(_M_IX86) || defined(_M_X64)
        // windows non-gcc
        #include <intrin.h>
    #endif
@@ -56,6 +56,32 @@
    #define bit_MMX     (1 << 23)
    #define bit_SSE     (1 << 25)
    #define bit_SSE2    (1 << 26)
+
+   // cpuid leaf 1, ecx register
+   #ifndef bit_SSE4_1
+       #define bit_SSE4_1  (1 << 19)
+   #endif
+   #ifndef bit_FMA
+       #define bit_FMA     (1 << 12)
+   #endif
+   #ifndef bit_OSXSAVE
+       #define bit_OSXSAVE (1 << 27)
+   #endif
+   #ifndef bit_AVX
+       #define bit_AVX     (1 << 28)
+   #endif
+
+   // cpuid leaf 7, ebx register
+   #ifndef bit_AVX2
+       #define bit_AVX2    (1 << 5)
+   #endif
+   #ifndef bit_AVX512F
+       #define bit_AVX512F (1 << 16)
+   #endif
+
+   // XCR0 register: OS saves SSE & AVX (ymm) state, and AVX-512 (opmask, zmm) state
+   #define XCR0_AVX_STATE      0x06
+   #define XCR0_AVX512_STATE   0xe6
 #endif
 
 
@@ -76,16 +102,84 @@ void disableExtensions(uint dwDisableMask)
 
 
 
+#if defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS) && \
+    ((defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))) || defined(_M_IX86) || defined(_M_X64))
+
+/// Checks whether the CPU supports SSE4.1, AVX2/FMA and AVX-512 extensions, and 
+/// for the AVX extensions also whether the operating system saves the extended 
+/// register state in context switches.
+///
+/// \return A bitmask of SUPPORT_SSE41 / SUPPORT_AVX2 / SUPPORT_AVX512 values.
+static uint detectNewerExtensions(void)
+{
+    uint res = 0;
+    uint ecx1, ebx7, xcr0;
+
+#if defined(__GNUC__)
+    uint eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+    ecx1 = ecx;
+    if (ecx1 & bit_SSE4_1) res |= SUPPORT_SSE41;
+
+    if (__get_cpuid_max(0, NULL) < 7) return res;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    ebx7 = ebx;
+
+    if ((ecx1 & bit_OSXSAVE) == 0) return res;
+    // read XCR0 with 'xgetbv' instruction
+    __asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (0));
+    xcr0 = eax;
+#else
+    int reg[4] = {-1};
+    uint maxLeaf;
+
+    __cpuid(reg, 0);
+    maxLeaf = (uint)reg[0];
+
+    __cpuid(reg, 1);
+    ecx1 = (uint)reg[2];
+    if (ecx1 & bit_SSE4_1) res |= SUPPORT_SSE41;
+
+    if (maxLeaf < 7) return res;
+    __cpuidex(reg, 7, 0);
+    ebx7 = (uint)reg[1];
+
+    if ((ecx1 & bit_OSXSAVE) == 0) return res;
+    // Notice that Visual Studio 2010 SP1 or later required for _xgetbv intrinsic support.
+    xcr0 = (uint)_xgetbv(0);
+#endif
+
+    if (((xcr0 & XCR0_AVX_STATE) == XCR0_AVX_STATE) &&
+        (ecx1 & bit_AVX) && (ecx1 & bit_FMA) && (ebx7 & bit_AVX2))
+    {
+        res |= SUPPORT_AVX2;
+
+        if (((xcr0 & XCR0_AVX512_STATE) == XCR0_AVX512_STATE) && (ebx7 & bit_AVX512F))
+        {
+            res |= SUPPORT_AVX512;
+        }
+    }
+
+    return res;
+}
+
+#endif
+
+
 /// Checks which instruction set extensions are supported by the CPU.
 uint detectCPUextensions(void)
 {
 /// If building for a 64bit system (no Itanium) and the user wants optimizations.
-/// Return the OR of SUPPORT_{MMX,SSE,SSE2}. 11001 or 0x19.
+/// Return the OR of SUPPORT_{MMX,SSE,SSE2}. 11001 or 0x19, plus the SSE4.1 & AVX 
+/// extensions that need to be checked at runtime.
 /// Keep the _dwDisabledISA test (2 more operations, could be eliminated).
 #if ((defined(__GNUC__) && defined(__x86_64__)) \
     || defined(_M_X64))  \
     && defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS)
-    return 0x19 & ~_dwDisabledISA;
+    if (_dwDisabledISA == 0xffffffff) return 0;
+
+    return (0x19 | detectNewerExtensions()) & ~_dwDisabledISA;
 
 /// If building for a 32bit system and the user wants optimizations.
 /// Keep the _dwDisabledISA test (2 more operations, could be eliminated).
@@ -108,6 +202,8 @@ uint detectCPUextensions(void)
     if (edx & bit_SSE)  res = res | SUPPORT_SSE;
     if (edx & bit_SSE2) res = res | SUPPORT_SSE2;
 
+    res |= detectNewerExtensions();
+
 #else
     // Window / VS version of cpuid. Notice that Visual Studio 2005 or later required 
     // for __cpuid intrinsic support.
@@ -122,6 +218,8 @@ uint detectCPUextensions(void)
     if ((unsigned int)reg[3] & bit_SSE)  res = res | SUPPORT_SSE;
     if ((unsigned int)reg[3] & bit_SSE2) res = res | SUPPORT_SSE2;
 
+    res |= detectNewerExtensions();
+
 #endif
 
     return res & ~_dwDisabledISA;
@@ -68,92 +68,14 @@ using namespace soundtouch;
 
 
 // Calculates cross correlation of two buffers
-double TDStretchMMX::calcCrossCorr(const short *pV1, const short *pV2, double &dnorm)
-{
-    const __m64 *pVec1, *pVec2;
-    __m64 shifter;
-    __m64 accu, normaccu;
-    long corr, norm;
-    int i;
-   
-    pVec1 = (__m64*)pV1;
-    pVec2 = (__m64*)pV2;
-
-    shifter = _m_from_int(overlapDividerBitsNorm);
-    normaccu = accu = _mm_setzero_si64();
-
-    // Process 4 parallel sets of 2 * stereo samples or 4 * mono samples 
-    // during each round for improved CPU-level parallellization.
-    for (i = 0; i < channels * overlapLength / 16; i ++)
-    {
-        __m64 temp, temp2;
-
-        // dictionary of instructions:
-        // _m_pmaddwd   : 4*16bit multiply-add, resulting two 32bits = [a0*b0+a1*b1 ; a2*b2+a3*b3]
-        // _mm_add_pi32 : 2*32bit add
-        // _m_psrad     : 32bit right-shift
-
-        temp = _mm_add_pi32(_mm_sra_pi32(_mm_madd_pi16(pVec1[0], pVec2[0]), shifter),
-                            _mm_sra_pi32(_mm_madd_pi16(pVec1[1], pVec2[1]), shifter));
-        temp2 = _mm_add_pi32(_mm_sra_pi32(_mm_madd_pi16(pVec1[0], pVec1[0]), shifter),
-                            _mm_sra_pi32(_mm_madd_pi16(pVec1[1], pVec1[1]), shifter));
-        accu = _mm_add_pi32(accu, temp);
-        normaccu = _mm_add_pi32(normaccu, temp2);
-
-        temp = _mm_add_pi32(_mm_sra_pi32(_mm_madd_pi16(pVec1[2], pVec2[2]), shifter),
-                            _mm_sra_pi32(_mm_madd_pi16(pVec1[3], pVec2[3]), shifter));
-        temp2 = _mm_add_pi32(_mm_sra_pi32(_mm_madd_pi16(pVec1[2], pVec1[2]), shifter),
-                            _mm_sra_pi32(_mm_madd_pi16(pVec1[3], pVec1[3]), shifter));
-        accu = _mm_add_pi32(accu, temp);
-        normaccu = _mm_add_pi32(normaccu, temp2);
-
-        pVec1 += 4;
-        pVec2 += 4;
-    }
-
-    // copy hi-dword of mm0 to lo-dword of mm1, then sum mmo+mm1
-    // and finally store the result into the variable "corr"
-
-    accu = _mm_add_pi32(accu, _mm_srli_si64(accu, 32));
-    corr = _m_to_int(accu);
-
-    normaccu = _mm_add_pi32(normaccu, _mm_srli_si64(normaccu, 32));
-    norm = _m_to_int(normaccu);
-
-    // Clear MMS state
-    _m_empty();
-
-    if (norm > (long)maxnorm)
-    {
-        maxnorm = norm;
-    }
-
-    // Normalize result by dividing by sqrt(norm) - this step is easiest 
-    // done using floating point operation
-    dnorm = (double)norm;
-
-    return (double)corr / sqrt(dnorm < 1e-9 ? 1.0 : dnorm);
-    // Note: Warning about the missing EMMS instruction is harmless
-    // as it'll be called elsewhere.
-}
-
-
-/// Update cross-correlation by accumulating "norm" coefficient by previously calculated value
-double TDStretchMMX::calcCrossCorrAccumulate(const short *pV1, const short *pV2, double &dnorm)
+double TDStretchMMX::calcCrossCorr(const short *pV1, const short *pV2)
 {
     const __m64 *pVec1, *pVec2;
     __m64 shifter;
     __m64 accu;
-    long corr, lnorm;
+    long corr;
     int i;
    
-    // cancel first normalizer tap from previous round
-    lnorm = 0;
-    for (i = 1; i <= channels; i ++)
-    {
-        lnorm -= (pV1[-i] * pV1[-i]) >> overlapDividerBitsNorm;
-    }
-
     pVec1 = (__m64*)pV1;
     pVec2 = (__m64*)pV2;
 
@@ -192,22 +114,10 @@ double TDStretchMMX::calcCrossCorrAccumulate(const short *pV1, const short *pV2,
     // Clear MMS state
     _m_empty();
 
-    // update normalizer with last samples of this round
-    pV1 = (short *)pVec1;
-    for (int j = 1; j <= channels; j ++)
-    {
-        lnorm += (pV1[-j] * pV1[-j]) >> overlapDividerBitsNorm;
-    }
-    dnorm += (double)lnorm;
-
-    if (lnorm > (long)maxnorm)
-    {
-        maxnorm = lnorm;
-    }
-
-    // Normalize result by dividing by sqrt(norm) - this step is easiest 
-    // done using floating point operation
-    return (double)corr / sqrt((dnorm < 1e-9) ? 1.0 : dnorm);
+    // undo the intermediate division
+    return (double)corr * (double)(1 << overlapDividerBitsNorm);
+    // Note: Warning about the missing EMMS instruction is harmless
+    // as it'll be called elsewhere.
 }
 
 
@@ -220,66 +130,55 @@ void TDStretchMMX::clearCrossCorrState()
 
 
 
-// MMX-optimized version of the function overlapStereo
-void TDStretchMMX::overlapStereo(short *output, const short *input) const
+// MMX-optimized version of the function overlapMix
+void TDStretchMMX::overlapMix(short *output, const short *input) const
 {
-    const __m64 *pVinput, *pVMidBuf;
+    const __m64 *pVinput, *pVMidBuf, *pVFadeIn, *pVFadeOut;
     __m64 *pVdest;
-    __m64 mix1, mix2, adder, shifter;
+    __m64 shifter;
     int i;
 
-    pVinput  = (const __m64*)input;
-    pVMidBuf = (const __m64*)pMidBuffer;
-    pVdest   = (__m64*)output;
-
-    // mix1  = mixer values for 1st stereo sample
-    // mix1  = mixer values for 2nd stereo sample
-    // adder = adder for updating mixer values after each round
-    
-    mix1  = _mm_set_pi16(0, overlapLength,   0, overlapLength);
-    adder = _mm_set_pi16(1, -1, 1, -1);
-    mix2  = _mm_add_pi16(mix1, adder);
-    adder = _mm_add_pi16(adder, adder);
+    pVinput   = (const __m64*)input;
+    pVMidBuf  = (const __m64*)pMidBuffer;
+    pVFadeIn  = (const __m64*)pFadeIn;
+    pVFadeOut = (const __m64*)pFadeOut;
+    pVdest    = (__m64*)output;
 
-    // Overlaplength-division by shifter. "+1" is to account for "-1" deduced in
-    // overlapDividerBits calculation earlier.
-    shifter = _m_from_int(overlapDividerBitsPure + 1);
+    shifter = _m_from_int(CROSSFADE_BITS);
 
-    for (i = 0; i < overlapLength / 4; i ++)
+    // overlap length is divisible by 8, so process 8 samples per round
+    for (i = 0; i < channels * overlapLength / 8; i ++)
     {
-        __m64 temp1, temp2;
-                
-        // load & shuffle data so that input & mixbuffer data samples are paired
-        temp1 = _mm_unpacklo_pi16(pVMidBuf[0], pVinput[0]);     // = i0l m0l i0r m0r
-        temp2 = _mm_unpackhi_pi16(pVMidBuf[0], pVinput[0]);     // = i1l m1l i1r m1r
+        __m64 temp1, temp2, mix1, mix2;
+
+        // load & shuffle data so that input & mixbuffer data samples are paired,
+        // and the fade gains similarly
+        temp1 = _mm_unpacklo_pi16(pVMidBuf[0], pVinput[0]);     // = i0 m0 i1 m1
+        temp2 = _mm_unpackhi_pi16(pVMidBuf[0], pVinput[0]);     // = i2 m2 i3 m3
+        mix1  = _mm_unpacklo_pi16(pVFadeOut[0], pVFadeIn[0]);
+        mix2  = _mm_unpackhi_pi16(pVFadeOut[0], pVFadeIn[0]);
 
         // temp = (temp .* mix) >> shifter
         temp1 = _mm_sra_pi32(_mm_madd_pi16(temp1, mix1), shifter);
         temp2 = _mm_sra_pi32(_mm_madd_pi16(temp2, mix2), shifter);
-        pVdest[0] = _mm_packs_pi32(temp1, temp2); // pack 2*2*32bit => 4*16bit
-
-        // update mix += adder
-        mix1 = _mm_add_pi16(mix1, adder);
-        mix2 = _mm_add_pi16(mix2, adder);
+        pVdest[0] = _mm_packs_pi32(temp1, temp2); // pack 2*2*32bit => 4*16bit, saturated
 
         // --- second round begins here ---
 
-        // load & shuffle data so that input & mixbuffer data samples are paired
-        temp1 = _mm_unpacklo_pi16(pVMidBuf[1], pVinput[1]);       // = i2l m2l i2r m2r
-        temp2 = _mm_unpackhi_pi16(pVMidBuf[1], pVinput[1]);       // = i3l m3l i3r m3r
+        temp1 = _mm_unpacklo_pi16(pVMidBuf[1], pVinput[1]);     // = i4 m4 i5 m5
+        temp2 = _mm_unpackhi_pi16(pVMidBuf[1], pVinput[1]);     // = i6 m6 i7 m7
+        mix1  = _mm_unpacklo_pi16(pVFadeOut[1], pVFadeIn[1]);
+        mix2  = _mm_unpackhi_pi16(pVFadeOut[1], pVFadeIn[1]);
 
-        // temp = (temp .* mix) >> shifter
         temp1 = _mm_sra_pi32(_mm_madd_pi16(temp1, mix1), shifter);
         temp2 = _mm_sra_pi32(_mm_madd_pi16(temp2, mix2), shifter);
-        pVdest[1] = _mm_packs_pi32(temp1, temp2); // pack 2*2*32bit => 4*16bit
+        pVdest[1] = _mm_packs_pi32(temp1, temp2);
 
-        // update mix += adder
-        mix1 = _mm_add_pi16(mix1, adder);
-        mix2 = _mm_add_pi16(mix2, adder);
-
-        pVinput  += 2;
-        pVMidBuf += 2;
-        pVdest   += 2;
+        pVinput   += 2;
+        pVMidBuf  += 2;
+        pVFadeIn  += 2;
+        pVFadeOut += 2;
+        pVdest    += 2;
     }
 
     _m_empty(); // clear MMS state
@@ -312,12 +211,19 @@ FIRFilterMMX::~FIRFilterMMX()
 void FIRFilterMMX::setCoefficients(const short *coeffs, uint newLength, uint uResultDivFactor)
 {
     uint i;
+    uint oldLength = length;
     FIRFilter::setCoefficients(coeffs, newLength, uResultDivFactor);
+    // 'pmaddwd' multiplies 16bit samples, so the mirrored sample pairs can't be 
+    // added together before multiplying. The direct form is faster here.
+    bSymmetric = false;
 
     // Ensure that filter coeffs array is aligned to 16-byte boundary
-    delete[] filterCoeffsUnalign;
-    filterCoeffsUnalign = new short[2 * newLength + 8];
-    filterCoeffsAlign = (short *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+    if ((filterCoeffsUnalign == NULL) || (newLength != oldLength))
+    {
+        delete[] filterCoeffsUnalign;
+        filterCoeffsUnalign = new short[2 * newLength + 8];
+        filterCoeffsAlign = (short *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+    }
 
     // rearrange the filter coefficients for mmx routines 
     for (i = 0;i < length; i += 4) 
@@ -392,4 +298,105 @@ uint FIRFilterMMX::evaluateFilterStereo(short *dest, const short *src, uint numS
     return (numSamples & 0xfffffffe) - length;
 }
 
+
+// mmx-optimized filter routine for 'CHANNELS' = 4, 6 or 8 channels. Each round
+// pairs the samples of the taps 0 & 2 and the taps 1 & 3 of each channel with 
+// 'punpcklwd' / 'punpckhwd', so that one 'pmaddwd' with the coefficients that 
+// 'setCoefficients' has rearranged for the stereo routine sums two taps of two 
+// channels. The coefficient pairs are loaded once per round for all the channels.
+template <int CHANNELS>
+static uint evaluateMultiMMX(short *dest, const short *src, uint numSamples, 
+                             const short *filterCoeffsAlign, uint length, uint resultDivFactor)
+{
+    const int end = (int)(numSamples - length);
+    int j;
+
+    for (j = 0; j < end; j ++)
+    {
+        __m64 accu[CHANNELS / 2];
+        const short *ptr = src + j * CHANNELS;
+        const __m64 *pVfilter = (const __m64*)filterCoeffsAlign;
+        short *pDest = dest + j * CHANNELS;
+        uint i;
+        int c;
+
+        for (c = 0; c < CHANNELS / 2; c ++)
+        {
+            accu[c] = _mm_setzero_si64();
+        }
+
+        for (i = 0; i < length; i += 4)
+        {
+            // channels in groups of four
+            for (c = 0; c + 4 <= CHANNELS; c += 4)
+            {
+                __m64 s0 = *(const __m64*)(ptr + c);
+                __m64 s1 = *(const __m64*)(ptr + CHANNELS + c);
+                __m64 s2 = *(const __m64*)(ptr + 2 * CHANNELS + c);
+                __m64 s3 = *(const __m64*)(ptr + 3 * CHANNELS + c);
+
+                // += a2*f2+a0*f0 b2*f2+b0*f0, += a3*f3+a1*f1 b3*f3+b1*f1
+                accu[c / 2] = _mm_add_pi32(accu[c / 2], _mm_madd_pi16(_mm_unpacklo_pi16(s0, s2), pVfilter[0]));
+                accu[c / 2] = _mm_add_pi32(accu[c / 2], _mm_madd_pi16(_mm_unpacklo_pi16(s1, s3), pVfilter[1]));
+                // same for the channels c & d
+                accu[c / 2 + 1] = _mm_add_pi32(accu[c / 2 + 1], _mm_madd_pi16(_mm_unpackhi_pi16(s0, s2), pVfilter[0]));
+                accu[c / 2 + 1] = _mm_add_pi32(accu[c / 2 + 1], _mm_madd_pi16(_mm_unpackhi_pi16(s1, s3), pVfilter[1]));
+            }
+            if (CHANNELS % 4)
+            {
+                // remaining channel pair, load only the 2 * 16 bits of the pair
+                __m64 s0 = _mm_cvtsi32_si64(*(const int*)(ptr + c));
+                __m64 s1 = _mm_cvtsi32_si64(*(const int*)(ptr + CHANNELS + c));
+                __m64 s2 = _mm_cvtsi32_si64(*(const int*)(ptr + 2 * CHANNELS + c));
+                __m64 s3 = _mm_cvtsi32_si64(*(const int*)(ptr + 3 * CHANNELS + c));
+
+                accu[c / 2] = _mm_add_pi32(accu[c / 2], _mm_madd_pi16(_mm_unpacklo_pi16(s0, s2), pVfilter[0]));
+                accu[c / 2] = _mm_add_pi32(accu[c / 2], _mm_madd_pi16(_mm_unpacklo_pi16(s1, s3), pVfilter[1]));
+            }
+
+            pVfilter += 2;
+            ptr += 4 * CHANNELS;
+        }
+
+        // accu >>= resultDivFactor, pack 2*2*32bits => 4*16 bits with saturation
+        for (c = 0; c + 4 <= CHANNELS; c += 4)
+        {
+            *(__m64*)(pDest + c) = _mm_packs_pi32(_mm_srai_pi32(accu[c / 2], resultDivFactor),
+                                                  _mm_srai_pi32(accu[c / 2 + 1], resultDivFactor));
+        }
+        if (CHANNELS % 4)
+        {
+            __m64 temp = _mm_srai_pi32(accu[c / 2], resultDivFactor);
+
+            *(int*)(pDest + c) = _mm_cvtsi64_si32(_mm_packs_pi32(temp, temp));
+        }
+    }
+
+    _m_empty();  // clear emms state
+
+    return (uint)end;
+}
+
+
+// mmx-optimized version of the filter routine for multichannel sound. The 4.0,
+// 5.1 & 7.1 channel layouts have mmx routines, other channel counts use the 
+// C version.
+uint FIRFilterMMX::evaluateFilterMulti(short *dest, const short *src, uint numSamples, uint numChannels)
+{
+    switch (numChannels)
+    {
+        case 4:
+            return evaluateMultiMMX<4>(dest, src, numSamples, filterCoeffsAlign, length, resultDivFactor);
+
+        case 6:
+            return evaluateMultiMMX<6>(dest, src, numSamples, filterCoeffsAlign, length, resultDivFactor);
+
+        case 8:
+            return evaluateMultiMMX<8>(dest, src, numSamples, filterCoeffsAlign, length, resultDivFactor);
+
+        default:
+            return FIRFilter::evaluateFilterMulti(dest, src, numSamples, numChannels);
+    }
+}
+
 #endif  // SOUNDTOUCH_ALLOW_MMX
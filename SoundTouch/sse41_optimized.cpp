@@ -0,0 +1,275 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// SSE4.1 optimized routines for 16bit integer samples, for Intel Penryn,
+/// AMD Bulldozer and later CPUs. All SSE4.1 optimized functions have been
+/// gathered into this single source code file, regardless to their class or
+/// original source code file, in order to ease porting the library to other
+/// compiler and processor platforms.
+///
+/// The cross-correlation routines accumulate the 'pmaddwd' products into 64bit
+/// integers, so unlike the MMX routines they don't need to divide the products
+/// by the adaptive normalizer to avoid overflows, and the result is exact.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "cpu_detect.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+#if defined(SOUNDTOUCH_ALLOW_SSE41) && defined(SOUNDTOUCH_ALLOW_MMX)
+
+// SSE4.1 routines available only with integer sample type
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE4.1 optimized functions of class 'TDStretchSSE41'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "TDStretch.h"
+#include <smmintrin.h>
+
+#if defined(__GNUC__)
+    // enable SSE4.1 instructions for the functions of this file only
+    #define ST_TARGET_SSE41  __attribute__((target("sse4.1")))
+#else
+    #define ST_TARGET_SSE41
+#endif
+
+// Accumulates 64bit sums of products of 8 sample pairs into 'accu'. 'pmaddwd'
+// gives 32bit sums of two products, which are then sign-extended to 64 bits.
+ST_TARGET_SSE41
+static inline __m128i madd64(__m128i accu, __m128i v1, __m128i v2)
+{
+    __m128i prod = _mm_madd_epi16(v1, v2);
+
+    accu = _mm_add_epi64(accu, _mm_cvtepi32_epi64(prod));
+    return _mm_add_epi64(accu, _mm_cvtepi32_epi64(_mm_srli_si128(prod, 8)));
+}
+
+
+// Returns sum of the two 64bit items in 'v'
+ST_TARGET_SSE41
+static inline long long horizontalSum(__m128i v)
+{
+    long long temp[2];
+
+    _mm_storeu_si128((__m128i*)temp, v);
+    return temp[0] + temp[1];
+}
+
+
+// Calculates cross correlation of two buffers
+ST_TARGET_SSE41
+double TDStretchSSE41::calcCrossCorr(const short *pV1, const short *pV2)
+{
+    __m128i accu0, accu1;
+    long long corr;
+    int i;
+    int count;
+
+    count = channels * overlapLength;
+    accu0 = accu1 = _mm_setzero_si128();
+
+    // Process 2 * 8 samples during each round for improved CPU-level parallellization
+    for (i = 0; i <= count - 16; i += 16)
+    {
+        accu0 = madd64(accu0, _mm_loadu_si128((const __m128i*)(pV1 + i)), _mm_loadu_si128((const __m128i*)(pV2 + i)));
+        accu1 = madd64(accu1, _mm_loadu_si128((const __m128i*)(pV1 + i + 8)), _mm_loadu_si128((const __m128i*)(pV2 + i + 8)));
+    }
+
+    corr = horizontalSum(_mm_add_epi64(accu0, accu1));
+
+    // remaining samples, if any
+    for (; i < count; i ++)
+    {
+        corr += pV1[i] * pV2[i];
+    }
+
+    // the sum is an integer well below 2^53, so it's exact also in 'double'
+    return (double)corr;
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'input' using the 
+// fixed-point fade gains. Same as the MMX routine, but 8 samples at a time.
+ST_TARGET_SSE41
+void TDStretchSSE41::overlapMix(short *output, const short *input) const
+{
+    const __m128i shifter = _mm_cvtsi32_si128(CROSSFADE_BITS);
+    int i;
+
+    // overlap length is divisible by 8; 'pMidBuffer' & fade tables are aligned
+    for (i = 0; i < channels * overlapLength; i += 8)
+    {
+        __m128i vMid = _mm_load_si128((const __m128i*)(pMidBuffer + i));
+        __m128i vInput = _mm_loadu_si128((const __m128i*)(input + i));
+        __m128i vFadeIn = _mm_load_si128((const __m128i*)(pFadeIn + i));
+        __m128i vFadeOut = _mm_load_si128((const __m128i*)(pFadeOut + i));
+        __m128i temp1, temp2;
+
+        // pair the mid & input samples with their fade gains
+        temp1 = _mm_madd_epi16(_mm_unpacklo_epi16(vMid, vInput), _mm_unpacklo_epi16(vFadeOut, vFadeIn));
+        temp2 = _mm_madd_epi16(_mm_unpackhi_epi16(vMid, vInput), _mm_unpackhi_epi16(vFadeOut, vFadeIn));
+
+        temp1 = _mm_sra_epi32(temp1, shifter);
+        temp2 = _mm_sra_epi32(temp2, shifter);
+        _mm_storeu_si128((__m128i*)(output + i), _mm_packs_epi32(temp1, temp2));
+    }
+}
+
+
+// 64bit accumulators don't need the adaptive normalizer
+void TDStretchSSE41::adaptNormalizer()
+{
+    maxnorm = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE4.1 optimized functions of class 'FloatTransposerAdapter'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "FloatTransposer.h"
+
+FloatTransposerAdapterSSE41::FloatTransposerAdapterSSE41(FloatTransposer *transposer) 
+    : FloatTransposerAdapter(transposer)
+{
+}
+
+
+// Converts integer samples to floating point, 8 samples at a time
+ST_TARGET_SSE41
+void FloatTransposerAdapterSSE41::toFloat(float *dest, const short *src, int count) const
+{
+    int i;
+
+    for (i = 0; i <= count - 8; i += 8)
+    {
+        __m128i vSrc = _mm_loadu_si128((const __m128i*)(src + i));
+
+        _mm_storeu_ps(dest + i, _mm_cvtepi32_ps(_mm_cvtepi16_epi32(vSrc)));
+        _mm_storeu_ps(dest + i + 4, _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(vSrc, 8))));
+    }
+
+    // remaining samples, if any
+    FloatTransposerAdapter::toFloat(dest + i, src + i, count - i);
+}
+
+
+// Converts floating point samples to integers, 8 samples at a time. The values
+// are clipped to 16 bit range before the conversion, because out-of-range floats 
+// wouldn't saturate in the 32bit conversion. Rounds the halfway cases to even,
+// while the plain C routine rounds them away from zero.
+ST_TARGET_SSE41
+void FloatTransposerAdapterSSE41::toShort(short *dest, const float *src, int count) const
+{
+    const __m128 vMax = _mm_set1_ps(32767.0f);
+    const __m128 vMin = _mm_set1_ps(-32768.0f);
+    int i;
+
+    for (i = 0; i <= count - 8; i += 8)
+    {
+        __m128 v1 = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), vMin), vMax);
+        __m128 v2 = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), vMin), vMax);
+
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(_mm_cvtps_epi32(v1), _mm_cvtps_epi32(v2)));
+    }
+
+    // remaining samples, if any
+    FloatTransposerAdapter::toShort(dest + i, src + i, count - i);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE4.1 optimized functions of class 'InterpolateRational'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "InterpolateRational.h"
+
+// Filter routine for mono sound, 8 taps at a time with 'pmaddwd'. Filter length
+// is divisible by 4. The 32bit sums don't overflow, because the sum of the 
+// absolute coefficient values is well below 2^16. Gives the same result as the 
+// plain C routine.
+ST_TARGET_SSE41
+void InterpolateRationalSSE41::filterMono(short *dest, const short *src, const short *phase) const
+{
+    __m128i sum = _mm_setzero_si128();
+    int k;
+
+    for (k = 0; k <= taps - 8; k += 8)
+    {
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(src + k)), 
+                                                _mm_loadu_si128((const __m128i*)(phase + k))));
+    }
+    if (k < taps)
+    {
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadl_epi64((const __m128i*)(src + k)), 
+                                                _mm_loadl_epi64((const __m128i*)(phase + k))));
+    }
+
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+    sum = _mm_srai_epi32(sum, RATIONAL_DIV_FACTOR);
+    dest[0] = (short)_mm_extract_epi16(_mm_packs_epi32(sum, sum), 0);
+}
+
+
+// Filter routine for stereo sound, 4 taps at a time. The samples get reordered
+// so that 'pmaddwd' sums the products of two successive samples of the same
+// channel.
+ST_TARGET_SSE41
+void InterpolateRationalSSE41::filterStereo(short *dest, const short *src, const short *phase) const
+{
+    __m128i sum = _mm_setzero_si128();
+
+    for (int k = 0; k < taps; k += 4)
+    {
+        __m128i vSrc = _mm_loadu_si128((const __m128i*)(src + 2 * k));
+        __m128i vCoeffs = _mm_loadl_epi64((const __m128i*)(phase + k));
+
+        // l0 r0 l1 r1 l2 r2 l3 r3 => l0 l1 r0 r1 l2 l3 r2 r3
+        vSrc = _mm_shufflelo_epi16(vSrc, _MM_SHUFFLE(3,1,2,0));
+        vSrc = _mm_shufflehi_epi16(vSrc, _MM_SHUFFLE(3,1,2,0));
+
+        // c0 c1 c2 c3 => c0 c1 c0 c1 c2 c3 c2 c3
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(vSrc, _mm_unpacklo_epi32(vCoeffs, vCoeffs)));
+    }
+
+    // left & right channel sums in the two lowest items
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_srai_epi32(sum, RATIONAL_DIV_FACTOR);
+    sum = _mm_packs_epi32(sum, sum);
+    dest[0] = (short)_mm_extract_epi16(sum, 0);
+    dest[1] = (short)_mm_extract_epi16(sum, 1);
+}
+
+#endif // SOUNDTOUCH_ALLOW_SSE41
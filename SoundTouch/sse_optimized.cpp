@@ -71,12 +71,12 @@ using namespace soundtouch;
 #include <math.h>
 
 // Calculates cross correlation of two buffers
-double TDStretchSSE::calcCrossCorr(const float *pV1, const float *pV2, double &anorm)
+double TDStretchSSE::calcCrossCorr(const float *pV1, const float *pV2)
 {
     int i;
     const float *pVec1;
     const __m128 *pVec2;
-    __m128 vSum, vNorm;
+    __m128 vSum;
 
     // Note. It means a major slow-down if the routine needs to tolerate 
     // unaligned __m128 memory accesses. It's way faster if we can skip 
@@ -108,51 +108,45 @@ double TDStretchSSE::calcCrossCorr(const float *pV1, const float *pV2, double &a
     // Note: pV2 _must_ be aligned to 16-bit boundary, pV1 need not.
     pVec1 = (const float*)pV1;
     pVec2 = (const __m128*)pV2;
-    vSum = vNorm = _mm_setzero_ps();
+    vSum = _mm_setzero_ps();
 
     // Unroll the loop by factor of 4 * 4 operations. Use same routine for
     // stereo & mono, for mono it just means twice the amount of unrolling.
     for (i = 0; i < channels * overlapLength / 16; i ++) 
     {
-        __m128 vTemp;
         // vSum += pV1[0..3] * pV2[0..3]
-        vTemp = _MM_LOAD(pVec1);
-        vSum  = _mm_add_ps(vSum,  _mm_mul_ps(vTemp ,pVec2[0]));
-        vNorm = _mm_add_ps(vNorm, _mm_mul_ps(vTemp ,vTemp));
+        vSum = _mm_add_ps(vSum, _mm_mul_ps(_MM_LOAD(pVec1), pVec2[0]));
 
         // vSum += pV1[4..7] * pV2[4..7]
-        vTemp = _MM_LOAD(pVec1 + 4);
-        vSum  = _mm_add_ps(vSum, _mm_mul_ps(vTemp, pVec2[1]));
-        vNorm = _mm_add_ps(vNorm, _mm_mul_ps(vTemp ,vTemp));
+        vSum = _mm_add_ps(vSum, _mm_mul_ps(_MM_LOAD(pVec1 + 4), pVec2[1]));
 
         // vSum += pV1[8..11] * pV2[8..11]
-        vTemp = _MM_LOAD(pVec1 + 8);
-        vSum  = _mm_add_ps(vSum, _mm_mul_ps(vTemp, pVec2[2]));
-        vNorm = _mm_add_ps(vNorm, _mm_mul_ps(vTemp ,vTemp));
+        vSum = _mm_add_ps(vSum, _mm_mul_ps(_MM_LOAD(pVec1 + 8), pVec2[2]));
 
         // vSum += pV1[12..15] * pV2[12..15]
-        vTemp = _MM_LOAD(pVec1 + 12);
-        vSum  = _mm_add_ps(vSum, _mm_mul_ps(vTemp, pVec2[3]));
-        vNorm = _mm_add_ps(vNorm, _mm_mul_ps(vTemp ,vTemp));
+        vSum = _mm_add_ps(vSum, _mm_mul_ps(_MM_LOAD(pVec1 + 12), pVec2[3]));
 
         pVec1 += 16;
         pVec2 += 4;
     }
 
-    // return value = vSum[0] + vSum[1] + vSum[2] + vSum[3]
-    float *pvNorm = (float*)&vNorm;
-    float norm = (pvNorm[0] + pvNorm[1] + pvNorm[2] + pvNorm[3]);
-    anorm = norm;
+    // overlap length is divisible by 8, so with mono sound 8 items may remain
+    if ((channels * overlapLength) % 16)
+    {
+        vSum = _mm_add_ps(vSum, _mm_mul_ps(_MM_LOAD(pVec1), pVec2[0]));
+        vSum = _mm_add_ps(vSum, _mm_mul_ps(_MM_LOAD(pVec1 + 4), pVec2[1]));
+    }
 
+    // return value = vSum[0] + vSum[1] + vSum[2] + vSum[3]
     float *pvSum = (float*)&vSum;
-    return (double)(pvSum[0] + pvSum[1] + pvSum[2] + pvSum[3]) / sqrt(norm < 1e-9 ? 1.0 : norm);
+    return (double)(pvSum[0] + pvSum[1] + pvSum[2] + pvSum[3]);
 
-    /* This is approximately corresponding routine in C-language yet without normalization:
-    double corr, norm;
+    /* This is approximately corresponding routine in C-language:
+    double corr;
     uint i;
 
     // Calculates the cross-correlation value between 'pV1' and 'pV2' vectors
-    corr = norm = 0.0;
+    corr = 0.0;
     for (i = 0; i < channels * overlapLength / 16; i ++) 
     {
         corr += pV1[0] * pV2[0] +
@@ -172,23 +166,43 @@ double TDStretchSSE::calcCrossCorr(const float *pV1, const float *pV2, double &a
                 pV1[14] * pV2[14] +
                 pV1[15] * pV2[15];
 
-    for (j = 0; j < 15; j ++) norm += pV1[j] * pV1[j];
-
         pV1 += 16;
         pV2 += 16;
     }
-    return corr / sqrt(norm);
+    return corr;
     */
 }
 
 
-
-double TDStretchSSE::calcCrossCorrAccumulate(const float *pV1, const float *pV2, double &norm)
+// SSE-optimized version of the function overlapMix
+void TDStretchSSE::overlapMix(float *pOutput, const float *pInput) const
 {
-    // call usual calcCrossCorr function because SSE does not show big benefit of 
-    // accumulating "norm" value, and also the "norm" rolling algorithm would get 
-    // complicated due to SSE-specific alignment-vs-nonexact correlation rules.
-    return calcCrossCorr(pV1, pV2, norm);
+    int i;
+    const __m128 *pVMidBuf, *pVFadeIn, *pVFadeOut;
+
+    // 'pMidBuffer' & the fade tables are aligned, input & output need not be
+    pVMidBuf  = (const __m128*)pMidBuffer;
+    pVFadeIn  = (const __m128*)pFadeIn;
+    pVFadeOut = (const __m128*)pFadeOut;
+
+    // overlap length is divisible by 8, so process 8 samples per round
+    for (i = 0; i < channels * overlapLength; i += 8)
+    {
+        __m128 vTemp0, vTemp1;
+
+        // vTemp = input .* fadeIn + mid .* fadeOut
+        vTemp0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pInput + i), pVFadeIn[0]),
+                            _mm_mul_ps(pVMidBuf[0], pVFadeOut[0]));
+        vTemp1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pInput + i + 4), pVFadeIn[1]),
+                            _mm_mul_ps(pVMidBuf[1], pVFadeOut[1]));
+
+        _mm_storeu_ps(pOutput + i, vTemp0);
+        _mm_storeu_ps(pOutput + i + 4, vTemp1);
+
+        pVMidBuf  += 2;
+        pVFadeIn  += 2;
+        pVFadeOut += 2;
+    }
 }
 
 
@@ -204,6 +218,8 @@ FIRFilterSSE::FIRFilterSSE() : FIRFilter()
 {
     filterCoeffsAlign = NULL;
     filterCoeffsUnalign = NULL;
+    foldedCoeffs = NULL;
+    foldedFirst = 0;
 }
 
 
@@ -212,23 +228,32 @@ FIRFilterSSE::~FIRFilterSSE()
     delete[] filterCoeffsUnalign;
     filterCoeffsAlign = NULL;
     filterCoeffsUnalign = NULL;
+    foldedCoeffs = NULL;
 }
 
 
 // (overloaded) Calculates filter coefficients for SSE routine
 void FIRFilterSSE::setCoefficients(const float *coeffs, uint newLength, uint uResultDivFactor)
 {
-    uint i;
+    uint i, half, oldLength;
     float fDivider;
 
+    oldLength = length;
     FIRFilter::setCoefficients(coeffs, newLength, uResultDivFactor);
 
     // Scale the filter coefficients so that it won't be necessary to scale the filtering result
     // also rearrange coefficients suitably for SSE
-    // Ensure that filter coeffs array is aligned to 16-byte boundary
-    delete[] filterCoeffsUnalign;
-    filterCoeffsUnalign = new float[2 * newLength + 4];
-    filterCoeffsAlign = (float *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+    // Ensure that filter coeffs array is aligned to 16-byte boundary. The folded
+    // coefficients for symmetric filters follow the stereo coefficients in the same
+    // array; as 'newLength' is divisible by 8, also these start at 16-byte boundary.
+    half = newLength / 2;
+    if ((filterCoeffsUnalign == NULL) || (newLength != oldLength))
+    {
+        delete[] filterCoeffsUnalign;
+        filterCoeffsUnalign = new float[2 * newLength + half + 4];
+        filterCoeffsAlign = (float *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+        foldedCoeffs = filterCoeffsAlign + 2 * newLength;
+    }
 
     fDivider = (float)resultDivider;
 
@@ -238,10 +263,254 @@ void FIRFilterSSE::setCoefficients(const float *coeffs, uint newLength, uint uRe
         filterCoeffsAlign[2 * i + 0] =
         filterCoeffsAlign[2 * i + 1] = coeffs[i + 0] / fDivider;
     }
+
+    if (bSymmetric)
+    {
+        // coefficients for the mirrored sample pairs 1 .. half. The center sample
+        // gets paired with itself, so halve its coefficient.
+        foldedFirst = coeffs[0] / fDivider;
+        for (i = 0; i < half; i ++)
+        {
+            foldedCoeffs[i] = coeffs[i + 1] / fDivider;
+        }
+        foldedCoeffs[half - 1] *= 0.5f;
+    }
 }
 
 
 
+// Accumulates one filter tap to the 4x4 output items of a tile
+static inline void accumulateTile(__m128 &sum0, __m128 &sum1, __m128 &sum2, __m128 &sum3,
+                                  const float *pSrc, const float *pCoef)
+{
+    __m128 vCoef = _mm_load1_ps(pCoef);
+
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(pSrc), vCoef));
+    sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(pSrc + 4), vCoef));
+    sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(pSrc + 8), vCoef));
+    sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(pSrc + 12), vCoef));
+}
+
+
+// Register-blocked filter routine for mono & stereo sound. Output item 'j' is 
+// the sum of 'source[j + CHANNELS * i] * coeffs[2 * i]' over the taps 'i', thus
+// 4 consecutive output items are calculated in one register with the coefficient
+// broadcast to all items. The outputs are calculated in tiles of 4 registers, 
+// i.e. 16 items, and the taps in tiles of 8 taps: within a tap tile, the same 
+// input vectors are needed for several outputs & taps, so they get loaded once 
+// and the coefficients only once per 16 output items.
+//
+// With SSE the routine is limited by the multiplication & addition throughput
+// same way as 'evaluateFilterStereo' that calculates 2 stereo frames at a time, 
+// so the stereo routine is kept as is and this one is used for mono sound.
+//
+// 'coeffs' are the scaled filter coefficients with stride of 2 items, i.e. 
+// the L/R duplicated stereo coefficients. Returns number of output sample frames.
+template <int CHANNELS>
+static int evaluateBlockedSSE(float *dest, const float *source, const float *coeffs, uint length, int count)
+{
+    const int numItems = count * CHANNELS;
+    const int numTiles = numItems / 16;
+    int t, j;
+
+    // each thread gets contiguous range of output tiles
+    #pragma omp parallel for schedule(static)
+    for (t = 0; t < numTiles; t ++)
+    {
+        const float *pSrc = source + 16 * t;
+        const float *pFil = coeffs;
+        __m128 sum0, sum1, sum2, sum3;
+        uint i;
+
+        sum0 = sum1 = sum2 = sum3 = _mm_setzero_ps();
+        for (i = 0; i < length; i += 8)
+        {
+            accumulateTile(sum0, sum1, sum2, sum3, pSrc, pFil);
+            accumulateTile(sum0, sum1, sum2, sum3, pSrc + CHANNELS, pFil + 2);
+            accumulateTile(sum0, sum1, sum2, sum3, pSrc + 2 * CHANNELS, pFil + 4);
+            accumulateTile(sum0, sum1, sum2, sum3, pSrc + 3 * CHANNELS, pFil + 6);
+            accumulateTile(sum0, sum1, sum2, sum3, pSrc + 4 * CHANNELS, pFil + 8);
+            accumulateTile(sum0, sum1, sum2, sum3, pSrc + 5 * CHANNELS, pFil + 10);
+            accumulateTile(sum0, sum1, sum2, sum3, pSrc + 6 * CHANNELS, pFil + 12);
+            accumulateTile(sum0, sum1, sum2, sum3, pSrc + 7 * CHANNELS, pFil + 14);
+
+            pSrc += 8 * CHANNELS;
+            pFil += 16;
+        }
+
+        _mm_storeu_ps(dest + 16 * t, sum0);
+        _mm_storeu_ps(dest + 16 * t + 4, sum1);
+        _mm_storeu_ps(dest + 16 * t + 8, sum2);
+        _mm_storeu_ps(dest + 16 * t + 12, sum3);
+    }
+
+    // remaining items one register at time
+    for (j = 16 * numTiles; j <= numItems - 4; j += 4)
+    {
+        const float *pSrc = source + j;
+        __m128 sum = _mm_setzero_ps();
+        uint i;
+
+        for (i = 0; i < length; i ++)
+        {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pSrc), _mm_load1_ps(coeffs + 2 * i)));
+            pSrc += CHANNELS;
+        }
+        _mm_storeu_ps(dest + j, sum);
+    }
+
+    // and the last ones one item at time
+    for (; j < numItems; j ++)
+    {
+        const float *pSrc = source + j;
+        float sum = 0;
+        uint i;
+
+        for (i = 0; i < length; i ++)
+        {
+            sum += pSrc[0] * coeffs[2 * i];
+            pSrc += CHANNELS;
+        }
+        dest[j] = sum;
+    }
+
+    return count;
+}
+
+
+// SSE-optimized version of the filter routine for mono sound
+uint FIRFilterSSE::evaluateFilterMono(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)(numSamples - length);
+
+    if (count < 1) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(filterCoeffsAlign != NULL);
+
+    return (uint)evaluateBlockedSSE<1>(dest, source, filterCoeffsAlign, length, count);
+}
+
+
+// Register-blocked filter routine for mono & stereo sound with symmetric filter
+// coefficients. The mirrored input items 'j + CHANNELS * i' and 
+// 'j + CHANNELS * (length - i)' are summed before multiplying with the common 
+// folded coefficient, thus halving the multiplications. As 4 consecutive output
+// items are calculated in one register like in 'evaluateBlockedSSE', both input
+// vectors are loaded in forward order and needn't be reversed.
+template <int CHANNELS>
+static int evaluateBlockedSymmetricSSE(float *dest, const float *source, const float *folded, 
+                                       float first, uint length, int count)
+{
+    const int numItems = count * CHANNELS;
+    const int numTiles = numItems / 16;
+    const int half = (int)length / 2;
+    const __m128 vFirst = _mm_set1_ps(first);
+    int t, j;
+
+    // each thread gets contiguous range of output tiles
+    #pragma omp parallel for schedule(static)
+    for (t = 0; t < numTiles; t ++)
+    {
+        const float *pFwd = source + 16 * t;
+        const float *pBwd = pFwd + CHANNELS * length;
+        __m128 sum0, sum1, sum2, sum3;
+        int i;
+
+        // the first tap has no pair
+        sum0 = _mm_mul_ps(_mm_loadu_ps(pFwd), vFirst);
+        sum1 = _mm_mul_ps(_mm_loadu_ps(pFwd + 4), vFirst);
+        sum2 = _mm_mul_ps(_mm_loadu_ps(pFwd + 8), vFirst);
+        sum3 = _mm_mul_ps(_mm_loadu_ps(pFwd + 12), vFirst);
+        for (i = 0; i < half; i ++)
+        {
+            __m128 vCoef = _mm_load1_ps(folded + i);
+
+            pFwd += CHANNELS;
+            pBwd -= CHANNELS;
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pFwd), _mm_loadu_ps(pBwd)), vCoef));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pFwd + 4), _mm_loadu_ps(pBwd + 4)), vCoef));
+            sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pFwd + 8), _mm_loadu_ps(pBwd + 8)), vCoef));
+            sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pFwd + 12), _mm_loadu_ps(pBwd + 12)), vCoef));
+        }
+
+        _mm_storeu_ps(dest + 16 * t, sum0);
+        _mm_storeu_ps(dest + 16 * t + 4, sum1);
+        _mm_storeu_ps(dest + 16 * t + 8, sum2);
+        _mm_storeu_ps(dest + 16 * t + 12, sum3);
+    }
+
+    // remaining items one register at time
+    for (j = 16 * numTiles; j <= numItems - 4; j += 4)
+    {
+        const float *pFwd = source + j;
+        const float *pBwd = pFwd + CHANNELS * length;
+        __m128 sum = _mm_mul_ps(_mm_loadu_ps(pFwd), vFirst);
+        int i;
+
+        for (i = 0; i < half; i ++)
+        {
+            pFwd += CHANNELS;
+            pBwd -= CHANNELS;
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pFwd), _mm_loadu_ps(pBwd)), _mm_load1_ps(folded + i)));
+        }
+        _mm_storeu_ps(dest + j, sum);
+    }
+
+    // and the last ones one item at time
+    for (; j < numItems; j ++)
+    {
+        const float *pSrc = source + j;
+        float sum = pSrc[0] * first;
+        int i;
+
+        for (i = 1; i <= half; i ++)
+        {
+            sum += (pSrc[CHANNELS * i] + pSrc[CHANNELS * ((int)length - i)]) * folded[i - 1];
+        }
+        dest[j] = sum;
+    }
+
+    return count;
+}
+
+
+// SSE-optimized version of the filter routine for mono sound with symmetric 
+// coefficients
+uint FIRFilterSSE::evaluateSymmetricMono(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)(numSamples - length);
+
+    if (count < 1) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(foldedCoeffs != NULL);
+
+    return (uint)evaluateBlockedSymmetricSSE<1>(dest, source, foldedCoeffs, foldedFirst, length, count);
+}
+
+
+// SSE-optimized version of the filter routine for stereo sound with symmetric
+// coefficients
+uint FIRFilterSSE::evaluateSymmetricStereo(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)(numSamples - length);
+
+    if (count < 1) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(foldedCoeffs != NULL);
+
+    return (uint)evaluateBlockedSymmetricSSE<2>(dest, source, foldedCoeffs, foldedFirst, length, count);
+}
+
+
 // SSE-optimized version of the filter routine for stereo sound
 uint FIRFilterSSE::evaluateFilterStereo(float *dest, const float *source, uint numSamples) const
 {
@@ -369,4 +638,736 @@ uint FIRFilterSSE::evaluateFilterStereo(float *dest, const float *source, uint n
     */
 }
 
+
+// Filters multichannel sound with the channels processed in parallel in SSE 
+// registers, 4 channels per register. If 'CHANNELS' is nonzero, the channel count
+// is fixed at compile time so that the compiler can fully unroll the channel 
+// loops; otherwise the channel count is given in 'numChannels'.
+//
+// 'coeffs' are the scaled filter coefficients with stride of 2 items, i.e. 
+// the L/R duplicated stereo coefficients.
+template <int CHANNELS>
+static void evaluateMultiSSE(float *dest, const float *source, const float *coeffs, 
+                             uint length, int count, int numChannels)
+{
+    const int channels = (CHANNELS > 0) ? CHANNELS : numChannels;
+    int j;
+
+    #pragma omp parallel for
+    for (j = 0; j < count; j ++)
+    {
+        const float *pSrc = source + j * channels;
+        float *pDest = dest + j * channels;
+        int c = 0;
+
+        // 8 channels at a time. Two accumulators per register for even & odd
+        // taps hide the addition latency.
+        for (; c <= channels - 8; c += 8)
+        {
+            const float *ptr = pSrc + c;
+            __m128 sum0a, sum0b, sum1a, sum1b;
+            uint i;
+
+            sum0a = sum0b = sum1a = sum1b = _mm_setzero_ps();
+            for (i = 0; i < length; i += 2)
+            {
+                __m128 vCoef0 = _mm_load1_ps(coeffs + 2 * i);
+                __m128 vCoef1 = _mm_load1_ps(coeffs + 2 * i + 2);
+
+                sum0a = _mm_add_ps(sum0a, _mm_mul_ps(_mm_loadu_ps(ptr), vCoef0));
+                sum1a = _mm_add_ps(sum1a, _mm_mul_ps(_mm_loadu_ps(ptr + 4), vCoef0));
+                sum0b = _mm_add_ps(sum0b, _mm_mul_ps(_mm_loadu_ps(ptr + channels), vCoef1));
+                sum1b = _mm_add_ps(sum1b, _mm_mul_ps(_mm_loadu_ps(ptr + channels + 4), vCoef1));
+                ptr += 2 * channels;
+            }
+            _mm_storeu_ps(pDest + c, _mm_add_ps(sum0a, sum0b));
+            _mm_storeu_ps(pDest + c + 4, _mm_add_ps(sum1a, sum1b));
+        }
+
+        // 4 channels, and 2 channels more if available, e.g. 5.1 sound. If less 
+        // than 4 channels remain, process the last 4 channels, overlapping with
+        // the channels done already.
+        for (; (c < channels) && (channels >= 4); c += 4)
+        {
+            if (c > channels - 4) c = channels - 4;
+
+            const float *ptr = pSrc + c;
+            const bool hasPair = (c + 6 <= channels) && (c + 8 > channels);
+            const __m128 vZero = _mm_setzero_ps();
+            __m128 sum0a, sum0b, sum1a, sum1b;
+            uint i;
+
+            sum0a = sum0b = sum1a = sum1b = _mm_setzero_ps();
+            for (i = 0; i < length; i += 2)
+            {
+                __m128 vCoef0 = _mm_load1_ps(coeffs + 2 * i);
+                __m128 vCoef1 = _mm_load1_ps(coeffs + 2 * i + 2);
+
+                sum0a = _mm_add_ps(sum0a, _mm_mul_ps(_mm_loadu_ps(ptr), vCoef0));
+                sum0b = _mm_add_ps(sum0b, _mm_mul_ps(_mm_loadu_ps(ptr + channels), vCoef1));
+                if (hasPair)
+                {
+                    sum1a = _mm_add_ps(sum1a, _mm_mul_ps(_mm_loadl_pi(vZero, (const __m64*)(ptr + 4)), vCoef0));
+                    sum1b = _mm_add_ps(sum1b, _mm_mul_ps(_mm_loadl_pi(vZero, (const __m64*)(ptr + channels + 4)), vCoef1));
+                }
+                ptr += 2 * channels;
+            }
+            _mm_storeu_ps(pDest + c, _mm_add_ps(sum0a, sum0b));
+            if (hasPair)
+            {
+                _mm_storel_pi((__m64*)(pDest + c + 4), _mm_add_ps(sum1a, sum1b));
+                c += 2;
+            }
+        }
+
+        // less than 4 channels one at a time
+        for (; c < channels; c ++)
+        {
+            const float *ptr = pSrc + c;
+            float sum = 0;
+            uint i;
+
+            for (i = 0; i < length; i ++)
+            {
+                sum += ptr[0] * coeffs[2 * i];
+                ptr += channels;
+            }
+            pDest[c] = sum;
+        }
+    }
+}
+
+
+// SSE-optimized version of the filter routine for multichannel sound. The usual
+// surround channel counts get routines specialized at compile time.
+uint FIRFilterSSE::evaluateFilterMulti(float *dest, const float *source, uint numSamples, uint numChannels)
+{
+    int count = (int)(numSamples - length);
+
+    if (count < 1) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(filterCoeffsAlign != NULL);
+
+    switch (numChannels)
+    {
+        case 4:
+            evaluateMultiSSE<4>(dest, source, filterCoeffsAlign, length, count, 4);
+            break;
+
+        case 6:
+            evaluateMultiSSE<6>(dest, source, filterCoeffsAlign, length, count, 6);
+            break;
+
+        case 8:
+            evaluateMultiSSE<8>(dest, source, filterCoeffsAlign, length, count, 8);
+            break;
+
+        default:
+            evaluateMultiSSE<0>(dest, source, filterCoeffsAlign, length, count, (int)numChannels);
+            break;
+    }
+
+    return (uint)count;
+}
+
+#endif  // SOUNDTOUCH_ALLOW_SSE
+
+
+#ifdef SOUNDTOUCH_ALLOW_FLOAT_SSE
+
+// SSE routines of the transposers that process floating point samples also
+// with integer sample type, see 'FloatTransposer'
+
+#include <xmmintrin.h>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE optimized functions of class 'InterpolateShannon'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "InterpolateShannon.h"
+
+// SSE-optimized filter routine for mono sound, 8 taps
+void InterpolateShannonSSE::filterMono(float *dest, const float *src, const float *phase, float k) const
+{
+    const __m128 vk = _mm_set1_ps(k);
+    __m128 c1, c2, sum;
+
+    // interpolate the coefficients between the phases
+    c1 = _mm_add_ps(_mm_loadu_ps(phase), _mm_mul_ps(vk, _mm_loadu_ps(phase + 8)));
+    c2 = _mm_add_ps(_mm_loadu_ps(phase + 4), _mm_mul_ps(vk, _mm_loadu_ps(phase + 12)));
+
+    sum = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src), c1), _mm_mul_ps(_mm_loadu_ps(src + 4), c2));
+
+    // sum the four floats of the accumulator together
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1,1,1,1)));
+    _mm_store_ss(dest, sum);
+}
+
+
+// SSE-optimized filter routine for stereo sound, 8 taps
+void InterpolateShannonSSE::filterStereo(float *dest, const float *src, const float *phase, float k) const
+{
+    const __m128 vk = _mm_set1_ps(k);
+    __m128 c1, c2, sum1, sum2;
+
+    c1 = _mm_add_ps(_mm_loadu_ps(phase), _mm_mul_ps(vk, _mm_loadu_ps(phase + 8)));
+    c2 = _mm_add_ps(_mm_loadu_ps(phase + 4), _mm_mul_ps(vk, _mm_loadu_ps(phase + 12)));
+
+    // pair the coefficients for the interleaved left & right channel samples
+    sum1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src), _mm_unpacklo_ps(c1, c1)),
+                      _mm_mul_ps(_mm_loadu_ps(src + 4), _mm_unpackhi_ps(c1, c1)));
+    sum2 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + 8), _mm_unpacklo_ps(c2, c2)),
+                      _mm_mul_ps(_mm_loadu_ps(src + 12), _mm_unpackhi_ps(c2, c2)));
+
+    // accumulators have two partial sums of left & right channel each
+    sum1 = _mm_add_ps(sum1, sum2);
+    sum1 = _mm_add_ps(sum1, _mm_movehl_ps(sum1, sum1));
+    _mm_storel_pi((__m64*)dest, sum1);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE optimized functions of classes 'InterpolateCubic' and
+// 'InterpolateLinearFloat'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "InterpolateCubic.h"
+#include "InterpolateLinear.h"
+
+// Calculates the source positions of four successive output sample frames with 
+// constant rate, starting from fractional position 'fract'. Stores the whole 
+// parts of the positions to 'whole', and returns the fractional parts.
+static inline __m128 blockPositions(int *whole, double fract, double rate)
+{
+    float frac[4];
+
+    for (int k = 0; k < 4; k ++)
+    {
+        double pos = fract + k * rate;
+        whole[k] = (int)pos;
+        frac[k] = (float)(pos - whole[k]);
+    }
+    return _mm_loadu_ps(frac);
+}
+
+
+// Advances the fractional position 'fract' over four output sample frames. 
+// Returns the whole part of the advance.
+static inline int advanceBlock(double &fract, double rate)
+{
+    double pos = fract + 4 * rate;
+    int whole = (int)pos;
+
+    fract = pos - whole;
+    return whole;
+}
+
+
+// Combines the partial sums of two stereo sample frames, each having the left
+// & right channel sums in lower and upper halves, to the two output frames
+static inline __m128 combineStereo(__m128 sum1, __m128 sum2)
+{
+    return _mm_add_ps(_mm_movelh_ps(sum1, sum2), _mm_movehl_ps(sum2, sum1));
+}
+
+
+// Calculates the cubic interpolation weights of the four source samples for 
+// four output sample frames of fractional positions 'x'. 'y[j]' gets the weights 
+// of j'th source sample in the order of the output frames.
+static inline void cubicWeights(__m128 *y, const float *coeffs, __m128 x)
+{
+    const __m128 x2 = _mm_mul_ps(x, x);
+    const __m128 x3 = _mm_mul_ps(x2, x);
+
+    for (int j = 0; j < 4; j ++)
+    {
+        const float *c = coeffs + 4 * j;
+        __m128 sum;
+
+        sum = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(c[0]), x3), _mm_mul_ps(_mm_set1_ps(c[1]), x2));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(c[2]), x));
+        y[j] = _mm_add_ps(sum, _mm_set1_ps(c[3]));
+    }
+}
+
+
+// SSE-optimized cubic interpolation for mono sound. Calculates four output
+// samples at a time, and the remaining tail with the plain C routine.
+int InterpolateCubicSSE::transposeMono(float *pdest, const float *psrc, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 4;
+    int srcCount = 0;
+    int remaining;
+    int i = 0;
+
+    while (1)
+    {
+        int whole[4];
+        __m128 y[4];
+        __m128 s0, s1, s2, s3, out;
+
+        cubicWeights(y, _coeffs, blockPositions(whole, fract, rate));
+        if (srcCount + whole[3] >= srcSampleEnd) break;
+
+        // gather the source samples of the four outputs, and transpose them 
+        // so that 'sj' holds the j'th source sample of each output
+        s0 = _mm_loadu_ps(psrc + whole[0]);
+        s1 = _mm_loadu_ps(psrc + whole[1]);
+        s2 = _mm_loadu_ps(psrc + whole[2]);
+        s3 = _mm_loadu_ps(psrc + whole[3]);
+        _MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+
+        out = _mm_add_ps(_mm_mul_ps(y[0], s0), _mm_mul_ps(y[1], s1));
+        out = _mm_add_ps(out, _mm_mul_ps(y[2], s2));
+        out = _mm_add_ps(out, _mm_mul_ps(y[3], s3));
+        _mm_storeu_ps(pdest + i, out);
+        i += 4;
+
+        int advance = advanceBlock(fract, rate);
+        psrc += advance;
+        srcCount += advance;
+    }
+
+    remaining = srcSamples - srcCount;
+    i += InterpolateCubic::transposeMono(pdest + i, psrc, remaining);
+    srcSamples = srcCount + remaining;
+    return i;
+}
+
+
+// SSE-optimized cubic interpolation for stereo sound. Calculates four output
+// sample frames at a time, and the remaining tail with the plain C routine.
+int InterpolateCubicSSE::transposeStereo(float *pdest, const float *psrc, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 4;
+    int srcCount = 0;
+    int remaining;
+    int i = 0;
+
+    while (1)
+    {
+        int whole[4];
+        __m128 y[4];
+        __m128 sum[4];
+
+        cubicWeights(y, _coeffs, blockPositions(whole, fract, rate));
+        if (srcCount + whole[3] >= srcSampleEnd) break;
+
+        // transpose the weights so that 'y[k]' holds the weights of k'th output
+        _MM_TRANSPOSE4_PS(y[0], y[1], y[2], y[3]);
+
+        for (int k = 0; k < 4; k ++)
+        {
+            const float *src = psrc + 2 * whole[k];
+
+            // pair the weights for the interleaved left & right channel samples
+            sum[k] = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src), _mm_unpacklo_ps(y[k], y[k])),
+                                _mm_mul_ps(_mm_loadu_ps(src + 4), _mm_unpackhi_ps(y[k], y[k])));
+        }
+        _mm_storeu_ps(pdest + 2 * i, combineStereo(sum[0], sum[1]));
+        _mm_storeu_ps(pdest + 2 * i + 4, combineStereo(sum[2], sum[3]));
+        i += 4;
+
+        int advance = advanceBlock(fract, rate);
+        psrc += 2 * advance;
+        srcCount += advance;
+    }
+
+    remaining = srcSamples - srcCount;
+    i += InterpolateCubic::transposeStereo(pdest + 2 * i, psrc, remaining);
+    srcSamples = srcCount + remaining;
+    return i;
+}
+
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+
+// SSE-optimized linear interpolation for mono sound. Calculates four output
+// samples at a time, and the remaining tail with the plain C routine.
+int InterpolateLinearFloatSSE::transposeMono(float *dest, const float *src, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 1;
+    int srcCount = 0;
+    int remaining;
+    int i = 0;
+
+    while (1)
+    {
+        int whole[4];
+        __m128 x, s01, s23, s0, s1, out;
+
+        x = blockPositions(whole, fract, rate);
+        if (srcCount + whole[3] >= srcSampleEnd) break;
+
+        // gather the source sample pairs of the four outputs
+        s01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(src + whole[0])),
+                           (const __m64*)(src + whole[1]));
+        s23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(src + whole[2])),
+                           (const __m64*)(src + whole[3]));
+        s0 = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(2,0,2,0));
+        s1 = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(3,1,3,1));
+
+        // out = (1 - x) * s0 + x * s1
+        out = _mm_add_ps(s0, _mm_mul_ps(x, _mm_sub_ps(s1, s0)));
+        _mm_storeu_ps(dest + i, out);
+        i += 4;
+
+        int advance = advanceBlock(fract, rate);
+        src += advance;
+        srcCount += advance;
+    }
+
+    remaining = srcSamples - srcCount;
+    i += InterpolateLinearFloat::transposeMono(dest + i, src, remaining);
+    srcSamples = srcCount + remaining;
+    return i;
+}
+
+
+// SSE-optimized linear interpolation for stereo sound. Calculates four output
+// sample frames at a time, and the remaining tail with the plain C routine.
+int InterpolateLinearFloatSSE::transposeStereo(float *dest, const float *src, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 1;
+    int srcCount = 0;
+    int remaining;
+    int i = 0;
+
+    while (1)
+    {
+        int whole[4];
+        __m128 x, vol, w01, w23, sum[4];
+
+        x = blockPositions(whole, fract, rate);
+        if (srcCount + whole[3] >= srcSampleEnd) break;
+
+        // weights (1 - x, x) of each output interleaved, then spread each
+        // weight for the left & right channel samples
+        vol = _mm_sub_ps(_mm_set1_ps(1.0f), x);
+        w01 = _mm_unpacklo_ps(vol, x);
+        w23 = _mm_unpackhi_ps(vol, x);
+        sum[0] = _mm_mul_ps(_mm_loadu_ps(src + 2 * whole[0]), _mm_shuffle_ps(w01, w01, _MM_SHUFFLE(1,1,0,0)));
+        sum[1] = _mm_mul_ps(_mm_loadu_ps(src + 2 * whole[1]), _mm_shuffle_ps(w01, w01, _MM_SHUFFLE(3,3,2,2)));
+        sum[2] = _mm_mul_ps(_mm_loadu_ps(src + 2 * whole[2]), _mm_shuffle_ps(w23, w23, _MM_SHUFFLE(1,1,0,0)));
+        sum[3] = _mm_mul_ps(_mm_loadu_ps(src + 2 * whole[3]), _mm_shuffle_ps(w23, w23, _MM_SHUFFLE(3,3,2,2)));
+
+        _mm_storeu_ps(dest + 2 * i, combineStereo(sum[0], sum[1]));
+        _mm_storeu_ps(dest + 2 * i + 4, combineStereo(sum[2], sum[3]));
+        i += 4;
+
+        int advance = advanceBlock(fract, rate);
+        src += 2 * advance;
+        srcCount += advance;
+    }
+
+    remaining = srcSamples - srcCount;
+    i += InterpolateLinearFloat::transposeStereo(dest + 2 * i, src, remaining);
+    srcSamples = srcCount + remaining;
+    return i;
+}
+
+
+#endif  // SOUNDTOUCH_ALLOW_SSE
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE2 optimized norm table calculation of class 'TDStretch',
+// shared by all the cross-correlation routine versions
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <emmintrin.h>
+#include "TDStretch.h"
+
+// Loads four samples converted to double precision
+static inline void loadDouble4(__m128d &lo, __m128d &hi, const float *src)
+{
+    __m128 v = _mm_loadu_ps(src);
+
+    lo = _mm_cvtps_pd(v);
+    hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+}
+
+
+static inline void loadDouble4(__m128d &lo, __m128d &hi, const short *src)
+{
+    __m128i v = _mm_loadl_epi64((const __m128i*)src);
+
+    // sign-extend to 32 bits
+    v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    lo = _mm_cvtepi32_pd(v);
+    hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(v, _MM_SHUFFLE(3, 2, 3, 2)));
+}
+
+
+// Loads the energies of eight mono or stereo sample frames, two frames in each of
+// 'e1' .. 'e4'
+static inline void loadEnergy8(__m128d &e1, __m128d &e2, __m128d &e3, __m128d &e4,
+                               const SAMPLETYPE *src, int channels)
+{
+    if (channels == 1)
+    {
+        loadDouble4(e1, e2, src);
+        loadDouble4(e3, e4, src + 4);
+        e1 = _mm_mul_pd(e1, e1);
+        e2 = _mm_mul_pd(e2, e2);
+        e3 = _mm_mul_pd(e3, e3);
+        e4 = _mm_mul_pd(e4, e4);
+    }
+    else
+    {
+        __m128d x[8];
+        int k;
+
+        // frames in 'x[2k]' & 'x[2k + 1]' as left & right channel pairs
+        for (k = 0; k < 4; k ++)
+        {
+            loadDouble4(x[2 * k], x[2 * k + 1], src + 4 * k);
+            x[2 * k] = _mm_mul_pd(x[2 * k], x[2 * k]);
+            x[2 * k + 1] = _mm_mul_pd(x[2 * k + 1], x[2 * k + 1]);
+        }
+        e1 = _mm_add_pd(_mm_unpacklo_pd(x[0], x[1]), _mm_unpackhi_pd(x[0], x[1]));
+        e2 = _mm_add_pd(_mm_unpacklo_pd(x[2], x[3]), _mm_unpackhi_pd(x[2], x[3]));
+        e3 = _mm_add_pd(_mm_unpacklo_pd(x[4], x[5]), _mm_unpackhi_pd(x[4], x[5]));
+        e4 = _mm_add_pd(_mm_unpacklo_pd(x[6], x[7]), _mm_unpackhi_pd(x[6], x[7]));
+    }
+}
+
+
+// Calculates the prefix sum of the sample frame energies of mono or stereo sound 
+// into 'pNormTable[1..refFrames]', eight frames at a time. The prefix sums inside
+// the block of eight frames don't depend on the previous blocks, only adding 
+// the sum of the previous blocks in 'carry' does, so that the dependency chain 
+// from one block to the next is a single addition. The squares & sums are exact 
+// in double precision with integer samples, so the result equals the scalar version.
+void TDStretch::calcEnergyPrefixSSE2(const SAMPLETYPE *refPos, int refFrames)
+{
+    const __m128d zero = _mm_setzero_pd();
+    double *pSum = pNormTable + 1;
+    __m128d carry;
+    double sum;
+    int i, c;
+
+    assert((channels == 1) || (channels == 2));
+
+    carry = zero;
+    for (i = 0; i <= refFrames - 8; i += 8)
+    {
+        __m128d e1, e2, e3, e4;
+
+        loadEnergy8(e1, e2, e3, e4, refPos + i * channels, channels);
+
+        // prefix sums inside the pairs, then inside the quads, then inside the block
+        e1 = _mm_add_pd(e1, _mm_unpacklo_pd(zero, e1));
+        e2 = _mm_add_pd(e2, _mm_unpacklo_pd(zero, e2));
+        e3 = _mm_add_pd(e3, _mm_unpacklo_pd(zero, e3));
+        e4 = _mm_add_pd(e4, _mm_unpacklo_pd(zero, e4));
+        e2 = _mm_add_pd(e2, _mm_unpackhi_pd(e1, e1));
+        e4 = _mm_add_pd(e4, _mm_unpackhi_pd(e3, e3));
+        e3 = _mm_add_pd(e3, _mm_unpackhi_pd(e2, e2));
+        e4 = _mm_add_pd(e4, _mm_unpackhi_pd(e2, e2));
+
+        _mm_storeu_pd(pSum + i, _mm_add_pd(e1, carry));
+        _mm_storeu_pd(pSum + i + 2, _mm_add_pd(e2, carry));
+        _mm_storeu_pd(pSum + i + 4, _mm_add_pd(e3, carry));
+        e4 = _mm_add_pd(e4, carry);
+        _mm_storeu_pd(pSum + i + 6, e4);
+        carry = _mm_unpackhi_pd(e4, e4);
+    }
+
+    // the remaining frames
+    sum = _mm_cvtsd_f64(carry);
+    for (; i < refFrames; i ++)
+    {
+        const SAMPLETYPE *ptr = refPos + i * channels;
+
+        for (c = 0; c < channels; c ++)
+        {
+            sum += (double)ptr[c] * (double)ptr[c];
+        }
+        pSum[i] = sum;
+    }
+}
+
+#endif  // SOUNDTOUCH_ALLOW_FLOAT_SSE
+
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE optimized functions of class 'InterpolateRational'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "InterpolateRational.h"
+
+// SSE-optimized filter routine for mono sound. Filter length is divisible by 4.
+void InterpolateRationalSSE::filterMono(float *dest, const float *src, const float *phase) const
+{
+    __m128 sum1, sum2;
+    int k;
+
+    sum1 = sum2 = _mm_setzero_ps();
+    for (k = 0; k <= taps - 8; k += 8)
+    {
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(src + k), _mm_loadu_ps(phase + k)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(src + k + 4), _mm_loadu_ps(phase + k + 4)));
+    }
+    if (k < taps)
+    {
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(src + k), _mm_loadu_ps(phase + k)));
+    }
+
+    // sum the four floats of the accumulators together
+    sum1 = _mm_add_ps(sum1, sum2);
+    sum1 = _mm_add_ps(sum1, _mm_movehl_ps(sum1, sum1));
+    sum1 = _mm_add_ss(sum1, _mm_shuffle_ps(sum1, sum1, _MM_SHUFFLE(1,1,1,1)));
+    _mm_store_ss(dest, sum1);
+}
+
+
+// SSE-optimized filter routine for stereo sound. Filter length is divisible by 4.
+void InterpolateRationalSSE::filterStereo(float *dest, const float *src, const float *phase) const
+{
+    __m128 sum1, sum2;
+
+    sum1 = sum2 = _mm_setzero_ps();
+    for (int k = 0; k < taps; k += 4)
+    {
+        __m128 c = _mm_loadu_ps(phase + k);
+
+        // pair the coefficients for the interleaved left & right channel samples
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(src + 2 * k), _mm_unpacklo_ps(c, c)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(src + 2 * k + 4), _mm_unpackhi_ps(c, c)));
+    }
+
+    // accumulators have two partial sums of left & right channel each
+    sum1 = _mm_add_ps(sum1, sum2);
+    sum1 = _mm_add_ps(sum1, _mm_movehl_ps(sum1, sum1));
+    _mm_storel_pi((__m64*)dest, sum1);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE optimized functions of class 'IIRFilter'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "IIRFilter.h"
+
+// Loads 'count' <= 4 consecutive floats, the rest of the items are zeroed
+static inline __m128 loadPartial(const float *src, int count)
+{
+    switch (count)
+    {
+        case 1:
+            return _mm_load_ss(src);
+
+        case 2:
+            return _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)src);
+
+        case 3:
+            return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)src), _mm_load_ss(src + 2));
+
+        default:
+            return _mm_loadu_ps(src);
+    }
+}
+
+
+// Stores the first 'count' <= 4 floats of 'value'
+static inline void storePartial(float *dest, __m128 value, int count)
+{
+    switch (count)
+    {
+        case 1:
+            _mm_store_ss(dest, value);
+            break;
+
+        case 2:
+            _mm_storel_pi((__m64*)dest, value);
+            break;
+
+        case 3:
+            _mm_storel_pi((__m64*)dest, value);
+            _mm_store_ss(dest + 2, _mm_movehl_ps(value, value));
+            break;
+
+        default:
+            _mm_storeu_ps(dest, value);
+            break;
+    }
+}
+
+
+// SSE-optimized IIR filter routine. The channels are processed in groups of four
+// channels, one channel in each float of the SSE registers, so that the recursive
+// dependency of the samples doesn't limit the parallelism.
+void IIRFilterSSE::evaluateChannels(float *dest, const float *src, uint numSamples)
+{
+    const __m128 vAntiDenormal = _mm_set1_ps(IIR_ANTI_DENORMAL);
+    __m128 vCoeffs[3 * IIR_MAX_SECTIONS];
+    int c0, s;
+
+    for (s = 0; s < 3 * numSections; s ++)
+    {
+        vCoeffs[s] = _mm_set1_ps(coeffs[s]);
+    }
+
+    for (c0 = 0; c0 < numChannels; c0 += 4)
+    {
+        __m128 z1[IIR_MAX_SECTIONS], z2[IIR_MAX_SECTIONS];
+        int lanes = (numChannels - c0 < 4) ? numChannels - c0 : 4;
+        const float *pSrc = src + c0;
+        float *pDest = dest + c0;
+        uint j;
+
+        // the state rows are aligned and padded to multiple of 4 channels
+        for (s = 0; s < numSections; s ++)
+        {
+            z1[s] = _mm_load_ps(state + 2 * s * stride + c0);
+            z2[s] = _mm_load_ps(state + (2 * s + 1) * stride + c0);
+        }
+
+        for (j = 0; j < numSamples; j ++)
+        {
+            __m128 x = _mm_add_ps(loadPartial(pSrc, lanes), vAntiDenormal);
+
+            for (s = 0; s < numSections; s ++)
+            {
+                const __m128 *vc = vCoeffs + 3 * s;
+                __m128 v3 = _mm_sub_ps(x, z2[s]);
+                __m128 v1 = _mm_add_ps(_mm_mul_ps(vc[0], z1[s]), _mm_mul_ps(vc[1], v3));
+                __m128 v2 = _mm_add_ps(_mm_add_ps(z2[s], _mm_mul_ps(vc[1], z1[s])), _mm_mul_ps(vc[2], v3));
+
+                // update the integrator states, the low-pass output is 'v2'
+                z1[s] = _mm_sub_ps(_mm_add_ps(v1, v1), z1[s]);
+                z2[s] = _mm_sub_ps(_mm_add_ps(v2, v2), z2[s]);
+                x = v2;
+            }
+            storePartial(pDest, x, lanes);
+
+            pSrc += numChannels;
+            pDest += numChannels;
+        }
+
+        for (s = 0; s < numSections; s ++)
+        {
+            _mm_store_ps(state + 2 * s * stride + c0, z1[s]);
+            _mm_store_ps(state + (2 * s + 1) * stride + c0, z2[s]);
+        }
+    }
+}
+
 #endif  // SOUNDTOUCH_ALLOW_SSE
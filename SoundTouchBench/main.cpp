@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Microbenchmark for the SoundTouch FIR filter routines. Measures the filter
+/// throughput as filter taps per CPU timestamp counter cycle for the plain C 
+/// and the CPU specific versions of the routines (MMX with integer samples, SSE
+/// and AVX2 with floating point samples), with mono, stereo and 5.1 sound, and
+/// with symmetric (linear-phase) and non-symmetric filter coefficients. The 
+/// last column is the FFT convolution version, which 'FIRFilter::newInstance'
+/// uses for long filters, with all the extensions enabled.
+///
+/// Measures also the sample rate transposer algorithms as CPU cycles per output
+/// sample frame with different input batch sizes. With integer samples this
+/// includes the conversions of the cubic & shannon algorithms to floating 
+/// point and back.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#else
+    #include <x86intrin.h>
+#endif
+
+#include "../SoundTouch/FIRFilter.h"
+#include "../SoundTouch/RateTransposer.h"
+#include "../SoundTouch/cpu_detect.h"
+
+using namespace soundtouch;
+
+// Number of output sample frames per filter call
+#define BENCH_FRAMES    8192
+
+// Longest benchmarked filter
+#define BENCH_MAX_TAPS  1024
+
+// Number of filter calls per measurement; the fastest call counts
+#define BENCH_ROUNDS    30
+
+// Benchmarked routine versions, and extensions to disable for getting them
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    static const char *versionNames[] = {"C", "MMX"};
+    static const uint versionDisable[] = {~0U, 0};
+#else
+    static const char *versionNames[] = {"C", "SSE", "AVX2"};
+    static const uint versionDisable[] = {~0U, SUPPORT_AVX2 | SUPPORT_AVX512, 0};
+#endif
+
+#define NUM_VERSIONS    (sizeof(versionNames) / sizeof(versionNames[0]))
+
+// Number of input sample frames per transposer measurement
+#define TRANSPOSE_FRAMES    65536
+
+// Transposing rate of the transposer measurements. Not a ratio of small 
+// integers, so that the measurements use the algorithm set by 'setAlgorithm'
+// instead of the rational rate transposer.
+#define TRANSPOSE_RATE      0.9301
+
+
+// Measures the filter throughput in taps per cycle
+static double measure(FIRFilter *pFIR, const SAMPLETYPE *src, SAMPLETYPE *dest, uint channels)
+{
+    unsigned long long best = ~0ULL;
+    uint length = pFIR->getLength();
+    uint result = 0;
+
+    for (int i = 0; i < BENCH_ROUNDS; i ++)
+    {
+        unsigned long long start = __rdtsc();
+        result = pFIR->evaluate(dest, src, BENCH_FRAMES + length, channels);
+        unsigned long long cycles = __rdtsc() - start;
+
+        if (cycles < best) best = cycles;
+    }
+    return (double)result * length * channels / (double)best;
+}
+
+
+// Measures the transposer throughput in cycles per output sample frame, when
+// feeding the input in batches of 'batch' sample frames
+static double measureTransposer(const SAMPLETYPE *src, SAMPLETYPE *dest, int channels, int batch)
+{
+    unsigned long long best = ~0ULL;
+    uint result = 0;
+
+    for (int i = 0; i < BENCH_ROUNDS; i ++)
+    {
+        RateTransposer transposer;
+
+        transposer.setChannels(channels);
+        transposer.setRate(TRANSPOSE_RATE);
+        transposer.enableAAFilter(false);
+
+        unsigned long long start = __rdtsc();
+        result = 0;
+        for (int pos = 0; pos + batch <= TRANSPOSE_FRAMES; pos += batch)
+        {
+            transposer.putSamples(src + pos * channels, batch);
+            result += transposer.getOutput()->receiveSamples(dest, 2 * TRANSPOSE_FRAMES);
+        }
+        unsigned long long cycles = __rdtsc() - start;
+
+        if (cycles < best) best = cycles;
+    }
+    return (double)best / (double)result;
+}
+
+
+// Measures the sample rate transposer algorithms
+static void benchTransposer(const SAMPLETYPE *src, SAMPLETYPE *dest)
+{
+    const char *algorithmNames[] = {"linear", "cubic", "shannon"};
+    const int batches[] = {64, 512, 4096};
+    const int channelCounts[] = {1, 2, 6};
+    uint a, b, c;
+
+    printf("\nTransposer cycles per output sample frame, by input batch size\n\n");
+    printf("algorithm  ch ");
+    for (b = 0; b < sizeof(batches) / sizeof(batches[0]); b ++)
+    {
+        printf("%8d", batches[b]);
+    }
+    printf("\n");
+
+    disableExtensions(0);
+    for (a = 0; a < sizeof(algorithmNames) / sizeof(algorithmNames[0]); a ++)
+    {
+        // the transposer class gets selected by the algorithm setting
+        TransposerBase::setAlgorithm((TransposerBase::ALGORITHM)a);
+        for (c = 0; c < sizeof(channelCounts) / sizeof(channelCounts[0]); c ++)
+        {
+            printf("%-10s %2d ", algorithmNames[a], channelCounts[c]);
+            for (b = 0; b < sizeof(batches) / sizeof(batches[0]); b ++)
+            {
+                printf("%8.1f", measureTransposer(src, dest, channelCounts[c], batches[b]));
+            }
+            printf("\n");
+        }
+    }
+}
+
+
+int main()
+{
+    const uint lengths[] = {32, 64, 128, 256, 512, 1024};
+    const uint channelCounts[] = {1, 2, 6};
+    SAMPLETYPE *src;
+    SAMPLETYPE *dest;
+    SAMPLETYPE coeffs[BENCH_MAX_TAPS];
+    uint i, l, c, e;
+    int symmetric;
+
+    src = new SAMPLETYPE[6 * (BENCH_FRAMES + BENCH_MAX_TAPS)];
+    dest = new SAMPLETYPE[6 * (BENCH_FRAMES + BENCH_MAX_TAPS)];
+    for (i = 0; i < 6 * (BENCH_FRAMES + BENCH_MAX_TAPS); i ++)
+    {
+        src[i] = (SAMPLETYPE)(rand() % 20000 - 10000);
+    }
+
+    printf("FIR filter throughput, taps per cycle\n\n");
+    printf("coeffs     taps  ch ");
+    for (e = 0; e < NUM_VERSIONS; e ++)
+    {
+        printf("%8s", versionNames[e]);
+    }
+    printf("%8s\n", "FFT");
+
+    for (symmetric = 1; symmetric >= 0; symmetric --)
+    {
+        for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l ++)
+        {
+            uint length = lengths[l];
+
+            for (i = 0; i < length; i ++)
+            {
+                coeffs[i] = (SAMPLETYPE)(rand() % 2000 - 1000);
+            }
+            if (symmetric)
+            {
+                for (i = 1; i < length / 2; i ++)
+                {
+                    coeffs[length - i] = coeffs[i];
+                }
+            }
+
+            for (c = 0; c < sizeof(channelCounts) / sizeof(channelCounts[0]); c ++)
+            {
+                FIRFilter *pFIR;
+
+                printf("%-10s %4d  %2d ", symmetric ? "symmetric" : "generic", length, channelCounts[c]);
+                for (e = 0; e < NUM_VERSIONS; e ++)
+                {
+                    // the FIR filter class gets selected by the enabled extensions
+                    disableExtensions(versionDisable[e]);
+                    pFIR = FIRFilter::newInstance();
+                    pFIR->setCoefficients(coeffs, length, 14);
+                    printf("%8.2f", measure(pFIR, src, dest, channelCounts[c]));
+                    delete pFIR;
+                }
+
+                // FFT convolution of all channels, regardless of the length 
+                // & channel count limits of 'newInstance'
+                disableExtensions(0);
+                pFIR = ::new FIRFilterFFT;
+                pFIR->setCoefficients(coeffs, length, 14);
+                printf("%8.2f\n", measure(pFIR, src, dest, channelCounts[c]));
+                delete pFIR;
+            }
+        }
+    }
+
+    delete[] src;
+    delete[] dest;
+
+    src = new SAMPLETYPE[6 * TRANSPOSE_FRAMES];
+    dest = new SAMPLETYPE[6 * 2 * TRANSPOSE_FRAMES];
+    for (i = 0; i < 6 * TRANSPOSE_FRAMES; i ++)
+    {
+        src[i] = (SAMPLETYPE)(rand() % 20000 - 10000);
+    }
+    benchTransposer(src, dest);
+
+    delete[] src;
+    delete[] dest;
+    return 0;
+}
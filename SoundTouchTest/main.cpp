@@ -0,0 +1,681 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Tests for the SoundTouch processing routines:
+///
+/// - Sample rate transposer: feeds a sine through the 'RateTransposer' with each
+///   interpolation algorithm, changing the rate in the middle of the stream 
+///   between rates that use different processing paths (the interpolating 
+///   transposer, the half-band transposer for 0.5 and the rational transposer for
+///   ratios of small integers), and checks that the output stays continuous and
+///   at the same level across the path changes.
+///
+/// - FFT convolution: compares the output of 'FIRFilterFFT' with the plain C 
+///   direct-form 'FIRFilter' for long filters.
+///
+/// - TDStretch kernels: compares the cross-correlation and overlap-mix routines
+///   of each CPU-specific TDStretch version, selected with 'disableExtensions',
+///   with the plain C version.
+///
+/// - Overlap seek: checks that the FFT-based seek ('SEEK_FFT') finds the same 
+///   overlap position as the full search ('SEEK_FULL') with each TDStretch version.
+///
+/// Returns nonzero if any of the tests fails.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include "../SoundTouch/RateTransposer.h"
+#include "../SoundTouch/FIRFilter.h"
+#include "../SoundTouch/TDStretch.h"
+#include "../SoundTouch/cpu_detect.h"
+
+using namespace soundtouch;
+
+#define PI  3.1415926536
+
+// Amplitude of the test sine
+#define SINE_AMPLITUDE      10000.0
+
+// Test sine period in input sample frames. Long enough that the sine is well
+// below the anti-alias filter cut-off with all the tested rates.
+#define SINE_PERIOD         400
+
+// Number of input sample frames fed with each rate
+#define FRAMES_PER_RATE     8192
+
+// Input batch size in sample frames
+#define BATCH_FRAMES        1000
+
+// Number of output sample frames in the beginning that are skipped, while the
+// filters settle
+#define SETTLE_FRAMES       1024
+
+// Allowed deviation of the output peak level from the sine amplitude, and of the
+// sample-to-sample change from the steepest slope of the sine, in LSB
+#define LEVEL_TOLERANCE     60.0
+#define STEP_TOLERANCE      20.0
+
+// Rates that alternate between the interpolating, the half-band and the rational
+// transposer paths
+static const double testRates[] = {0.9301, 0.5, 0.919, 147.0 / 160.0, 0.9301, 0.5, 0.9301};
+
+#define NUM_RATES   (sizeof(testRates) / sizeof(testRates[0]))
+
+// Number of output sample frames of the FFT convolution test. Spans several
+// transform blocks also with the longest filter.
+#define FIR_TEST_FRAMES     20000
+
+// Amplitude of the random FIR test input
+#define FIR_TEST_AMPLITUDE  30000
+
+// Allowed difference of the FFT convolution output from the direct form. With 
+// integer samples the FFT version rounds the result to the nearest integer, 
+// while the direct form truncates it with the '>> resultDivFactor' shift, so 
+// they may differ by 1 LSB. With floating point samples both versions sum in 
+// double precision, so they differ by the float rounding of the result.
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    #define FIR_TOLERANCE   1.0
+#else
+    #define FIR_TOLERANCE   (1e-6 * FIR_TEST_AMPLITUDE)
+#endif
+
+// Amplitude of the random TDStretch kernel test data
+#define TDS_TEST_AMPLITUDE  10000
+
+// Extra items at the end of the output buffer of the overlap-mix test, which the
+// routines mustn't overwrite
+#define TDS_GUARD_ITEMS     32
+
+// Value of the guard items
+#define TDS_GUARD_VALUE     12345
+
+/// CPU-specific TDStretch version: the extensions to disable for getting it from
+/// 'TDStretch::newInstance', and the extensions it needs. 'alignedOnly' is set if 
+/// the cross-correlation routine evaluates only 16-byte aligned mixing positions.
+struct TDSVERSION
+{
+    const char *name;
+    uint disable;
+    uint require;
+    bool alignedOnly;
+};
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    static const TDSVERSION tdsVersions[] =
+    {
+        {"C", ~0U, 0, false},
+#ifdef SOUNDTOUCH_ALLOW_MMX
+        {"MMX", SUPPORT_SSE41, SUPPORT_MMX, false},
+#endif
+#if defined(SOUNDTOUCH_ALLOW_SSE41) && defined(SOUNDTOUCH_ALLOW_MMX)
+        {"SSE4.1", 0, SUPPORT_MMX | SUPPORT_SSE41, false},
+#endif
+    };
+
+    // The overlap length is rounded to a power of two with integer samples
+    static const int tdsOverlapMs[] = {3, 6, 12};
+    static const int tdsSampleRates[] = {44100, 44100, 44100};
+#else
+    static const TDSVERSION tdsVersions[] =
+    {
+        {"C", ~0U, 0, false},
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    #ifdef SOUNDTOUCH_ALLOW_NONEXACT_SIMD_OPTIMIZATION
+        {"SSE", SUPPORT_AVX2 | SUPPORT_AVX512, SUPPORT_SSE, true},
+    #else
+        {"SSE", SUPPORT_AVX2 | SUPPORT_AVX512, SUPPORT_SSE, false},
+    #endif
+#endif
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+        {"AVX2", SUPPORT_AVX512, SUPPORT_AVX2, false},
+#endif
+#ifdef SOUNDTOUCH_ALLOW_AVX512
+        {"AVX-512", 0, SUPPORT_AVX512, false},
+#endif
+    };
+
+    // 8ms overlap gives 336, 344, 352 and 360 frames with these rates. With mono 
+    // sound the item counts leave 16, 24, 0 and 8 items after the 32-item rounds 
+    // of the AVX-512 routines, so that the masked tail handling gets tested.
+    static const int tdsOverlapMs[] = {8, 8, 8, 8};
+    static const int tdsSampleRates[] = {42000, 43000, 44100, 45000};
+#endif
+
+// Number of random seek positions tested with each TDStretch version & channel count
+#define SEEK_TEST_ROUNDS    50
+
+// Amplitude of the random noise added to the reference of the seek test, so that
+// the reference doesn't match the mixing data exactly
+#define SEEK_NOISE_AMPLITUDE    500
+
+#define NUM_TDS_VERSIONS    (sizeof(tdsVersions) / sizeof(tdsVersions[0]))
+#define NUM_TDS_OVERLAPS    (sizeof(tdsOverlapMs) / sizeof(tdsOverlapMs[0]))
+
+
+/// Gives the tests access to the protected members of TDStretch. Pointers to the
+/// members may be formed in the scope of a derived class, and then used with any
+/// TDStretch instance.
+class TDStretchProbe : public TDStretch
+{
+public:
+    static double crossCorr(TDStretch *pTDS, const SAMPLETYPE *mixingPos, const SAMPLETYPE *compare)
+    {
+        double (TDStretch::*calc)(const SAMPLETYPE *, const SAMPLETYPE *) = &TDStretchProbe::calcCrossCorr;
+        void (TDStretch::*clear)() = &TDStretchProbe::clearCrossCorrState;
+        double corr;
+
+        corr = (pTDS->*calc)(mixingPos, compare);
+        (pTDS->*clear)();
+        return corr;
+    }
+
+    static void mix(const TDStretch *pTDS, SAMPLETYPE *output, const SAMPLETYPE *input)
+    {
+        void (TDStretch::*func)(SAMPLETYPE *, const SAMPLETYPE *) const = &TDStretchProbe::overlapMix;
+
+        (pTDS->*func)(output, input);
+    }
+
+    static SAMPLETYPE *midBuffer(TDStretch *pTDS)
+    {
+        SAMPLETYPE *TDStretch::*member = &TDStretchProbe::pMidBuffer;
+
+        return pTDS->*member;
+    }
+
+    static int seekBestPosition(TDStretch *pTDS, const SAMPLETYPE *refPos)
+    {
+        int (TDStretch::*seek)(const SAMPLETYPE *) = &TDStretchProbe::seekBestOverlapPosition;
+
+        return (pTDS->*seek)(refPos);
+    }
+
+    static int getSeekLength(const TDStretch *pTDS)
+    {
+        int TDStretch::*member = &TDStretchProbe::seekLength;
+
+        return pTDS->*member;
+    }
+
+    static int getOverlapLength(const TDStretch *pTDS)
+    {
+        int TDStretch::*member = &TDStretchProbe::overlapLength;
+
+        return pTDS->*member;
+    }
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    static int getDividerBits(const TDStretch *pTDS)
+    {
+        int TDStretch::*member = &TDStretchProbe::overlapDividerBitsNorm;
+
+        return pTDS->*member;
+    }
+#endif
+};
+
+
+// Transposes the test sine with rate changes, and checks the output continuity.
+// Returns the number of failed checks.
+static int testRateChanges(TransposerBase::ALGORITHM algorithm, const char *name, int channels)
+{
+    RateTransposer *pTransposer;
+    SAMPLETYPE *src;
+    SAMPLETYPE *dest;
+    double maxStep, maxLevel, minLevel;
+    double prev[2];
+    double peak;
+    uint numInput, numOutput;
+    int r, c;
+    int failures;
+
+    TransposerBase::setAlgorithm(algorithm);
+    pTransposer = new RateTransposer;
+    pTransposer->setChannels(channels);
+
+    src = new SAMPLETYPE[BATCH_FRAMES * channels];
+    dest = new SAMPLETYPE[4 * BATCH_FRAMES * channels];
+
+    maxStep = 0;
+    maxLevel = 0;
+    minLevel = 2 * SINE_AMPLITUDE;
+    peak = 0;
+    numInput = 0;
+    numOutput = 0;
+    prev[0] = prev[1] = 0;
+
+    for (r = 0; r < (int)NUM_RATES; r ++)
+    {
+        pTransposer->setRate(testRates[r]);
+        while (numInput < (uint)(r + 1) * FRAMES_PER_RATE)
+        {
+            uint i, n;
+
+            for (i = 0; i < BATCH_FRAMES; i ++, numInput ++)
+            {
+                double value = SINE_AMPLITUDE * sin(2 * PI * numInput / SINE_PERIOD);
+
+                for (c = 0; c < channels; c ++)
+                {
+                    src[i * channels + c] = (SAMPLETYPE)value;
+                }
+            }
+            pTransposer->putSamples(src, BATCH_FRAMES);
+
+            n = pTransposer->receiveSamples(dest, 4 * BATCH_FRAMES);
+            for (i = 0; i < n; i ++, numOutput ++)
+            {
+                for (c = 0; c < channels; c ++)
+                {
+                    double value = (double)dest[i * channels + c];
+
+                    if (numOutput >= SETTLE_FRAMES)
+                    {
+                        double step = fabs(value - prev[c]);
+                        if (step > maxStep) maxStep = step;
+                    }
+                    prev[c] = value;
+                }
+
+                // peak level over windows of '2 * SINE_PERIOD' output sample frames,
+                // which cover at least one period of the output sine with rate >= 0.5
+                if (fabs(prev[0]) > peak) peak = fabs(prev[0]);
+                if ((numOutput % (2 * SINE_PERIOD)) == 2 * SINE_PERIOD - 1)
+                {
+                    if (numOutput >= SETTLE_FRAMES)
+                    {
+                        if (peak > maxLevel) maxLevel = peak;
+                        if (peak < minLevel) minLevel = peak;
+                    }
+                    peak = 0;
+                }
+            }
+        }
+    }
+
+    // the sine changes at most by 2 * PI * amplitude / period per input sample
+    // frame, and the output steps are 'rate' <= 1 input sample frames apart
+    failures = 0;
+    if (maxStep > 2 * PI * SINE_AMPLITUDE / SINE_PERIOD + STEP_TOLERANCE)
+    {
+        failures ++;
+    }
+    if ((maxLevel > SINE_AMPLITUDE + LEVEL_TOLERANCE) || (minLevel < SINE_AMPLITUDE - LEVEL_TOLERANCE))
+    {
+        failures ++;
+    }
+
+    printf("%-10s %d ch: max step %6.1f, peak level %7.1f .. %7.1f  %s\n", name, channels,
+           maxStep, minLevel, maxLevel, failures ? "FAILED" : "ok");
+
+    delete pTransposer;
+    delete[] src;
+    delete[] dest;
+    return failures;
+}
+
+
+// Filters random input with random filter coefficients with the FFT convolution
+// and the plain C direct-form version, and compares the outputs. Returns the 
+// number of failed checks.
+static int testFIRFilterFFT(uint length, uint channels)
+{
+    FIRFilter *pDirect;
+    FIRFilter *pFFT;
+    SAMPLETYPE *coeffs;
+    SAMPLETYPE *src;
+    SAMPLETYPE *destDirect;
+    SAMPLETYPE *destFFT;
+    uint numSamples, numDirect, numFFT, i;
+    double maxDiff;
+    int failures;
+
+    // coefficients in scale of 2^14, with the sum of their magnitudes below 2^14 
+    // so that the output doesn't saturate
+    coeffs = new SAMPLETYPE[length];
+    for (i = 0; i < length; i ++)
+    {
+        coeffs[i] = (SAMPLETYPE)(rand() % (32768 / (int)length) - 16384 / (int)length);
+    }
+
+    numSamples = FIR_TEST_FRAMES + length;
+    src = new SAMPLETYPE[numSamples * channels];
+    destDirect = new SAMPLETYPE[numSamples * channels];
+    destFFT = new SAMPLETYPE[numSamples * channels];
+    for (i = 0; i < numSamples * channels; i ++)
+    {
+        src[i] = (SAMPLETYPE)(rand() % (2 * FIR_TEST_AMPLITUDE + 1) - FIR_TEST_AMPLITUDE);
+    }
+
+    // plain C direct-form version as the reference
+    disableExtensions(~0U);
+    pDirect = FIRFilter::newInstance();
+    disableExtensions(0);
+    pDirect->setCoefficients(coeffs, length, 14);
+
+    // FFT convolution for all the channel counts, regardless of the CPU specific
+    // thresholds of 'FIRFilter::newInstance'
+    pFFT = ::new FIRFilterFFT;
+    pFFT->setCoefficients(coeffs, length, 14);
+
+    numDirect = pDirect->evaluate(destDirect, src, numSamples, channels);
+    numFFT = pFFT->evaluate(destFFT, src, numSamples, channels);
+
+    maxDiff = 0;
+    for (i = 0; i < numDirect * channels; i ++)
+    {
+        double diff = fabs((double)destDirect[i] - (double)destFFT[i]);
+        if (diff > maxDiff) maxDiff = diff;
+    }
+
+    failures = 0;
+    if ((numFFT != numDirect) || (maxDiff > FIR_TOLERANCE))
+    {
+        failures ++;
+    }
+
+    printf("%4d taps %d ch: max difference %8.4f  %s\n", length, channels, maxDiff, 
+           failures ? "FAILED" : "ok");
+
+    delete pDirect;
+    delete pFFT;
+    delete[] coeffs;
+    delete[] src;
+    delete[] destDirect;
+    delete[] destFFT;
+    return failures;
+}
+
+
+// Returns a random sample value of the TDStretch kernel tests
+static SAMPLETYPE randomSample()
+{
+    return (SAMPLETYPE)(rand() % (2 * TDS_TEST_AMPLITUDE + 1) - TDS_TEST_AMPLITUDE);
+}
+
+
+// Compares the cross-correlation & overlap-mix routines of the TDStretch version 
+// 'version' with the plain C version, with 'channels' channels and the overlap
+// length given by 'overlapMs' & 'sampleRate'. Returns the number of failed checks.
+static int testTDStretchKernels(const TDSVERSION &version, int channels, int sampleRate, int overlapMs)
+{
+    TDStretch *pRef;
+    TDStretch *pTest;
+    SAMPLETYPE *bufferUnaligned;
+    SAMPLETYPE *mixing;
+    SAMPLETYPE *compare;
+    SAMPLETYPE *input;
+    SAMPLETYPE *outRef;
+    SAMPLETYPE *outTest;
+    double corrDiff, mixDiff;
+    bool guardOk;
+    int count, stride, i, offset, failures;
+
+    disableExtensions(~0U);
+    pRef = TDStretch::newInstance();
+    disableExtensions(version.disable);
+    pTest = TDStretch::newInstance();
+    disableExtensions(0);
+
+    pRef->setChannels(channels);
+    pRef->setParameters(sampleRate, 0, 0, overlapMs);
+    pTest->setChannels(channels);
+    pTest->setParameters(sampleRate, 0, 0, overlapMs);
+    assert(TDStretchProbe::getOverlapLength(pRef) == TDStretchProbe::getOverlapLength(pTest));
+    count = channels * TDStretchProbe::getOverlapLength(pRef);
+
+    // one extra item in the buffers for testing unaligned positions. The buffers 
+    // begin at 16-byte aligned addresses, as 'pMidBuffer' that 'compare' stands for.
+    stride = (count + 1 + TDS_GUARD_ITEMS + 15) & ~15;
+    bufferUnaligned = new SAMPLETYPE[5 * stride + 16];
+    mixing = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(bufferUnaligned);
+    compare = mixing + stride;
+    input = compare + stride;
+    outRef = input + stride;
+    outTest = outRef + stride;
+
+    for (i = 0; i < count + 1; i ++)
+    {
+        mixing[i] = randomSample();
+        compare[i] = randomSample();
+        input[i] = randomSample();
+    }
+    for (i = 0; i < count; i ++)
+    {
+        SAMPLETYPE value = randomSample();
+
+        TDStretchProbe::midBuffer(pRef)[i] = value;
+        TDStretchProbe::midBuffer(pTest)[i] = value;
+    }
+
+    failures = 0;
+    corrDiff = 0;
+    mixDiff = 0;
+    guardOk = true;
+
+    // aligned and unaligned mixing position
+    for (offset = 0; offset <= 1; offset ++)
+    {
+        double corrRef, corrTest, sumAbs, tolerance;
+
+        if ((offset > 0) && version.alignedOnly) break;
+
+        corrRef = TDStretchProbe::crossCorr(pRef, mixing + offset, compare);
+        corrTest = TDStretchProbe::crossCorr(pTest, mixing + offset, compare);
+
+        sumAbs = 0;
+        for (i = 0; i < count; i ++)
+        {
+            sumAbs += fabs((double)mixing[i + offset] * (double)compare[i]);
+        }
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+        // the C & MMX versions shift the sums of product pairs right by the
+        // normalizer bits, dropping less than 2^bits from each pair sum
+        tolerance = (double)(count / 2) * (double)(1 << TDStretchProbe::getDividerBits(pRef));
+#else
+        // the SIMD versions accumulate in single precision
+        tolerance = 1e-5 * sumAbs;
+#endif
+        if (fabs(corrTest - corrRef) > tolerance)
+        {
+            failures ++;
+        }
+        if (fabs(corrTest - corrRef) / sumAbs > corrDiff) corrDiff = fabs(corrTest - corrRef) / sumAbs;
+
+        for (i = 0; i < count + TDS_GUARD_ITEMS; i ++)
+        {
+            outRef[i] = outTest[i] = (SAMPLETYPE)TDS_GUARD_VALUE;
+        }
+        TDStretchProbe::mix(pRef, outRef + offset, input + offset);
+        TDStretchProbe::mix(pTest, outTest + offset, input + offset);
+        for (i = 0; i < offset + count; i ++)
+        {
+            double diff = fabs((double)outRef[i] - (double)outTest[i]);
+            if (diff > mixDiff) mixDiff = diff;
+        }
+        for (; i < count + TDS_GUARD_ITEMS; i ++)
+        {
+            if (outTest[i] != (SAMPLETYPE)TDS_GUARD_VALUE) guardOk = false;
+        }
+    }
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    // the fixed-point mix is exact
+    if (mixDiff > 0) failures ++;
+#else
+    // the SIMD versions may use fused multiply-add
+    if (mixDiff > 1e-6 * 2 * TDS_TEST_AMPLITUDE) failures ++;
+#endif
+    if (guardOk == false) failures ++;
+
+    printf("%-8s %d ch %4d items: corr rel. diff %.1e, mix diff %.1e%s  %s\n", version.name, channels, 
+           count, corrDiff, mixDiff, guardOk ? "" : ", wrote past the end", failures ? "FAILED" : "ok");
+
+    delete pRef;
+    delete pTest;
+    delete[] bufferUnaligned;
+    return failures;
+}
+
+
+// Seeks the overlap position with the full & FFT-based seek of the TDStretch 
+// version 'version' for mixing data of lowpass-filtered noise and a reference 
+// copied from a random position of the mixing data with some noise added, and 
+// checks that both find the same position. The only permitted difference is 
+// that the full search of an 'alignedOnly' version skips the positions that 
+// aren't 16-byte aligned, while the FFT seek evaluates them all. Returns the 
+// number of failed checks.
+static int testSeekFFT(const TDSVERSION &version, int channels)
+{
+    TDStretch *pFull;
+    TDStretch *pFFT;
+    SAMPLETYPE *bufferUnaligned;
+    SAMPLETYPE *refPos;
+    double value;
+    int seekLength, ovlLength, refLength;
+    int round, i, target, posFull, posFFT;
+    int failures, skipped;
+
+    disableExtensions(version.disable);
+    pFull = TDStretch::newInstance();
+    pFFT = TDStretch::newInstance();
+    disableExtensions(0);
+
+    pFull->setChannels(channels);
+    pFull->setParameters(44100);
+    pFull->setSeekMode(TDStretch::SEEK_FULL);
+    pFFT->setChannels(channels);
+    pFFT->setParameters(44100);
+    pFFT->setSeekMode(TDStretch::SEEK_FFT);
+
+    seekLength = TDStretchProbe::getSeekLength(pFull);
+    ovlLength = channels * TDStretchProbe::getOverlapLength(pFull);
+    refLength = channels * (seekLength - 1) + ovlLength;
+
+    bufferUnaligned = new SAMPLETYPE[refLength + 16];
+    refPos = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(bufferUnaligned);
+
+    failures = 0;
+    skipped = 0;
+    for (round = 0; round < SEEK_TEST_ROUNDS; round ++)
+    {
+        // one-pole lowpass filtered noise, so that the neighbouring positions 
+        // correlate like with real sound
+        value = 0;
+        for (i = 0; i < refLength; i ++)
+        {
+            value = 0.8 * value + 0.2 * (double)randomSample();
+            refPos[i] = (SAMPLETYPE)(4.0 * value);
+        }
+
+        target = rand() % seekLength;
+        for (i = 0; i < ovlLength; i ++)
+        {
+            SAMPLETYPE sample = refPos[channels * target + i] + 
+                                (SAMPLETYPE)(rand() % (2 * SEEK_NOISE_AMPLITUDE + 1) - SEEK_NOISE_AMPLITUDE);
+
+            TDStretchProbe::midBuffer(pFull)[i] = sample;
+            TDStretchProbe::midBuffer(pFFT)[i] = sample;
+        }
+
+        posFull = TDStretchProbe::seekBestPosition(pFull, refPos);
+        posFFT = TDStretchProbe::seekBestPosition(pFFT, refPos);
+
+        if (posFull != posFFT)
+        {
+            // permitted if the full search skipped the position found by the FFT 
+            // seek, and found an aligned one instead
+            if (version.alignedOnly && (((ulongptr)(refPos + channels * posFFT)) & 15) &&
+                ((((ulongptr)(refPos + channels * posFull)) & 15) == 0))
+            {
+                skipped ++;
+            }
+            else
+            {
+                failures ++;
+            }
+        }
+    }
+
+    printf("%-8s %d ch: %d of %d positions differ at skipped unaligned positions  %s\n", 
+           version.name, channels, skipped, SEEK_TEST_ROUNDS, failures ? "FAILED" : "ok");
+
+    delete pFull;
+    delete pFFT;
+    delete[] bufferUnaligned;
+    return failures;
+}
+
+
+int main()
+{
+    const char *algorithmNames[] = {"linear", "cubic", "shannon"};
+    const uint channelCounts[] = {1, 2, 6};
+    int failures = 0;
+    int a, channels;
+    uint length, c, v, o;
+
+    printf("Rate changes across transposer paths\n\n");
+    for (a = 0; a < (int)(sizeof(algorithmNames) / sizeof(algorithmNames[0])); a ++)
+    {
+        for (channels = 1; channels <= 2; channels ++)
+        {
+            failures += testRateChanges((TransposerBase::ALGORITHM)a, algorithmNames[a], channels);
+        }
+    }
+
+    printf("\nFFT convolution vs. direct-form FIR filter\n\n");
+    for (length = 256; length <= 1024; length *= 2)
+    {
+        for (c = 0; c < sizeof(channelCounts) / sizeof(channelCounts[0]); c ++)
+        {
+            failures += testFIRFilterFFT(length, channelCounts[c]);
+        }
+    }
+
+    printf("\nTDStretch kernels vs. plain C version\n\n");
+    for (v = 0; v < NUM_TDS_VERSIONS; v ++)
+    {
+        const TDSVERSION &version = tdsVersions[v];
+
+        disableExtensions(version.disable);
+        if ((detectCPUextensions() & version.require) != version.require)
+        {
+            printf("%-8s not supported by the CPU, skipped\n", version.name);
+            continue;
+        }
+        for (c = 0; c < sizeof(channelCounts) / sizeof(channelCounts[0]); c ++)
+        {
+            for (o = 0; o < NUM_TDS_OVERLAPS; o ++)
+            {
+                failures += testTDStretchKernels(version, channelCounts[c], tdsSampleRates[o], tdsOverlapMs[o]);
+            }
+        }
+    }
+    disableExtensions(0);
+
+    printf("\nFFT seek vs. full seek\n\n");
+    for (v = 0; v < NUM_TDS_VERSIONS; v ++)
+    {
+        const TDSVERSION &version = tdsVersions[v];
+
+        disableExtensions(version.disable);
+        if ((detectCPUextensions() & version.require) != version.require)
+        {
+            printf("%-8s not supported by the CPU, skipped\n", version.name);
+            continue;
+        }
+        for (channels = 1; channels <= 2; channels ++)
+        {
+            failures += testSeekFFT(version, channels);
+        }
+    }
+    disableExtensions(0);
+
+    printf("\n%s\n", failures ? "FAILED" : "All tests passed");
+    return failures ? 1 : 0;
+}